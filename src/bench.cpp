@@ -0,0 +1,41 @@
+#include "bench.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "transposition_table.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+const std::array<const char*, 6> Bench::BENCH_FENS = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+BenchResult Bench::run(int depth, std::ostream& out) {
+	BenchResult result{0, 0, 0, 0, 0};
+	for (const char* fen : BENCH_FENS) {
+		TranspositionTable::shared().reset();
+		SearchContext ctx;
+		ctx.deterministic = true;
+		Board b;
+		b.setToFen(fen);
+		Moves topLine;
+
+		auto start = std::chrono::steady_clock::now();
+		Eval::iterative_deepening_ply(ctx, topLine, b, depth);
+		result.elapsedMs += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		result.nodes += ctx.nodes + ctx.qnodes;
+		result.qnodes += ctx.qnodes;
+		result.lazyEvals += ctx.lazyEvals;
+
+		out << fen << ": " << (ctx.nodes + ctx.qnodes) << " nodes, bestmove " << (topLine.empty() ? std::string("0000") : topLine[0].UCInotation()) << "\n";
+	}
+	result.nps = result.nodes * 1000 / std::max<int64_t>(result.elapsedMs, 1);
+	out << "lazy evals: " << result.lazyEvals << " of " << result.qnodes << " quiescence nodes\n";
+	out << "bench depth " << depth << ": " << result.nodes << " nodes " << result.elapsedMs << " ms " << result.nps << " nps" << std::endl;
+	return result;
+}
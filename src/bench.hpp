@@ -0,0 +1,43 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+
+/**
+* @brief totals of a bench run
+*/
+struct BenchResult {
+	uint64_t nodes;
+	int64_t elapsedMs;
+	uint64_t nps;
+
+	/**
+	* @brief quiescence nodes, each of which evaluates the position once, and how many of those evaluations exited lazily
+	*/
+	uint64_t qnodes;
+	uint64_t lazyEvals;
+};
+
+/**
+* @brief searches a fixed set of positions to a fixed depth, in deterministic mode and from an empty transposition table,
+* so the node count is the same on every machine and only changes when the search or evaluation does. used to compare
+* speed (nps) between builds and evaluators, e.g. with and without a net loaded
+*/
+class Bench {
+public:
+	static constexpr int DEFAULT_DEPTH = 8;
+
+	/**
+	* @brief runs the bench, writing one line per position and the totals to out
+	*/
+	static BenchResult run(int depth, std::ostream& out);
+
+private:
+	/**
+	* @brief opening, middlegame and endgame positions, a few tactical
+	*/
+	static const std::array<const char*, 6> BENCH_FENS;
+};
+#endif
@@ -3,18 +3,29 @@
 #include "util.hpp"
 #include "zobrist.hpp"
 
+#include <algorithm>
+
 Board::Board() {
 	m_previousBoardStates.reserve(999);
+	m_hashHistory.reserve(999);
 	boardState.hash					 = Zobrist::initialHash();
 	boardState.allColorPieces[WHITE] = firstRank | secondRank;
 	boardState.allColorPieces[BLACK] = seventhRank | eighthRank;
+	computePieceScores();
+	refreshAccumulator();
 }
 
-Board::Board(const Board& other) : boardState(other.boardState), moveGenerator(*this) {}
+Board::Board(const Board& other) : boardState(other.boardState), moveGenerator(*this), m_hashHistory(other.m_hashHistory) {
+	// the copy has no board states to replay pending updates from, so it starts from a fresh accumulator
+	if (!other.m_accumulators.empty()) refreshAccumulator();
+}
 
 Board& Board::operator=(const Board& other) {
 	if (this != &other) {
-		boardState = other.boardState;
+		boardState	  = other.boardState;
+		m_hashHistory = other.m_hashHistory;
+		m_accumulators.clear();
+		if (!other.m_accumulators.empty()) refreshAccumulator();
 		moveGenerator.~MoveGen();
 		new (&moveGenerator) MoveGen(*this);
 	}
@@ -51,7 +62,9 @@ void Board::setToFen(const char* fen) {
 	 * heres a fen string for reference:
 	 * r1bk1bnr/p1p2ppp/1pnp4/1B2p3/4P2q/P1N2N1P/1PPP1PP1/R1BQK2R w KQ - 0 7
 	 */
-	// clear board
+	// clear board and history
+	m_previousBoardStates.clear();
+	m_hashHistory.clear();
 	for (Color color : {WHITE, BLACK}) {
 		for (Piece piece : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
 			boardState.pieces[color][piece] = 0;
@@ -113,6 +126,80 @@ void Board::setToFen(const char* fen) {
 	boardState.hash					 = Zobrist::hash(boardState);
 	boardState.allColorPieces[WHITE] = boardState.pieces[WHITE][PAWN] | boardState.pieces[WHITE][KNIGHT] | boardState.pieces[WHITE][BISHOP] | boardState.pieces[WHITE][ROOK] | boardState.pieces[WHITE][QUEEN] | boardState.pieces[WHITE][KING];
 	boardState.allColorPieces[BLACK] = boardState.pieces[BLACK][PAWN] | boardState.pieces[BLACK][KNIGHT] | boardState.pieces[BLACK][BISHOP] | boardState.pieces[BLACK][ROOK] | boardState.pieces[BLACK][QUEEN] | boardState.pieces[BLACK][KING];
+	computePieceScores();
+	refreshAccumulator();
+}
+
+bool Board::validPlacement(const std::string& placement) {
+	int rank = 0, file = 0, whiteKings = 0, blackKings = 0;
+	for (char c : placement) {
+		if (c == '/') {
+			if (file != 8) return false;
+			rank++;
+			file = 0;
+		} else if (c >= '1' && c <= '8') {
+			file += c - '0';
+		} else if (std::string("KQRBNPkqrbnp").find(c) != std::string::npos) {
+			whiteKings += c == 'K';
+			blackKings += c == 'k';
+			file++;
+		} else {
+			return false;
+		}
+		if (file > 8) return false;
+	}
+	return rank == 7 && file == 8 && whiteKings == 1 && blackKings == 1;
+}
+
+void Board::computePieceScores() {
+	boardState.mgScore	   = 0;
+	boardState.egScore	   = 0;
+	boardState.phase	   = 0;
+	boardState.materialKey = 0;
+	for (Color color : {WHITE, BLACK}) {
+		for (Piece piece : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+			Bitboard pieces = boardState.pieces[color][piece];
+			while (pieces) {
+				addPieceScores(color, piece, bitscan(pieces));
+				removeLS1B(pieces);
+			}
+		}
+	}
+}
+
+void Board::refreshAccumulator() {
+	m_accumulators.clear();
+	if (NNUE::isLoaded()) {
+		m_accumulators.emplace_back();
+		NNUE::refresh(boardState.pieces, m_accumulators.back().acc);
+		m_accumulators.back().computed = true;
+	}
+}
+
+void Board::dropAccumulators() {
+	m_accumulators.clear();
+}
+
+const NNUE::Accumulator* Board::accumulator() {
+	if (m_accumulators.empty()) return nullptr;
+	int top = m_accumulators.size() - 1;
+	// accumulator i belongs to the position offset + i plies into the board state history, the last one to the current board state
+	int offset	  = m_previousBoardStates.size() - top;
+	auto piecesAt = [&](int i) -> const NNUE::PieceBitboards& {
+		return i == top ? boardState.pieces : m_previousBoardStates[offset + i].pieces;
+	};
+
+	int computed = top;
+	while (computed > 0 && !m_accumulators[computed].computed) computed--;
+	if (!m_accumulators[computed].computed) {
+		NNUE::refresh(piecesAt(computed), m_accumulators[computed].acc);
+		m_accumulators[computed].computed = true;
+	}
+	for (int i = computed + 1; i <= top; i++) {
+		NNUE::update(piecesAt(i), m_accumulators[i].dirty, m_accumulators[i - 1].acc, m_accumulators[i].acc);
+		m_accumulators[i].computed = true;
+	}
+	return &m_accumulators[top].acc;
 }
 
 bool Board::inIllegalCheck() {
@@ -164,19 +251,43 @@ bool Board::isInsufficientMaterial() const {
 	return bishopsOnLightSquares != bishopsOnDarkSquares;
 }
 
+int Board::countRepetitions(int maxCount) const {
+	int count	   = 0;
+	int historyLen = m_hashHistory.size();
+	int lastPly	   = std::min<int>(boardState.hmClock, historyLen);
+	// the same side has to be to move, and it takes at least 4 plies to get back to a position
+	for (int ply = 4; ply <= lastPly; ply += 2) {
+		if (m_hashHistory[historyLen - ply] == boardState.hash && ++count >= maxCount) {
+			break;
+		}
+	}
+	return count;
+}
+
+bool Board::isRepetition() const {
+	return countRepetitions(1) >= 1;
+}
+
+bool Board::isThreefoldRepetition() const {
+	return countRepetitions(2) >= 2;
+}
+
 bool Board::isGameOver() {
-	return is50MoveRule() || isInsufficientMaterial() || !moveGenerator.hasLegalMoves();
+	return is50MoveRule() || isInsufficientMaterial() || isThreefoldRepetition() || !moveGenerator.hasLegalMoves();
 }
 
 void Board::execute(const Move& m) {
 	m_previousBoardStates.push_back(boardState);
-	MoveFlag flags = m.getFlags();
+	m_hashHistory.push_back(boardState.hash);
+	MoveFlag flags	 = m.getFlags();
+	Piece captured	 = NONE_PIECE;
 
 	if (boardState.enPassantSquare) {
 		boardState.hash ^= Zobrist::epFileKeys[bitscan(boardState.enPassantSquare) % 8];
 	}
 	boardState.hash ^= Zobrist::castlingKeys[boardState.castlingRights.rights];
 	boardState.hash ^= Zobrist::pieceKeys[(boardState.sideToMove == BLACK ? 6 : 0) + m.getPieceType()][m.getFrom()];
+	removePieceScores(boardState.sideToMove, m.getPieceType(), m.getFrom());
 
 	if (flags & KS_CASTLE) {
 		if (boardState.sideToMove == WHITE) {
@@ -184,11 +295,17 @@ void Board::execute(const Move& m) {
 			boardState.pieces[WHITE][ROOK] ^= 0xa0;
 			boardState.allColorPieces[WHITE] ^= 0x50;
 			boardState.allColorPieces[WHITE] ^= 0xa0;
+			boardState.hash ^= Zobrist::pieceKeys[ROOK][h1] ^ Zobrist::pieceKeys[ROOK][f1];
+			removePieceScores(WHITE, ROOK, h1);
+			addPieceScores(WHITE, ROOK, f1);
 		} else {
 			boardState.pieces[BLACK][KING] ^= 0x5000000000000000;
 			boardState.pieces[BLACK][ROOK] ^= 0xa000000000000000;
 			boardState.allColorPieces[BLACK] ^= 0x5000000000000000;
 			boardState.allColorPieces[BLACK] ^= 0xa000000000000000;
+			boardState.hash ^= Zobrist::pieceKeys[6 + ROOK][h8] ^ Zobrist::pieceKeys[6 + ROOK][f8];
+			removePieceScores(BLACK, ROOK, h8);
+			addPieceScores(BLACK, ROOK, f8);
 		}
 	} else if (flags & QS_CASTLE) {
 		if (boardState.sideToMove == WHITE) {
@@ -196,11 +313,17 @@ void Board::execute(const Move& m) {
 			boardState.pieces[WHITE][ROOK] ^= 0x9;
 			boardState.allColorPieces[WHITE] ^= 0x14;
 			boardState.allColorPieces[WHITE] ^= 0x9;
+			boardState.hash ^= Zobrist::pieceKeys[ROOK][a1] ^ Zobrist::pieceKeys[ROOK][d1];
+			removePieceScores(WHITE, ROOK, a1);
+			addPieceScores(WHITE, ROOK, d1);
 		} else {
 			boardState.pieces[BLACK][KING] ^= 0x1400000000000000;
 			boardState.pieces[BLACK][ROOK] ^= 0x900000000000000;
 			boardState.allColorPieces[BLACK] ^= 0x1400000000000000;
 			boardState.allColorPieces[BLACK] ^= 0x900000000000000;
+			boardState.hash ^= Zobrist::pieceKeys[6 + ROOK][a8] ^ Zobrist::pieceKeys[6 + ROOK][d8];
+			removePieceScores(BLACK, ROOK, a8);
+			addPieceScores(BLACK, ROOK, d8);
 		}
 	} else {
 		if (flags & CAPTURE) {
@@ -211,6 +334,8 @@ void Board::execute(const Move& m) {
 				boardState.pieces[!boardState.sideToMove][PAWN] &= ~(1UL << (capturedPawnSquare));
 				boardState.allColorPieces[!boardState.sideToMove] &= ~(1UL << (capturedPawnSquare));
 				boardState.material += boardState.sideToMove == WHITE ? 100 : -100;
+				removePieceScores((Color)!boardState.sideToMove, PAWN, capturedPawnSquare);
+				captured = PAWN;
 			} else {
 				for (Piece p : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
 					auto& theirPieces = boardState.pieces[!boardState.sideToMove];
@@ -219,6 +344,8 @@ void Board::execute(const Move& m) {
 						boardState.allColorPieces[!boardState.sideToMove] &= ~(1UL << m.getTo());
 						boardState.hash ^= Zobrist::pieceKeys[(boardState.sideToMove == WHITE ? 6 : 0) + p][m.getTo()];
 						boardState.material += (boardState.sideToMove == WHITE ? 1 : -1) * pieceToCentipawns[p];
+						removePieceScores((Color)!boardState.sideToMove, p, m.getTo());
+						captured = p;
 						break;
 					}
 				}
@@ -238,25 +365,39 @@ void Board::execute(const Move& m) {
 			boardState.allColorPieces[boardState.sideToMove] |= 1UL << m.getTo();
 			boardState.hash ^= Zobrist::pieceKeys[(boardState.sideToMove == BLACK ? 6 : 0) + PAWN][m.getTo()];
 			boardState.hash ^= Zobrist::pieceKeys[(boardState.sideToMove == BLACK ? 6 : 0) + m.getPromoPiece()][m.getTo()];
+			removePieceScores(boardState.sideToMove, PAWN, m.getTo());
+			addPieceScores(boardState.sideToMove, m.getPromoPiece(), m.getTo());
 		}
 	}
 
-	updateBoardStateGameData(m);
+	// the piece arrives on its destination square before the side to move gets flipped
 	boardState.hash ^= Zobrist::pieceKeys[(boardState.sideToMove == BLACK ? 6 : 0) + m.getPieceType()][m.getTo()];
+	addPieceScores(boardState.sideToMove, m.getPieceType(), m.getTo());
+	updateBoardStateGameData(m);
+
+	if (!m_accumulators.empty()) {
+		m_accumulators.emplace_back();
+		m_accumulators.back().dirty	   = NNUE::dirtyPieces((Color)!boardState.sideToMove, m, captured);
+		m_accumulators.back().computed = false;
+	}
 }
 
 void Board::undoMove() {
 	BoardState bs = m_previousBoardStates.back();
 	m_previousBoardStates.pop_back();
+	m_hashHistory.pop_back();
+	if (m_accumulators.size() > 1) {
+		m_accumulators.pop_back();
+	} else if (!m_accumulators.empty()) {
+		// the net was loaded after this move was played, so there is nothing to go back to. recomputed on the next call to accumulator
+		m_accumulators.back().computed = false;
+	}
 	boardState = bs;
 }
 
 void Board::updateBoardStateGameData(const Move& m) {
 	MoveFlag flags = m.getFlags();
-	[[unlikely]]
-	if (boardState.enPassantSquare) {
-		boardState.hash ^= Zobrist::epFileKeys[bitscan(boardState.enPassantSquare) % 8];
-	}
+	// the old en passant file was already hashed out at the start of execute
 	// branchlessly increments fmClock if sideToMove == BLACK
 	boardState.fmClock += 1 & -boardState.sideToMove;
 	// branchlessly resets hmClock if flags & PAWN_MOVE | CAPTURE else increments
@@ -298,4 +439,6 @@ void Board::reset() {
 	boardState.pieces[BLACK][BISHOP] = 0x2400000000000000;
 	boardState.pieces[BLACK][KNIGHT] = 0x4200000000000000;
 	boardState.pieces[BLACK][PAWN]	 = 0xff000000000000;
+	computePieceScores();
+	refreshAccumulator();
 }
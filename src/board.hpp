@@ -6,7 +6,9 @@
 #include <vector>
 
 #include "consts.hpp"
+#include "eval_params.hpp"
 #include "move_gen.hpp"
+#include "nnue.hpp"
 
 class Move;
 
@@ -133,6 +135,21 @@ public:
 		*/
 		Centipawns material = 0;
 		/**
+		* @brief material plus piece square values with the middlegame and endgame weights, positive if white is better. kept up to date in execute,
+		* so evaluate only has to blend the two by phase
+		*/
+		Centipawns mgScore = 0;
+		Centipawns egScore = 0;
+		/**
+		* @brief sum of EvalParams::phaseWeights over the pieces on the board. can go above MAX_PHASE after promotions
+		*/
+		int phase = 0;
+		/**
+		* @brief piece counts of the position as a sum of materialKeyOf, kept up to date next to the piece scores. the key endgame
+		* evaluators and tablebases are looked up by
+		*/
+		MaterialKey materialKey = 0;
+		/**
 		* @brief full move clock. number of full moves, starts at 1, gets incremented every time black moves
 		*/
 		unsigned int fmClock = 1;
@@ -188,6 +205,12 @@ public:
 	*/
 	void setToFen(const char* fen);
 
+	/**
+	* @brief checks the piece placement field of a fen: 8 ranks of 8 squares and one king per side. setToFen trusts its input, so
+	* fens read from files go through this first
+	*/
+	static bool validPlacement(const std::string& placement);
+
 	/**
 	* @brief execute move by adding current boardState to previousBoardStates and updating the current boardState
 	*/
@@ -218,17 +241,121 @@ public:
 	*/
 	bool isInsufficientMaterial() const;
 
+	/**
+	* @brief checks whether or not the current position has occurred before. only positions since the last capture or pawn move with the same side to move can match, so the scan steps back two plies at a time and stops after hmClock plies
+	*/
+	bool isRepetition() const;
+
+	/**
+	* @brief checks whether or not the game is a draw by the current position occurring for the third time
+	*/
+	bool isThreefoldRepetition() const;
+
 	/**
 	* @brief checks whether or not the game is over
 	*/
 	bool isGameOver();
 
+	/**
+	* @brief nnue accumulator of the current position, nullptr if no net was loaded when the position was set up.
+	* applies the updates of any moves played since the last call first
+	*/
+	const NNUE::Accumulator* accumulator();
+
+	/**
+	* @brief recomputes the accumulator of the current position from scratch, or drops the accumulators if no net is loaded. call after loading a net
+	*/
+	void refreshAccumulator();
+
+	/**
+	* @brief drops the accumulators, so the position is evaluated with the handcrafted terms even though a net is loaded, until the
+	* next refreshAccumulator. lets a match play the net against the handcrafted evaluation in the same process
+	*/
+	void dropAccumulators();
+
+	/**
+	* @brief computes mgScore, egScore, phase and materialKey from scratch
+	*/
+	void computePieceScores();
+
 private:
 	/**
 	* @brief stack of historical board states
 	*/
 	std::vector<BoardState> m_previousBoardStates;
 
+	/**
+	* @brief hashes of the historical board states, kept in their own contiguous stack so repetition checks dont have to walk the full board states
+	*/
+	std::vector<ZobristHash> m_hashHistory;
+
+	/**
+	* @brief an accumulator and the move that led to it. execute only records the move, since most positions it is called on
+	* (legality checks, pruned nodes) are never evaluated. the update is applied when accumulator() is called
+	*/
+	struct AccumulatorEntry {
+		// left uninitialized, execute pushes one of these for every move
+		AccumulatorEntry() {}
+
+		NNUE::Accumulator acc;
+		NNUE::DirtyPieces dirty;
+		bool computed;
+	};
+
+	/**
+	* @brief stack of accumulators, one per position like the board states, pushed in execute and popped in undoMove. empty without a net
+	*/
+	std::vector<AccumulatorEntry> m_accumulators;
+
+	/**
+	* @brief counts how many earlier positions match the current one, stopping once maxCount is reached
+	*/
+	int countRepetitions(int maxCount) const;
+
+	/**
+	* @brief middlegame and endgame material plus piece square value of each piece on each square, negative for black
+	*/
+	static constexpr auto s_mgPieceSquare = []() {
+		std::array<std::array<std::array<Centipawns, 64>, NONE_PIECE>, 2> table{};
+		for (int piece = KING; piece < NONE_PIECE; piece++) {
+			for (int sq = 0; sq < 64; sq++) {
+				table[WHITE][piece][sq] = EvalParams::mgPieceValues[piece] + EvalParams::mgPsqt[piece][sq];
+				table[BLACK][piece][sq] = -(EvalParams::mgPieceValues[piece] + EvalParams::mgPsqt[piece][sq ^ 56]);
+			}
+		}
+		return table;
+	}();
+	static constexpr auto s_egPieceSquare = []() {
+		std::array<std::array<std::array<Centipawns, 64>, NONE_PIECE>, 2> table{};
+		for (int piece = KING; piece < NONE_PIECE; piece++) {
+			for (int sq = 0; sq < 64; sq++) {
+				table[WHITE][piece][sq] = EvalParams::egPieceValues[piece] + EvalParams::egPsqt[piece][sq];
+				table[BLACK][piece][sq] = -(EvalParams::egPieceValues[piece] + EvalParams::egPsqt[piece][sq ^ 56]);
+			}
+		}
+		return table;
+	}();
+
+	/**
+	* @brief adds a piece to the incremental eval terms, mgScore, egScore, phase and materialKey
+	*/
+	inline void addPieceScores(Color color, Piece piece, int sq) {
+		boardState.mgScore += s_mgPieceSquare[color][piece][sq];
+		boardState.egScore += s_egPieceSquare[color][piece][sq];
+		boardState.phase += EvalParams::phaseWeights[piece];
+		boardState.materialKey += materialKeyOf(color, piece);
+	};
+
+	/**
+	* @brief removes a piece from the incremental eval terms
+	*/
+	inline void removePieceScores(Color color, Piece piece, int sq) {
+		boardState.mgScore -= s_mgPieceSquare[color][piece][sq];
+		boardState.egScore -= s_egPieceSquare[color][piece][sq];
+		boardState.phase -= EvalParams::phaseWeights[piece];
+		boardState.materialKey -= materialKeyOf(color, piece);
+	};
+
 	/**
 	* @brief updates hmclock, fmclock, ep square, etc.
 	*/
@@ -0,0 +1,97 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "consts.hpp"
+#include "move.hpp"
+
+/**
+* @brief a book move and how often it should be played, relative to the other moves of its position
+*/
+struct BookMove {
+	Move move;
+	uint16_t weight;
+};
+
+/**
+* @brief reader for opening books in the polyglot .bin format: 16 byte big endian entries of key, move, weight and a learn field,
+* sorted by key. the file is memory mapped and searched in place, so a lookup is a binary search over the file with no loading
+* time. open and close must not run while another thread probes
+*/
+class Book {
+public:
+	/**
+	* @brief polyglot key indices: 12 * 64 pieces, then the castling rights, the en passant files and the side to move
+	*/
+	static constexpr int RANDOM_CASTLE		= 768;
+	static constexpr int RANDOM_EN_PASSANT	= 772;
+	static constexpr int RANDOM_TURN		= 780;
+	static constexpr int RANDOM_SIZE		= 781;
+
+	/**
+	* @brief maps the book at path in place of the current one, returns false if it cant be read or isnt a list of entries
+	*/
+	static bool open(const std::string& path);
+
+	/**
+	* @brief unmaps the book, probes return nothing until the next open
+	*/
+	static void close();
+
+	static bool isOpen();
+
+	/**
+	* @brief number of entries in the book
+	*/
+	static size_t size();
+
+	/**
+	* @brief polyglot key of b. it has its own layout, unlike the Zobrist hash: pieces are numbered black pawn, white pawn, black
+	* knight and so on, and the en passant file only counts if a pawn of the side to move stands next to the pawn that moved
+	*/
+	static uint64_t key(const Board& b);
+
+	/**
+	* @brief the legal moves the book has for b, with their weights, in the order of the book
+	*/
+	static std::vector<BookMove> moves(Board& b);
+
+	/**
+	* @brief a book move for b, picked at random with the weights as odds, or the heaviest one if best is set. a null move if b is
+	* out of book
+	*/
+	static Move probe(Board& b, bool best = false);
+
+	/**
+	* @brief polyglot encoding of m: to file and rank, from file and rank and the promotion piece, 3 bits each. castling is written
+	* as the king taking its own rook
+	*/
+	static uint16_t encode(const Move& m);
+
+private:
+	/**
+	* @brief one entry as it is stored, the fields are big endian
+	*/
+	struct Entry {
+		uint8_t key[8];
+		uint8_t move[2];
+		uint8_t weight[2];
+		uint8_t learn[4];
+	};
+	static_assert(sizeof(Entry) == 16);
+
+	/**
+	* @brief random numbers the key is the xor of some of, indexed as described at RANDOM_CASTLE
+	*/
+	static const std::array<uint64_t, RANDOM_SIZE> s_random64;
+
+	static const Entry* s_entries;
+	static size_t s_size;
+	static size_t s_mappedBytes;
+};
+#endif
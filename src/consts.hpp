@@ -13,6 +13,7 @@ using Bitboard	  = uint64_t;
 using Centipawns  = int16_t;
 using MoveScore	  = int16_t;
 using ZobristHash = uint64_t;
+using MaterialKey = uint64_t;
 
 /**
 * @brief counts the number of trailing zeros in binary
@@ -37,9 +38,25 @@ constexpr Centipawns CHECKMATE_SCORE = 30000;
 constexpr Centipawns NONE_SCORE		 = -32001;
 constexpr Centipawns DRAW_SCORE		 = 0;
 
+/**
+* @brief score of a position the tablebases say is won, less the ply it was found at. below every mate score, far above any material balance
+*/
+constexpr Centipawns TB_WIN_SCORE = 20000;
+
+/**
+* @brief returns true if the score is a forced checkmate for either side (or an infinite window bound)
+*/
+constexpr inline bool isMateScore(int score) {
+	return score >= CHECKMATE_SCORE || score <= -CHECKMATE_SCORE;
+}
+
 constexpr MoveScore KILLER_MOVE_1_SCORE = 99;
 constexpr MoveScore KILLER_MOVE_2_SCORE = 98;
 constexpr MoveScore MAX_MOVE_SCORE		= 999;
+/**
+* @brief score for captures that lose material according to static exchange evaluation. they go after the killer moves but before quiet moves
+*/
+constexpr MoveScore BAD_CAPTURE_SCORE = 1;
 
 constexpr Bitboard firstRank   = 0xff;
 constexpr Bitboard secondRank  = 0xff00;
@@ -201,6 +218,35 @@ inline constexpr Piece fenPieceChartoPieceType(char c) {
 	}
 }
 
+/**
+* @brief material key of a single piece. the key of a position is the sum over its pieces, so each color and piece type has a
+* nibble holding its count and two positions share a key exactly when they have the same material
+*/
+constexpr inline MaterialKey materialKeyOf(Color color, Piece piece) {
+	return 1ULL << (4 * ((int)color * NONE_PIECE + piece));
+}
+
+/**
+* @brief material key of a signature like "KBNvK", white before the v
+*/
+constexpr inline MaterialKey materialKeyOf(const char* signature) {
+	MaterialKey key = 0;
+	Color color		= WHITE;
+	for (; *signature; signature++) {
+		if (*signature == 'v') color = BLACK;
+		else key += materialKeyOf(color, fenPieceChartoPieceType(*signature));
+	}
+	return key;
+}
+
+/**
+* @brief the same material with the colors swapped
+*/
+constexpr inline MaterialKey swapMaterialColors(MaterialKey key) {
+	constexpr int COLOR_BITS = 4 * NONE_PIECE;
+	return key >> COLOR_BITS | (key & ((1ULL << COLOR_BITS) - 1)) << COLOR_BITS;
+}
+
 /**
 * @brief index to ascii piece for ascii board representation
 */
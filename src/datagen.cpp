@@ -0,0 +1,335 @@
+#include "datagen.hpp"
+#include "eval.hpp"
+#include "transposition_table.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+DatagenRecord DatagenRecord::pack(const Board& b, Centipawns whiteScore) {
+	DatagenRecord record{};
+	record.occupancy  = b.boardState.allColorPieces[WHITE] | b.boardState.allColorPieces[BLACK];
+	Bitboard occupied = record.occupancy;
+	for (int i = 0; occupied; i++) {
+		int square	 = bitscan(occupied);
+		uint8_t code = 0;
+		for (Color color : {WHITE, BLACK}) {
+			for (Piece piece : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+				if (b.boardState.pieces[color][piece] & (1UL << square)) code = color << 3 | piece;
+			}
+		}
+		record.pieces[i / 2] |= code << (4 * (i % 2));
+		occupied &= occupied - 1;
+	}
+
+	int enPassantFile			= b.boardState.enPassantSquare ? bitscan(b.boardState.enPassantSquare) % 8 : 8;
+	record.score				= whiteScore;
+	record.result				= 1;
+	record.sideToMove			= b.boardState.sideToMove;
+	record.fullmoveNumber		= std::min<unsigned int>(b.boardState.fmClock, UINT16_MAX);
+	record.halfmoveClock		= std::min<int>(b.boardState.hmClock, UINT8_MAX);
+	record.castlingAndEnPassant = (b.boardState.castlingRights.rights & 0xF) | enPassantFile << 4;
+	return record;
+}
+
+std::string DatagenRecord::fen() const {
+	std::array<char, 64> board{};
+	Bitboard occupied = occupancy;
+	for (int i = 0; occupied; i++) {
+		int square	  = bitscan(occupied);
+		uint8_t code  = (pieces[i / 2] >> (4 * (i % 2))) & 0xF;
+		char piece	  = "kqrbnp"[code & 7];
+		board[square] = (code >> 3) == WHITE ? std::toupper(piece) : piece;
+		occupied &= occupied - 1;
+	}
+
+	std::string fen;
+	for (int rank = 7; rank >= 0; rank--) {
+		int empty = 0;
+		for (int file = 0; file < 8; file++) {
+			char piece = board[rank * 8 + file];
+			if (!piece) {
+				empty++;
+				continue;
+			}
+			if (empty) fen += (char)('0' + empty);
+			fen += piece;
+			empty = 0;
+		}
+		if (empty) fen += (char)('0' + empty);
+		if (rank) fen += '/';
+	}
+
+	fen += sideToMove == WHITE ? " w " : " b ";
+	std::string castling;
+	for (int bit = 3; bit >= 0; bit--) {
+		if (castlingAndEnPassant & (1 << bit)) castling += "KQkq"[3 - bit];
+	}
+	fen += castling.empty() ? "-" : castling;
+
+	int enPassantFile = castlingAndEnPassant >> 4;
+	if (enPassantFile < 8) {
+		fen += std::string(" ") + (char)('a' + enPassantFile) + (sideToMove == WHITE ? '6' : '3');
+	} else {
+		fen += " -";
+	}
+	return fen + " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+}
+
+double MatchResult::score() const {
+	uint64_t games = wins + draws + losses;
+	return games ? (wins + draws / 2.0) / games : 0.5;
+}
+
+namespace {
+double eloOf(double score) {
+	if (score <= 0) return -INFINITY;
+	if (score >= 1) return INFINITY;
+	return -400 * std::log10(1 / score - 1);
+}
+} // namespace
+
+double MatchResult::elo() const {
+	return eloOf(score());
+}
+
+double MatchResult::eloMargin() const {
+	uint64_t games = wins + draws + losses;
+	if (!games) return INFINITY;
+	double s		= score();
+	double variance = (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games;
+	double margin	= 1.96 * std::sqrt(variance / games);
+	return (eloOf(s + margin) - eloOf(s - margin)) / 2;
+}
+
+DatagenResult Datagen::run(const std::string& path, const Options& options, std::ostream& out) {
+	constexpr int REPORT_INTERVAL_MS = 5000;
+	const int threads				 = std::max(1, options.threads);
+
+	Progress progress;
+	progress.running = threads;
+	std::vector<std::string> parts;
+	for (int thread = 0; thread < threads; thread++) parts.push_back(path + "." + std::to_string(thread));
+
+	std::vector<std::thread> workers;
+	auto start = std::chrono::steady_clock::now();
+	for (int thread = 0; thread < threads; thread++) {
+		workers.emplace_back(playGames, std::cref(options), thread, threads, std::cref(parts[thread]), std::ref(progress));
+	}
+
+	auto elapsedMs = [&] { return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(); };
+	auto report = [&](int64_t ms) {
+		uint64_t positions = progress.positions;
+		out << "games " << progress.games << " positions " << positions << " pos/s " << positions * 1000 / std::max<int64_t>(ms, 1) << std::endl;
+	};
+	int64_t lastReport = 0;
+	while (progress.running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if (elapsedMs() - lastReport >= REPORT_INTERVAL_MS) {
+			lastReport = elapsedMs();
+			report(lastReport);
+		}
+	}
+	for (std::thread& worker : workers) worker.join();
+
+	// the threads are done, so their files can be joined in thread order
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	for (const std::string& part : parts) {
+		{
+			std::ifstream in(part, std::ios::binary);
+			if (in.peek() != EOF) file << in.rdbuf();
+		}
+		std::remove(part.c_str());
+	}
+
+	DatagenResult result{progress.games, progress.positions, elapsedMs(), 0};
+	result.positionsPerSecond = result.positions * 1000 / std::max<int64_t>(result.elapsedMs, 1);
+	report(result.elapsedMs);
+	return result;
+}
+
+void Datagen::playGames(const Options& options, int thread, int threads, const std::string& path, Progress& progress) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	TranspositionTable tt;
+	SearchContext ctx;
+	ctx.deterministic = true;
+	ctx.tt			  = &tt;
+
+	std::vector<DatagenRecord> buffer;
+	buffer.reserve(WRITE_BUFFER_RECORDS);
+	auto flush = [&] {
+		file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(DatagenRecord));
+		buffer.clear();
+	};
+
+	// games are dealt out round robin and every game has its own random numbers and an empty tt, so a seed always gives the same file
+	for (uint64_t game = thread; game < options.games; game += threads) {
+		std::mt19937_64 rng(options.seed * 0x9E3779B97F4A7C15ULL + game);
+		tt.reset();
+		size_t before = buffer.size();
+		// a lopsided opening is thrown away and replaced by new random moves
+		while (!playGame(options, ctx, rng, buffer)) {
+		}
+		progress.games++;
+		progress.positions += buffer.size() - before;
+		if (buffer.size() >= WRITE_BUFFER_RECORDS) flush();
+	}
+	flush();
+	progress.running--;
+}
+
+bool Datagen::playGame(const Options& options, SearchContext& ctx, std::mt19937_64& rng, std::vector<DatagenRecord>& records) {
+	Board b = randomOpening(options, rng);
+	return playOut(options, b, {Player{&ctx, false}, Player{&ctx, false}}, &records, true) >= 0;
+}
+
+MatchResult Datagen::match(const Options& options, std::ostream& out) {
+	constexpr int REPORT_INTERVAL_MS = 5000;
+	const int threads				 = std::max(1, options.threads);
+
+	MatchProgress progress;
+	progress.running = threads;
+	std::vector<std::thread> workers;
+	auto start = std::chrono::steady_clock::now();
+	for (int thread = 0; thread < threads; thread++) {
+		workers.emplace_back(playMatches, std::cref(options), thread, threads, std::ref(progress));
+	}
+
+	auto elapsedMs = [&] { return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(); };
+	// a one sided or empty match has no finite elo
+	auto rounded = [](double elo) { return std::isfinite(elo) ? std::to_string(std::lround(elo)) : std::string(elo > 0 ? "inf" : "-inf"); };
+	auto report	 = [&](const MatchResult& result) {
+		 out << "games " << result.wins + result.draws + result.losses << " nnue wins " << result.wins << " draws " << result.draws
+			 << " losses " << result.losses << " elo " << rounded(result.elo()) << " +- " << rounded(result.eloMargin()) << std::endl;
+	};
+	auto snapshot = [&] { return MatchResult{progress.wins, progress.draws, progress.losses, elapsedMs()}; };
+	int64_t lastReport = 0;
+	while (progress.running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if (elapsedMs() - lastReport >= REPORT_INTERVAL_MS) {
+			lastReport = elapsedMs();
+			report(snapshot());
+		}
+	}
+	for (std::thread& worker : workers) worker.join();
+
+	MatchResult result = snapshot();
+	report(result);
+	return result;
+}
+
+void Datagen::playMatches(const Options& options, int thread, int threads, MatchProgress& progress) {
+	TranspositionTable nnueTT, handcraftedTT;
+	SearchContext nnueCtx, handcraftedCtx;
+	nnueCtx.deterministic		 = true;
+	nnueCtx.tt					 = &nnueTT;
+	handcraftedCtx.deterministic = true;
+	handcraftedCtx.tt			 = &handcraftedTT;
+
+	uint64_t pairs = (options.games + 1) / 2;
+	for (uint64_t pair = thread; pair < pairs; pair += threads) {
+		// both games of a pair start from the same opening, checked once by the handcrafted side, so neither evaluation decides
+		// which openings are played
+		std::mt19937_64 rng(options.seed * 0x9E3779B97F4A7C15ULL + pair);
+		Board opening;
+		while (true) {
+			opening = randomOpening(options, rng);
+			Board b = opening;
+			b.dropAccumulators();
+			handcraftedTT.reset();
+			handcraftedCtx.reset();
+			Moves topLine;
+			Centipawns score = Eval::iterative_deepening_nodes(handcraftedCtx, topLine, b, options.nodes);
+			if (!topLine.empty() && std::abs(score) <= MAX_OPENING_SCORE) break;
+		}
+
+		for (Color nnueColor : {WHITE, BLACK}) {
+			nnueTT.reset();
+			handcraftedTT.reset();
+			std::array<Player, 2> players;
+			players[nnueColor]	= Player{&nnueCtx, false};
+			players[!nnueColor] = Player{&handcraftedCtx, true};
+			Board b				= opening;
+			int result			= playOut(options, b, players, nullptr, false);
+			int points			= nnueColor == WHITE ? result : 2 - result;
+			(points == 2 ? progress.wins : points == 1 ? progress.draws : progress.losses)++;
+		}
+	}
+	progress.running--;
+}
+
+Board Datagen::randomOpening(const Options& options, std::mt19937_64& rng) {
+	Board b;
+	int randomPlies = 0;
+	while (randomPlies < options.randomPlies) {
+		Moves moves = b.moveGenerator.genLegalMoves();
+		if (moves.empty()) {
+			b.reset();
+			randomPlies = 0;
+			continue;
+		}
+		b.execute(moves[rng() % moves.size()]);
+		randomPlies++;
+	}
+	return b;
+}
+
+int Datagen::playOut(const Options& options, Board& b, const std::array<Player, 2>& players, std::vector<DatagenRecord>* records,
+					 bool rejectLopsided) {
+	for (const Player& player : players) player.ctx->reset();
+	size_t first		= records ? records->size() : 0;
+	int result			= 1;
+	int adjudicateCount = 0;
+	for (int ply = 0;; ply++) {
+		if (!b.moveGenerator.hasLegalMoves()) {
+			if (b.moveGenerator.inCheck()) result = b.boardState.sideToMove == WHITE ? 0 : 2;
+			break;
+		}
+		if (b.isRepetition() || b.isInsufficientMaterial() || b.boardState.hmClock >= 100 || ply >= MAX_GAME_PLIES) break;
+
+		// the evaluation is switched by dropping or rebuilding the accumulators, a side keeps its evaluation for its whole search
+		const Player& player = players[b.boardState.sideToMove];
+		if (player.handcrafted) {
+			b.dropAccumulators();
+		} else if (!b.accumulator()) {
+			b.refreshAccumulator();
+		}
+
+		Moves topLine;
+		Centipawns score = Eval::iterative_deepening_nodes(*player.ctx, topLine, b, options.nodes);
+		if (topLine.empty()) break;
+		if (rejectLopsided && ply == 0 && std::abs(score) > MAX_OPENING_SCORE) {
+			if (records) records->resize(first);
+			return -1;
+		}
+
+		// only quiet positions are kept, where the static evaluation has a chance of matching the search score
+		Move best			  = topLine[0];
+		Centipawns whiteScore = b.boardState.sideToMove == WHITE ? score : -score;
+		if (records && !b.moveGenerator.inCheck() && !(best.getFlags() & (CAPTURE | PROMOTION)) && !isMateScore(score)) {
+			records->push_back(DatagenRecord::pack(b, whiteScore));
+		}
+
+		// mate scores are past ADJUDICATE_SCORE too
+		if (std::abs(whiteScore) >= ADJUDICATE_SCORE) {
+			int direction	= whiteScore > 0 ? 1 : -1;
+			adjudicateCount = adjudicateCount * direction > 0 ? adjudicateCount + direction : direction;
+			if (std::abs(adjudicateCount) >= ADJUDICATE_PLIES) {
+				result = whiteScore > 0 ? 2 : 0;
+				break;
+			}
+		} else {
+			adjudicateCount = 0;
+		}
+		b.execute(best);
+	}
+
+	if (records) {
+		for (size_t i = first; i < records->size(); i++) (*records)[i].result = result;
+	}
+	return result;
+}
@@ -0,0 +1,199 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "search_context.hpp"
+
+/**
+* @brief one position of a self play game in 32 bytes. the pieces are stored in the order of the set bits of occupancy, a1 first,
+* as a nibble each, color << 3 | piece, the first piece in the low nibble. score and result are from whites POV
+*/
+struct DatagenRecord {
+	uint64_t occupancy;
+	std::array<uint8_t, 16> pieces;
+
+	/**
+	* @brief score of the fixed node search in centipawns
+	*/
+	int16_t score;
+
+	/**
+	* @brief result of the game in half points, 0 for a black win, 1 for a draw, 2 for a white win
+	*/
+	uint8_t result;
+	uint8_t sideToMove;
+	uint16_t fullmoveNumber;
+	uint8_t halfmoveClock;
+
+	/**
+	* @brief castling rights (KQkq, as in Board::CastlingRights) in the low nibble, the en passant file in the high nibble, 8 for none
+	*/
+	uint8_t castlingAndEnPassant;
+
+	/**
+	* @brief packs the position on b, the result is filled in once the game is over
+	*/
+	static DatagenRecord pack(const Board& b, Centipawns whiteScore);
+
+	/**
+	* @brief the position as a fen, for loading it back into a Board
+	*/
+	std::string fen() const;
+};
+static_assert(sizeof(DatagenRecord) == 32);
+
+/**
+* @brief totals of a datagen run
+*/
+struct DatagenResult {
+	uint64_t games;
+	uint64_t positions;
+	int64_t elapsedMs;
+	uint64_t positionsPerSecond;
+};
+
+/**
+* @brief totals of a match between the nnue and the handcrafted evaluation, wins and losses from the nnue sides POV
+*/
+struct MatchResult {
+	uint64_t wins;
+	uint64_t draws;
+	uint64_t losses;
+	int64_t elapsedMs;
+
+	/**
+	* @brief points per game of the nnue side, draws counting half
+	*/
+	double score() const;
+
+	/**
+	* @brief elo difference of the nnue side implied by score(), infinite if it won or lost every game
+	*/
+	double elo() const;
+
+	/**
+	* @brief half the width of the 95% confidence interval of elo(), from the spread of the game results
+	*/
+	double eloMargin() const;
+};
+
+/**
+* @brief plays self play games from random openings at a fixed number of nodes per move, on several threads, and writes the quiet
+* positions of each game with their search scores and the game result as DatagenRecords. every thread has its own tt, buffers its
+* records and writes them to a file of its own, so the threads never wait on each other. the files are joined into one at the end,
+* and the same options always give the same file
+*/
+class Datagen {
+public:
+	struct Options {
+		uint64_t games = 1000;
+		int threads	   = 1;
+		uint64_t nodes = 5000;
+		uint64_t seed  = 1;
+
+		/**
+		* @brief number of random moves played before the searched part of a game
+		*/
+		int randomPlies = 8;
+	};
+
+	/**
+	* @brief plays options.games games and writes their records to path, reporting progress to out every few seconds
+	*/
+	static DatagenResult run(const std::string& path, const Options& options, std::ostream& out);
+
+	/**
+	* @brief plays the loaded net against the handcrafted evaluation at options.nodes per move. every random opening is played twice,
+	* once with each evaluation as white, so options.games is rounded up to an even number. each side searches on a tt of its own.
+	* without a loaded net both sides are handcrafted, and every pair of games is a win and a loss or two draws
+	*/
+	static MatchResult match(const Options& options, std::ostream& out);
+
+	/**
+	* @brief openings that are already this lopsided after the random moves are thrown away
+	*/
+	static constexpr Centipawns MAX_OPENING_SCORE = 1000;
+
+	/**
+	* @brief a game is adjudicated once the score has been past this for ADJUDICATE_PLIES plies in a row, in the same direction
+	*/
+	static constexpr Centipawns ADJUDICATE_SCORE = 2500;
+	static constexpr int ADJUDICATE_PLIES		   = 6;
+
+	/**
+	* @brief games still going after this many plies are scored as draws
+	*/
+	static constexpr int MAX_GAME_PLIES = 400;
+
+	/**
+	* @brief records a thread collects before writing them to its file
+	*/
+	static constexpr size_t WRITE_BUFFER_RECORDS = 1 << 14;
+
+private:
+	/**
+	* @brief counters shared by the threads of a run
+	*/
+	struct Progress {
+		std::atomic<uint64_t> games{0};
+		std::atomic<uint64_t> positions{0};
+		std::atomic<int> running{0};
+	};
+
+	/**
+	* @brief counters shared by the threads of a match, from the nnue sides POV
+	*/
+	struct MatchProgress {
+		std::atomic<uint64_t> wins{0};
+		std::atomic<uint64_t> draws{0};
+		std::atomic<uint64_t> losses{0};
+		std::atomic<int> running{0};
+	};
+
+	/**
+	* @brief a side of a game, the context it searches with and whether it evaluates with the handcrafted terms instead of the net
+	*/
+	struct Player {
+		SearchContext* ctx;
+		bool handcrafted;
+	};
+
+	/**
+	* @brief one thread of a run. plays every threads-th game starting at game number thread, each on a cleared tt of its own, and
+	* writes their records to path
+	*/
+	static void playGames(const Options& options, int thread, int threads, const std::string& path, Progress& progress);
+
+	/**
+	* @brief plays one game and appends its quiet positions to records. returns false without adding anything if the random opening
+	* turned out too lopsided, so the game should be played again
+	*/
+	static bool playGame(const Options& options, SearchContext& ctx, std::mt19937_64& rng, std::vector<DatagenRecord>& records);
+
+	/**
+	* @brief one thread of a match. plays every threads-th pair of games starting at pair number thread, on cleared tts
+	*/
+	static void playMatches(const Options& options, int thread, int threads, MatchProgress& progress);
+
+	/**
+	* @brief plays options.randomPlies random moves from the start position, starting over if they run into the end of the game
+	*/
+	static Board randomOpening(const Options& options, std::mt19937_64& rng);
+
+	/**
+	* @brief plays the game on b to its end, players[color] searching the moves of color, and returns the result in half points from
+	* whites POV. the quiet positions are appended to records if it isnt null. with rejectLopsided the game is abandoned with -1 if
+	* the score of its first search is past MAX_OPENING_SCORE
+	*/
+	static int playOut(const Options& options, Board& b, const std::array<Player, 2>& players, std::vector<DatagenRecord>* records,
+					   bool rejectLopsided);
+};
+#endif
@@ -0,0 +1,211 @@
+#include "endgame.hpp"
+#include "eval_params.hpp"
+#include "lookup_tables.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55;
+
+/**
+* @brief centipawns per step the weak king is closer to the edge or corner, and the kings are closer together
+*/
+constexpr int PUSH_TO_EDGE	 = 20;
+constexpr int PUSH_TO_CORNER = 30;
+constexpr int PUSH_CLOSE	 = 10;
+
+/**
+* @brief centipawns per rank of a pawn that wins KPK, so the search pushes it instead of shuffling the king
+*/
+constexpr int KPK_PAWN_RANK = 20;
+
+enum KPKResult : uint8_t {
+	KPK_INVALID = 0,
+	KPK_UNKNOWN = 1,
+	KPK_DRAW	= 2,
+	KPK_WIN		= 4,
+};
+
+int fileOf(int sq) {
+	return sq & 7;
+}
+
+int rankOf(int sq) {
+	return sq >> 3;
+}
+
+int distance(int a, int b) {
+	return std::max(std::abs(fileOf(a) - fileOf(b)), std::abs(rankOf(a) - rankOf(b)));
+}
+
+/**
+* @brief 0 in the center, 6 in a corner
+*/
+int edgeDistance(int sq) {
+	return 6 - std::min(fileOf(sq), 7 - fileOf(sq)) - std::min(rankOf(sq), 7 - rankOf(sq));
+}
+
+Bitboard whitePawnAttacks(int sq) {
+	Bitboard pawn = 1UL << sq;
+	return (pawn << 7 & ~hFile) | (pawn << 9 & ~aFile);
+}
+} // namespace
+
+std::bitset<Endgame::KPK_SIZE> Endgame::s_kpkWins;
+std::unordered_map<MaterialKey, Endgame::Entry> Endgame::s_entries;
+
+void Endgame::init() {
+	if (!s_entries.empty()) return;
+	generateKPK();
+
+	add("KPvK", evaluateKPK);
+	add("KQvK", evaluateKXK);
+	add("KRvK", evaluateKXK);
+	add("KBNvK", evaluateKBNK);
+
+	// opposite colored bishops with any pawns. the scale is symmetric, so there is no strong side
+	for (int whitePawns = 0; whitePawns <= 8; whitePawns++) {
+		for (int blackPawns = 0; blackPawns <= 8; blackPawns++) {
+			MaterialKey key =
+				materialKeyOf("KBvKB") + whitePawns * materialKeyOf(WHITE, PAWN) + blackPawns * materialKeyOf(BLACK, PAWN);
+			s_entries[key] = {nullptr, scaleOppositeBishops, WHITE};
+		}
+	}
+}
+
+void Endgame::add(const char* signature, EvalFunction eval) {
+	MaterialKey key					   = materialKeyOf(signature);
+	s_entries[key]					   = {eval, nullptr, WHITE};
+	s_entries[swapMaterialColors(key)] = {eval, nullptr, BLACK};
+}
+
+size_t Endgame::kpkIndex(int whiteKing, int whitePawn, int blackKing, Color sideToMove) {
+	return whiteKing | blackKing << 6 | sideToMove << 12 | fileOf(whitePawn) << 13 | (6 - rankOf(whitePawn)) << 15;
+}
+
+bool Endgame::probeKPK(int whiteKing, int whitePawn, int blackKing, Color sideToMove) {
+	if (fileOf(whitePawn) > 3) {
+		whiteKing ^= 7;
+		whitePawn ^= 7;
+		blackKing ^= 7;
+	}
+	return s_kpkWins[kpkIndex(whiteKing, whitePawn, blackKing, sideToMove)];
+}
+
+void Endgame::generateKPK() {
+	std::vector<uint8_t> results(KPK_SIZE);
+	const auto& kingAttacks = LookupTables::s_kingAttacks;
+	auto decode				= [](size_t idx, int& whiteKing, int& whitePawn, int& blackKing, Color& sideToMove) {
+		whiteKing  = idx & 63;
+		blackKing  = (idx >> 6) & 63;
+		sideToMove = (Color)((idx >> 12) & 1);
+		whitePawn  = ((idx >> 13) & 3) + 8 * (6 - (int)(idx >> 15));
+	};
+
+	for (size_t idx = 0; idx < KPK_SIZE; idx++) {
+		int whiteKing, whitePawn, blackKing;
+		Color sideToMove;
+		decode(idx, whiteKing, whitePawn, blackKing, sideToMove);
+		int promotion = whitePawn + 8;
+
+		if (distance(whiteKing, blackKing) <= 1 || whiteKing == whitePawn || blackKing == whitePawn ||
+			(sideToMove == WHITE && (whitePawnAttacks(whitePawn) & 1UL << blackKing))) {
+			results[idx] = KPK_INVALID;
+		} else if (sideToMove == WHITE && rankOf(whitePawn) == 6 && whiteKing != promotion &&
+				   (distance(blackKing, promotion) > 1 || distance(whiteKing, promotion) == 1)) {
+			// the pawn promotes and the queen cant be taken
+			results[idx] = KPK_WIN;
+		} else if (sideToMove == BLACK &&
+				   (!(kingAttacks[blackKing] & ~(kingAttacks[whiteKing] | whitePawnAttacks(whitePawn))) ||
+					(kingAttacks[blackKing] & ~kingAttacks[whiteKing] & 1UL << whitePawn))) {
+			// stalemate, or the pawn hangs
+			results[idx] = KPK_DRAW;
+		} else {
+			results[idx] = KPK_UNKNOWN;
+		}
+	}
+
+	// a white position is won if any move reaches a win, a black one drawn if any move reaches a draw. moves into an illegal
+	// position hit KPK_INVALID, which adds nothing
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t idx = 0; idx < KPK_SIZE; idx++) {
+			if (results[idx] != KPK_UNKNOWN) continue;
+			int whiteKing, whitePawn, blackKing;
+			Color sideToMove;
+			decode(idx, whiteKing, whitePawn, blackKing, sideToMove);
+
+			uint8_t reachable = 0;
+			if (sideToMove == WHITE) {
+				for (Bitboard moves = kingAttacks[whiteKing]; moves; moves &= moves - 1) {
+					reachable |= results[kpkIndex(bitscan(moves), whitePawn, blackKing, BLACK)];
+				}
+				if (rankOf(whitePawn) < 6) reachable |= results[kpkIndex(whiteKing, whitePawn + 8, blackKing, BLACK)];
+				if (rankOf(whitePawn) == 1 && whitePawn + 8 != whiteKing && whitePawn + 8 != blackKing) {
+					reachable |= results[kpkIndex(whiteKing, whitePawn + 16, blackKing, BLACK)];
+				}
+			} else {
+				for (Bitboard moves = kingAttacks[blackKing]; moves; moves &= moves - 1) {
+					reachable |= results[kpkIndex(whiteKing, whitePawn, bitscan(moves), WHITE)];
+				}
+			}
+
+			uint8_t good	= sideToMove == WHITE ? KPK_WIN : KPK_DRAW;
+			uint8_t bad		= sideToMove == WHITE ? KPK_DRAW : KPK_WIN;
+			uint8_t unknown = KPK_UNKNOWN;
+			uint8_t result	= (reachable & good) ? good : ((reachable & unknown) ? unknown : bad);
+			if (result != KPK_UNKNOWN) {
+				results[idx] = result;
+				changed		 = true;
+			}
+		}
+	}
+
+	for (size_t idx = 0; idx < KPK_SIZE; idx++) s_kpkWins[idx] = results[idx] == KPK_WIN;
+}
+
+int Endgame::material(const Board& b, Color color) {
+	int material = 0;
+	for (Piece piece : {QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+		material += std::popcount(b.boardState.pieces[color][piece]) * EvalParams::egPieceValues[piece];
+	}
+	return material;
+}
+
+Centipawns Endgame::evaluateKPK(const Board& b, Color strongSide) {
+	// the bitbase has white as the strong side, so black is flipped to white
+	const auto& pieces = b.boardState.pieces;
+	int flip		   = strongSide == WHITE ? 0 : 56;
+	int strongKing	   = bitscan(pieces[strongSide][KING]) ^ flip;
+	int pawn		   = bitscan(pieces[strongSide][PAWN]) ^ flip;
+	int weakKing	   = bitscan(pieces[!strongSide][KING]) ^ flip;
+	Color sideToMove   = b.boardState.sideToMove == strongSide ? WHITE : BLACK;
+
+	if (!probeKPK(strongKing, pawn, weakKing, sideToMove)) return DRAW_SCORE;
+	return KNOWN_WIN_SCORE + EvalParams::egPieceValues[PAWN] + KPK_PAWN_RANK * rankOf(pawn);
+}
+
+Centipawns Endgame::evaluateKXK(const Board& b, Color strongSide) {
+	int strongKing = bitscan(b.boardState.pieces[strongSide][KING]);
+	int weakKing   = bitscan(b.boardState.pieces[!strongSide][KING]);
+	return KNOWN_WIN_SCORE + material(b, strongSide) + PUSH_TO_EDGE * edgeDistance(weakKing) +
+		   PUSH_CLOSE * (7 - distance(strongKing, weakKing));
+}
+
+Centipawns Endgame::evaluateKBNK(const Board& b, Color strongSide) {
+	int strongKing = bitscan(b.boardState.pieces[strongSide][KING]);
+	int weakKing   = bitscan(b.boardState.pieces[!strongSide][KING]);
+	// 7 in a1 and h8, the dark corners, and 0 on the long light diagonal. for a light squared bishop the board is mirrored
+	int cornerSquare = b.boardState.pieces[strongSide][BISHOP] & DARK_SQUARES ? weakKing : weakKing ^ 7;
+	int toCorner	 = std::abs(7 - rankOf(cornerSquare) - fileOf(cornerSquare));
+	return KNOWN_WIN_SCORE + material(b, strongSide) + PUSH_TO_CORNER * toCorner + PUSH_CLOSE * (7 - distance(strongKing, weakKing));
+}
+
+int Endgame::scaleOppositeBishops(const Board& b, Color) {
+	const auto& pieces = b.boardState.pieces;
+	if (!(pieces[WHITE][BISHOP] & DARK_SQUARES) == !(pieces[BLACK][BISHOP] & DARK_SQUARES)) return SCALE_NORMAL;
+	int pawnDifference = std::abs(std::popcount(pieces[WHITE][PAWN]) - std::popcount(pieces[BLACK][PAWN]));
+	return std::min(SCALE_NORMAL, SCALE_NORMAL / 4 * (1 + pawnDifference));
+}
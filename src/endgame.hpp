@@ -0,0 +1,116 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <bitset>
+#include <unordered_map>
+
+#include "board.hpp"
+#include "consts.hpp"
+
+/**
+* @brief knowledge of endgames the regular evaluation gets wrong, for when there are no tablebases. a registry keyed by material
+* key holds an exact evaluation for endgames with a known result, KPK from a bitbase and the mates of KQK, KRK and KBNK, and a
+* scale factor for drawish ones like opposite colored bishops. the bitbase is generated by init
+*/
+class Endgame {
+public:
+	/**
+	* @brief base score of a won endgame, below the tablebase and mate scores so those are still preferred
+	*/
+	static constexpr Centipawns KNOWN_WIN_SCORE = 10000;
+
+	/**
+	* @brief scale factors are out of SCALE_NORMAL, which leaves the evaluation as it is
+	*/
+	static constexpr int SCALE_NORMAL = 64;
+
+	/**
+	* @brief score of b from the POV of strongSide
+	*/
+	using EvalFunction = Centipawns (*)(const Board& b, Color strongSide);
+
+	/**
+	* @brief factor out of SCALE_NORMAL the regular evaluation of b is multiplied by
+	*/
+	using ScaleFunction = int (*)(const Board& b, Color strongSide);
+
+	/**
+	* @brief what is known about one material signature, either an evaluation or a scale factor
+	*/
+	struct Entry {
+		EvalFunction evaluate = nullptr;
+		ScaleFunction scale	  = nullptr;
+		Color strongSide	  = WHITE;
+	};
+
+	/**
+	* @brief generates the KPK bitbase and fills the registry. needs the lookup tables, only does its work on the first call
+	*/
+	static void init();
+
+	/**
+	* @brief the entry for the material of b, nullptr if there is none
+	*/
+	static const Entry* probe(const Board& b) {
+		// every registered signature has at most a queens worth of phase, so most positions are turned away before the lookup
+		if (b.boardState.phase > MAX_ENTRY_PHASE) return nullptr;
+		auto it = s_entries.find(b.boardState.materialKey);
+		return it == s_entries.end() ? nullptr : &it->second;
+	}
+
+	/**
+	* @brief returns true if white wins with a king and a pawn against the black king, false if it is a draw. the position must be
+	* legal
+	*/
+	static bool probeKPK(int whiteKing, int whitePawn, int blackKing, Color sideToMove);
+
+private:
+	static constexpr int MAX_ENTRY_PHASE = 4;
+
+	/**
+	* @brief positions in the KPK bitbase: both kings, the side to move and the pawn on the 2nd to 7th rank of files a to d. pawns
+	* on the other files are mirrored
+	*/
+	static constexpr int KPK_SIZE = 2 * 64 * 64 * 24;
+
+	static size_t kpkIndex(int whiteKing, int whitePawn, int blackKing, Color sideToMove);
+
+	/**
+	* @brief retrograde analysis over every KPK position: positions where the pawn promotes safely are wins, ones where black
+	* takes it or is stalemated are draws, and the rest are resolved from their successors until nothing changes. whatever is
+	* still unknown then is a draw
+	*/
+	static void generateKPK();
+
+	/**
+	* @brief registers eval for the material in signature, and for the same material with the colors swapped
+	*/
+	static void add(const char* signature, EvalFunction eval);
+
+	static Centipawns evaluateKPK(const Board& b, Color strongSide);
+
+	/**
+	* @brief KQK and KRK. the weak king is driven to the edge and the strong king brought in, which is all it takes to find the
+	* mate
+	*/
+	static Centipawns evaluateKXK(const Board& b, Color strongSide);
+
+	/**
+	* @brief like KXK, but the mate is only possible in a corner of the color of the bishop
+	*/
+	static Centipawns evaluateKBNK(const Board& b, Color strongSide);
+
+	/**
+	* @brief bishops on opposite colors are hard to win with a pawn or two up, unless the difference grows
+	*/
+	static int scaleOppositeBishops(const Board& b, Color strongSide);
+
+	/**
+	* @brief the material of color without its king, with the endgame piece values
+	*/
+	static int material(const Board& b, Color color);
+
+	static std::bitset<KPK_SIZE> s_kpkWins;
+	static std::unordered_map<MaterialKey, Entry> s_entries;
+};
+#endif
@@ -0,0 +1,70 @@
+#include "engine_thread.hpp"
+#include "eval.hpp"
+
+EngineThread::EngineThread() : m_searching(false) {
+	m_searchContext.listener = this;
+}
+
+EngineThread::~EngineThread() {
+	join();
+}
+
+std::future<Move> EngineThread::search(const Board& b, const TimeControl& tc, int maxDepth, bool ponder) {
+	join();
+	{
+		std::lock_guard<std::mutex> lock(m_iterationMutex);
+		m_hasIteration = false;
+	}
+	// done here rather than on the worker, so a stop right after this call isnt lost
+	m_searchContext.prepareSearch();
+	m_searchContext.setPondering(ponder);
+	m_searching = true;
+
+	std::promise<Move> bestMove;
+	std::future<Move> result = bestMove.get_future();
+	m_thread				 = std::thread([this, board = b, tc, maxDepth, bestMove = std::move(bestMove)]() mutable {
+		Moves topLine;
+		Eval::iterative_deepening(m_searchContext, topLine, board, tc, maxDepth);
+		// cleared before the future is resolved, so a caller that sees the move never sees searching() == true
+		m_searching = false;
+		bestMove.set_value(topLine.empty() ? Move() : topLine[0]);
+	});
+	return result;
+}
+
+void EngineThread::stop() {
+	m_searchContext.stop();
+}
+
+void EngineThread::ponderhit() {
+	m_searchContext.ponderhit();
+}
+
+bool EngineThread::searching() const {
+	return m_searching;
+}
+
+void EngineThread::onIteration(const SearchInfo& info) {
+	{
+		std::lock_guard<std::mutex> lock(m_iterationMutex);
+		m_latestIteration = info;
+		m_hasIteration	  = true;
+	}
+	if (listener) listener->onIteration(info);
+}
+
+void EngineThread::onSearchEnd(const SearchInfo& info) {
+	if (listener) listener->onSearchEnd(info);
+}
+
+bool EngineThread::latestIteration(SearchInfo& info) const {
+	std::lock_guard<std::mutex> lock(m_iterationMutex);
+	if (!m_hasIteration) return false;
+	info = m_latestIteration;
+	return true;
+}
+
+void EngineThread::join() {
+	stop();
+	if (m_thread.joinable()) m_thread.join();
+}
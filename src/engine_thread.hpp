@@ -0,0 +1,87 @@
+#ifndef ENGINE_THREAD_H
+#define ENGINE_THREAD_H
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "board.hpp"
+#include "search_context.hpp"
+#include "search_listener.hpp"
+#include "time_manager.hpp"
+
+/**
+* @brief runs searches on a worker thread so the caller never blocks on them. the result comes back through a future,
+* and the last completed iteration can be polled at any time, so a render loop can show the live pv and eval.
+* only one search runs at a time, and its search context (history, killers) carries over to the next one.
+*/
+class EngineThread : private SearchListener {
+public:
+	EngineThread();
+
+	/**
+	* @brief stops and joins any running search
+	*/
+	~EngineThread();
+
+	EngineThread(const EngineThread&)			 = delete;
+	EngineThread& operator=(const EngineThread&) = delete;
+
+	/**
+	* @brief starts searching a copy of b on the worker thread, stopping any search that is still running first
+	* @param b The position to search. copied, so the caller is free to change its board while the search runs.
+	* @param tc Clock of the side to move, default constructed for no time limit.
+	* @param maxDepth The maximum depth to search to.
+	* @param ponder Searches b as the position after the opponents expected reply, with tc only starting to count on ponderhit.
+	* @return the best move, ready once the search has finished or been stopped. a null move if there are no legal moves
+	*/
+	std::future<Move> search(const Board& b, const TimeControl& tc, int maxDepth = SearchContext::MAX_SEARCH_DEPTH, bool ponder = false);
+
+	/**
+	* @brief asks the running search to stop. it still resolves its future with the best move found so far
+	*/
+	void stop();
+
+	/**
+	* @brief the opponent played the expected reply, so the running ponder search carries on as a normal search on its clock
+	*/
+	void ponderhit();
+
+	/**
+	* @brief returns true from the call to search until the worker has resolved the future
+	*/
+	bool searching() const;
+
+	/**
+	* @brief copies the last completed iteration of the current (or last) search into info
+	* @return false if no iteration has completed since search was called
+	*/
+	bool latestIteration(SearchInfo& info) const;
+
+	/**
+	* @brief also receives every iteration, on the worker thread. not owned, set it before calling search
+	*/
+	SearchListener* listener = nullptr;
+
+private:
+	SearchContext m_searchContext;
+	std::thread m_thread;
+	std::atomic<bool> m_searching;
+
+	mutable std::mutex m_iterationMutex;
+	SearchInfo m_latestIteration{};
+	bool m_hasIteration = false;
+
+	/**
+	* @brief keeps the iteration for latestIteration and passes it on to listener
+	*/
+	void onIteration(const SearchInfo& info) override;
+	void onSearchEnd(const SearchInfo& info) override;
+
+	/**
+	* @brief stops the running search and joins the worker
+	*/
+	void join();
+};
+#endif
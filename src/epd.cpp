@@ -0,0 +1,257 @@
+#include "epd.hpp"
+#include "eval.hpp"
+#include "search_context.hpp"
+#include "search_listener.hpp"
+#include "transposition_table.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+/**
+* @brief follows the iterations of a search and remembers since when its move has solved the position
+*/
+class SolveListener : public SearchListener {
+public:
+	SolveListener(const EpdPosition& position) : m_position(position) {}
+
+	void onIteration(const SearchInfo& info) override {
+		if (info.pv.empty()) return;
+		if (!m_position.solvedBy(info.pv[0])) {
+			m_solvedSinceMs = -1;
+		} else if (m_solvedSinceMs < 0) {
+			m_solvedSinceMs = info.elapsedMs;
+		}
+	}
+
+	/**
+	* @brief time of the first iteration of the run of solving iterations that lasted until the last one, -1 if the last one failed
+	*/
+	int64_t solvedSinceMs() const {
+		return m_solvedSinceMs;
+	}
+
+private:
+	const EpdPosition& m_position;
+	int64_t m_solvedSinceMs = -1;
+};
+
+std::string trim(const std::string& s) {
+	size_t first = s.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos) return "";
+	return s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+/**
+* @brief splits the operations after the position at their semicolons, ignoring the ones inside quoted strings
+*/
+std::vector<std::string> splitOperations(const std::string& s) {
+	std::vector<std::string> operations;
+	std::string current;
+	bool quoted = false;
+	for (char c : s) {
+		if (c == '"') quoted = !quoted;
+		if (c == ';' && !quoted) {
+			if (!trim(current).empty()) operations.push_back(trim(current));
+			current.clear();
+		} else {
+			current += c;
+		}
+	}
+	if (!trim(current).empty()) operations.push_back(trim(current));
+	return operations;
+}
+} // namespace
+
+bool EpdPosition::solvedBy(const Move& m) const {
+	if (!bestMoves.empty()) return std::find(bestMoves.begin(), bestMoves.end(), m) != bestMoves.end();
+	return std::find(avoidMoves.begin(), avoidMoves.end(), m) == avoidMoves.end();
+}
+
+Move Epd::parseSan(Board& b, const std::string& san) {
+	std::string s = san;
+	while (!s.empty() && std::string("+#!?").find(s.back()) != std::string::npos) s.pop_back();
+
+	Moves legalMoves = b.moveGenerator.genLegalMoves();
+	if (s == "O-O" || s == "0-0" || s == "O-O-O" || s == "0-0-0") {
+		MoveFlag castle = s.size() == 3 ? KS_CASTLE : QS_CASTLE;
+		for (const Move& m : legalMoves) {
+			if (m.getFlags() & castle) return m;
+		}
+		return Move();
+	}
+
+	Piece promotion = NONE_PIECE;
+	if (s.size() > 2 && std::string("QRBN").find(s.back()) != std::string::npos) {
+		promotion = (Piece)(std::find(pieceToNotationChar.begin(), pieceToNotationChar.end(), s.back()) - pieceToNotationChar.begin());
+		s.pop_back();
+		if (s.back() == '=') s.pop_back();
+	}
+
+	Piece piece = PAWN;
+	if (!s.empty() && std::string("KQRBN").find(s[0]) != std::string::npos) {
+		piece = (Piece)(std::find(pieceToNotationChar.begin(), pieceToNotationChar.end(), s[0]) - pieceToNotationChar.begin());
+		s.erase(0, 1);
+	}
+	s.erase(std::remove_if(s.begin(), s.end(), [](char c) { return c == 'x' || c == '-'; }), s.end());
+	if (s.size() < 2 || s.size() > 4) return Move();
+
+	// the destination comes last, anything in front of it is the file and or rank of the moving piece
+	std::string to = s.substr(s.size() - 2);
+	if (to[0] < 'a' || to[0] > 'h' || to[1] < '1' || to[1] > '8') return Move();
+	int toSquare = (to[1] - '1') * 8 + (to[0] - 'a');
+	int fromFile = -1, fromRank = -1;
+	for (char c : s.substr(0, s.size() - 2)) {
+		if (c >= 'a' && c <= 'h') {
+			fromFile = c - 'a';
+		} else if (c >= '1' && c <= '8') {
+			fromRank = c - '1';
+		} else {
+			return Move();
+		}
+	}
+
+	Move found;
+	int matches = 0;
+	for (const Move& m : legalMoves) {
+		if (m.getPieceType() != piece || m.getTo() != toSquare || (m.getFlags() & (KS_CASTLE | QS_CASTLE))) continue;
+		if ((m.getFlags() & PROMOTION ? m.getPromoPiece() : NONE_PIECE) != promotion) continue;
+		if ((fromFile != -1 && m.getFrom() % 8 != fromFile) || (fromRank != -1 && m.getFrom() / 8 != fromRank)) continue;
+		found = m;
+		matches++;
+	}
+	return matches == 1 ? found : Move();
+}
+
+bool Epd::parse(const std::string& line, EpdPosition& position) {
+	std::istringstream in(trim(line));
+	std::string fields[4];
+	for (std::string& field : fields) in >> field;
+	if (fields[3].empty() || !Board::validPlacement(fields[0]) || (fields[1] != "w" && fields[1] != "b")) return false;
+	if (fields[2].find_first_not_of("KQkq-") != std::string::npos) return false;
+	const std::string& enPassant = fields[3];
+	if (enPassant != "-" && (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || (enPassant[1] != '3' && enPassant[1] != '6'))) return false;
+
+	std::string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+	Board b;
+	b.setToFen((fen + " 0 1").c_str());
+	if (!b.moveGenerator.hasLegalMoves()) return false;
+
+	position = EpdPosition();
+	std::string halfmoveClock = "0", fullmoveNumber = "1", rest;
+	std::getline(in, rest);
+	for (const std::string& operation : splitOperations(rest)) {
+		std::istringstream operands(operation);
+		std::string opcode, operand;
+		operands >> opcode;
+		if (opcode == "bm" || opcode == "am") {
+			while (operands >> operand) {
+				Move m = parseSan(b, operand);
+				if (m.getPieceType() == NONE_PIECE) return false;
+				(opcode == "bm" ? position.bestMoves : position.avoidMoves).push_back(m);
+			}
+		} else if (opcode == "id") {
+			std::getline(operands, operand);
+			operand = trim(operand);
+			if (operand.size() >= 2 && operand.front() == '"' && operand.back() == '"') operand = operand.substr(1, operand.size() - 2);
+			position.id = operand;
+		} else if (opcode == "hmvc") {
+			operands >> halfmoveClock;
+		} else if (opcode == "fmvn") {
+			operands >> fullmoveNumber;
+		}
+	}
+	position.fen = fen + " " + halfmoveClock + " " + fullmoveNumber;
+	return true;
+}
+
+EpdResult Epd::run(const std::string& path, const Options& options, std::ostream& out) {
+	const int threads = std::max(1, options.threads);
+	EpdResult result{};
+	Progress progress;
+	progress.file.open(path);
+	if (!progress.file) {
+		out << "could not open " << path << std::endl;
+		return result;
+	}
+
+	std::vector<std::thread> workers;
+	auto start = std::chrono::steady_clock::now();
+	for (int thread = 0; thread < threads; thread++) {
+		workers.emplace_back(searchPositions, std::cref(options), std::ref(progress), std::ref(out));
+	}
+	for (std::thread& worker : workers) worker.join();
+
+	result.positions		  = progress.positions;
+	result.solved			  = progress.solved;
+	result.skipped			  = progress.skipped;
+	result.nodes			  = progress.nodes;
+	result.elapsedMs		  = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	result.nps				  = result.nodes * 1000 / std::max<int64_t>(result.elapsedMs, 1);
+	result.averageSolveMs	  = result.solved ? progress.solveMs / (int64_t)result.solved : 0;
+	result.positionsPerSecond = result.positions * 1000.0 / std::max<int64_t>(result.elapsedMs, 1);
+	out << "solved " << result.solved << " of " << result.positions << ", skipped " << result.skipped << " lines, average time to solution "
+		<< result.averageSolveMs << " ms\n";
+	out << result.positions << " positions " << result.nodes << " nodes " << result.elapsedMs << " ms " << result.positionsPerSecond
+		<< " positions/s " << result.nps << " nps" << std::endl;
+	return result;
+}
+
+void Epd::searchPositions(const Options& options, Progress& progress, std::ostream& out) {
+	TranspositionTable tt;
+	SearchContext ctx;
+	ctx.deterministic = options.nodes;
+	ctx.tt			  = &tt;
+
+	std::string line;
+	while (true) {
+		EpdPosition position;
+		{
+			std::lock_guard<std::mutex> lock(progress.fileMutex);
+			bool parsed = false;
+			while (!parsed && std::getline(progress.file, line)) {
+				progress.lineNumber++;
+				parsed = parse(line, position);
+				// a suite that looks solved while it lost positions to typos would be worse than one that says so
+				std::string content = trim(line);
+				if (!parsed && !content.empty() && content[0] != '#') {
+					progress.skipped++;
+					std::lock_guard<std::mutex> outLock(progress.outMutex);
+					out << "line " << progress.lineNumber << " skipped, no valid position or moves: " << content << std::endl;
+				}
+			}
+			if (!parsed) return;
+		}
+
+		Board b;
+		b.setToFen(position.fen.c_str());
+		SolveListener listener(position);
+		Moves topLine;
+		// a position is searched from scratch, whatever this thread searched before it
+		tt.reset();
+		ctx.reset();
+		ctx.listener = &listener;
+		if (options.nodes) {
+			Eval::iterative_deepening_nodes(ctx, topLine, b, options.nodes);
+		} else {
+			Eval::iterative_deepening_time(ctx, topLine, b, options.timeMs);
+		}
+		ctx.listener = nullptr;
+
+		bool solved = !topLine.empty() && position.solvedBy(topLine[0]);
+		progress.positions++;
+		progress.nodes += ctx.nodes + ctx.qnodes;
+		if (solved) {
+			progress.solved++;
+			progress.solveMs += std::max<int64_t>(listener.solvedSinceMs(), 0);
+		}
+
+		std::lock_guard<std::mutex> lock(progress.outMutex);
+		out << (position.id.empty() ? position.fen : position.id) << ": " << (solved ? "solved" : "failed");
+		if (solved) out << " in " << std::max<int64_t>(listener.solvedSinceMs(), 0) << " ms";
+		out << ", bestmove " << (topLine.empty() ? std::string("0000") : topLine[0].UCInotation()) << std::endl;
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include "board.hpp"
+#include "consts.hpp"
+#include "move.hpp"
+
+/**
+* @brief one line of an epd test suite: the position and the moves the engine should (bm) or shouldnt (am) play
+*/
+struct EpdPosition {
+	/**
+	* @brief the four epd fields with the clocks appended from the hmvc and fmvn operations, 0 and 1 without them
+	*/
+	std::string fen;
+	std::string id;
+	Moves bestMoves;
+	Moves avoidMoves;
+
+	/**
+	* @brief true if m is one of bestMoves, or there are none and m isnt one of avoidMoves
+	*/
+	bool solvedBy(const Move& m) const;
+};
+
+/**
+* @brief totals of an epd run. a position counts as solved if the move of the final iteration solves it, and its time to solution
+* is the time of the iteration since which every iteration had a solving move. skipped counts the lines that arent empty or a
+* # comment but that parse rejected, they arent in positions
+*/
+struct EpdResult {
+	uint64_t positions;
+	uint64_t solved;
+	uint64_t skipped;
+	uint64_t nodes;
+	int64_t elapsedMs;
+	uint64_t nps;
+
+	/**
+	* @brief average time to solution over the solved positions, and the positions searched per second on all threads
+	*/
+	int64_t averageSolveMs;
+	double positionsPerSecond;
+};
+
+/**
+* @brief runs an epd test suite such as WAC or STS on several threads. the file is read a line at a time by whichever thread is free,
+* and every thread searches with its own context and tt, cleared for each position, so the result of a position doesnt depend on
+* the ones searched before it. with a node budget every run gives the same results
+*/
+class Epd {
+public:
+	struct Options {
+		int threads = 1;
+
+		/**
+		* @brief search time per position, only used when nodes is 0
+		*/
+		int timeMs = 1000;
+
+		/**
+		* @brief node budget per position, searched deterministically. 0 to search for timeMs instead
+		*/
+		uint64_t nodes = 0;
+	};
+
+	/**
+	* @brief searches every position of the epd file at path and writes a line per position and the totals to out. lines that
+	* cant be read are reported with their line number and left out
+	*/
+	static EpdResult run(const std::string& path, const Options& options, std::ostream& out);
+
+	/**
+	* @brief reads an epd line into position. returns false for empty lines, comments and lines that dont hold a valid position with
+	* a legal move, or whose bm or am moves arent legal
+	*/
+	static bool parse(const std::string& line, EpdPosition& position);
+
+	/**
+	* @brief the legal move of b written as san, with or without check marks and annotations like ! or ?. accepts 0-0 for O-O and
+	* promotions with or without the =, and ignores x and - marks. a null move if it names no legal move or more than one
+	*/
+	static Move parseSan(Board& b, const std::string& san);
+
+private:
+	/**
+	* @brief state shared by the threads of a run
+	*/
+	struct Progress {
+		std::ifstream file;
+		std::mutex fileMutex;
+		std::mutex outMutex;
+
+		/**
+		* @brief number of the last line read from file, guarded by fileMutex
+		*/
+		uint64_t lineNumber = 0;
+		std::atomic<uint64_t> positions{0};
+		std::atomic<uint64_t> skipped{0};
+		std::atomic<uint64_t> solved{0};
+		std::atomic<uint64_t> nodes{0};
+		std::atomic<int64_t> solveMs{0};
+	};
+
+	/**
+	* @brief one thread of a run, searches lines of the file until it runs out
+	*/
+	static void searchPositions(const Options& options, Progress& progress, std::ostream& out);
+};
+#endif
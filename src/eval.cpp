@@ -1,18 +1,67 @@
 #include "board.hpp"
 #include "transposition_table.hpp"
 #include "consts.hpp"
+#include "endgame.hpp"
 #include "eval.hpp"
+#include "eval_params.hpp"
 #include "lookup_tables.hpp"
 #include "move_gen.hpp"
+#include "nnue.hpp"
+#include "syzygy.hpp"
 #include "util.hpp"
 
 #include <algorithm>
-#include <chrono>
-#include <iostream>
 
-uint64_t Eval::totalNodesSearched = 0;
-std::array<std::array<Move, Eval::NUM_KILLER_MOVES>, Eval::MAX_SEARCH_DEPTH> Eval::killerMoves{};
-std::chrono::time_point<std::chrono::high_resolution_clock> Eval::m_iterative_deepening_cutoff_time = std::chrono::time_point<std::chrono::high_resolution_clock>::max();
+namespace {
+template <typename Table>
+constexpr int tableMin(const Table& table) {
+	int lowest = table[0];
+	for (int weight : table) lowest = std::min(lowest, weight);
+	return lowest;
+}
+
+template <typename Table>
+constexpr int tableMax(const Table& table) {
+	int highest = table[0];
+	for (int weight : table) highest = std::max(highest, weight);
+	return highest;
+}
+
+template <typename Table>
+constexpr int tableMagnitude(const Table& table) {
+	return std::max(tableMax(table), -tableMin(table));
+}
+
+/**
+* @brief lowest and highest sum of a weight over the two or three files pawnShelter looks at
+*/
+template <typename Table>
+constexpr int shelterMin(const Table& table) {
+	return std::min(2 * tableMin(table), 3 * tableMin(table));
+}
+
+template <typename Table>
+constexpr int shelterMax(const Table& table) {
+	return std::max(2 * tableMax(table), 3 * tableMax(table));
+}
+
+static_assert(tableMin(EvalParams::kingSafetyTable) >= 0, "king danger is a penalty, KING_TERMS_BOUND counts on it");
+
+/**
+* @brief how far the pawn shelter and king danger of both sides can move the middlegame score. each side scores its shield minus
+* the enemy storm minus its king danger, so the two sides can be apart by at most the distance between the best and worst of that
+*/
+constexpr int KING_TERMS_BOUND = (shelterMax(EvalParams::pawnShield) - shelterMin(EvalParams::pawnStorm)) -
+								 (shelterMin(EvalParams::pawnShield) - shelterMax(EvalParams::pawnStorm) - tableMax(EvalParams::kingSafetyTable));
+
+/**
+* @brief the most a single piece can get or lose for its mobility
+*/
+constexpr std::array<int, NONE_PIECE> MG_MOBILITY_BOUND = {0, tableMagnitude(EvalParams::mgQueenMobility), tableMagnitude(EvalParams::mgRookMobility),
+														   tableMagnitude(EvalParams::mgBishopMobility), tableMagnitude(EvalParams::mgKnightMobility), 0};
+constexpr std::array<int, NONE_PIECE> EG_MOBILITY_BOUND = {0, tableMagnitude(EvalParams::egQueenMobility), tableMagnitude(EvalParams::egRookMobility),
+														   tableMagnitude(EvalParams::egBishopMobility), tableMagnitude(EvalParams::egKnightMobility), 0};
+}  // namespace
 
 // Centipawns Eval::countMaterial(const Board& b) {
 // 	Centipawns material = 0;
@@ -29,61 +78,239 @@ std::chrono::time_point<std::chrono::high_resolution_clock> Eval::m_iterative_de
 // }
 
 Centipawns Eval::evaluate(Board& b) {
+	bool lazyExit;
+	return evaluate(b, -INF_SCORE, INF_SCORE, lazyExit);
+}
+
+Centipawns Eval::evaluate(SearchContext& ctx, Board& b, Centipawns alpha, Centipawns beta) {
+	bool lazyExit;
+	Centipawns score = evaluate(b, alpha, beta, lazyExit);
+	ctx.lazyEvals += lazyExit;
+	return score;
+}
+
+Centipawns Eval::evaluate(Board& b, Centipawns alpha, Centipawns beta, bool& lazyExit) {
+	lazyExit = false;
 	if (!b.moveGenerator.hasLegalMoves()) {
 		// add hmClock to prioritize quicker checkmates
 		return b.moveGenerator.inCheck() ? -INF_SCORE + (int)b.boardState.hmClock : 0;
 	}
 
-	Centipawns score = b.boardState.material;
+	// endgames with a known result are scored without the evaluation, drawish ones scale it down
+	int scale = Endgame::SCALE_NORMAL;
+	if (const Endgame::Entry* endgame = Endgame::probe(b)) {
+		if (endgame->evaluate) {
+			Centipawns score = endgame->evaluate(b, endgame->strongSide);
+			return b.boardState.sideToMove == endgame->strongSide ? score : -score;
+		}
+		scale = endgame->scale(b, endgame->strongSide);
+	}
+
+	if (const NNUE::Accumulator* acc = b.accumulator()) {
+		return NNUE::evaluate(*acc, b.boardState.sideToMove) * scale / Endgame::SCALE_NORMAL;
+	}
+
+	// material and piece square values are kept up to date by the board, the piece terms are computed here
+	int mg = b.boardState.mgScore;
+	int eg = b.boardState.egScore;
+
+	// the terms below cant move the score by more than lazyMargin, so when material and piece squares alone are that far outside
+	// the window the rest wouldnt change the outcome. scaling shrinks the terms as much as the score, so the margin still holds
+	int stmSign			 = b.boardState.sideToMove == WHITE ? 1 : -1;
+	Centipawns lazyScore = taper(mg, eg, b.boardState.phase) * stmSign * scale / Endgame::SCALE_NORMAL;
+	int margin			 = lazyMargin(b);
+	if (lazyScore - margin >= beta || lazyScore + margin <= alpha) {
+		lazyExit = true;
+		return lazyScore;
+	}
+
+	addPieceTerms<false>(b, mg, eg, nullptr);
+	return taper(mg, eg, b.boardState.phase) * stmSign * scale / Endgame::SCALE_NORMAL;
+}
+
+int Eval::lazyMargin(const Board& b) {
+	int mg = KING_TERMS_BOUND, eg = 0;
+	for (Piece pieceType : {QUEEN, ROOK, BISHOP, KNIGHT}) {
+		int count = std::popcount(b.boardState.pieces[WHITE][pieceType] | b.boardState.pieces[BLACK][pieceType]);
+		mg += count * MG_MOBILITY_BOUND[pieceType];
+		eg += count * EG_MOBILITY_BOUND[pieceType];
+	}
+	// the taper lands between the two, and its rounding and the one of the scale are a centipawn each
+	return std::max(mg, eg) + 2;
+}
+
+template <bool TRACE>
+void Eval::addPieceTerms(const Board& b, int& mg, int& eg, EvalTrace* trace) {
+	// pawn and king attacks and the king zones go in first, so the pieces below can be checked against the zone as they are generated
+	AttackMap attacks;
 	for (Color color : {WHITE, BLACK}) {
-		for (Piece pieceType : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+		Bitboard pawns	  = b.boardState.pieces[color][PAWN];
+		Square kingSquare = (Square)bitscan(b.boardState.pieces[color][KING]);
+		Bitboard ring	  = LookupTables::s_kingAttacks[kingSquare];
+		Bitboard around	  = ring | (1UL << kingSquare);
+
+		attacks.attackedBy[color][PAWN] = color == WHITE ? ((pawns & ~aFile) << 7) | ((pawns & ~hFile) << 9)
+														 : ((pawns & ~hFile) >> 7) | ((pawns & ~aFile) >> 9);
+		attacks.attackedBy[color][KING] = ring;
+		attacks.attackedByAll[color]	= attacks.attackedBy[color][PAWN] | ring;
+		attacks.kingZone[color]			= around | (color == WHITE ? around << 8 : around >> 8);
+	}
+
+	Bitboard allPieces = b.boardState.allColorPieces[WHITE] | b.boardState.allColorPieces[BLACK];
+	for (Color color : {WHITE, BLACK}) {
+		int stmMultiplier	= color == WHITE ? 1 : -1;
+		Bitboard friendly	= b.boardState.allColorPieces[color];
+		Bitboard enemyZone	= attacks.kingZone[!color];
+		for (Piece pieceType : {QUEEN, ROOK, BISHOP, KNIGHT}) {
 			Bitboard piece = b.boardState.pieces[color][pieceType];
 			while (piece) {
-				int stmMultiplier = color == WHITE ? 1 : -1;
-
-				score += stmMultiplier * positionalValue(pieceType, color, (Square)bitscan(piece));
-				Bitboard allPieces = b.boardState.allColorPieces[WHITE] | b.boardState.allColorPieces[BLACK];
-				Bitboard friendly  = color == WHITE ? b.boardState.allColorPieces[WHITE] : b.boardState.allColorPieces[BLACK];
 				Square pieceSquare = (Square)bitscan(piece);
+				Bitboard pieceAttacks;
+				int mobility;
 				switch (pieceType) {
 					case QUEEN: {
-						Bitboard attacks = b.moveGenerator.genStraightRays(pieceSquare, allPieces) | b.moveGenerator.genDiagonalRays(pieceSquare, allPieces);
-						attacks &= ~friendly;
-						score += stmMultiplier * queenMobilityScore[std::popcount(attacks)];
+						pieceAttacks = b.moveGenerator.genStraightRays(pieceSquare, allPieces) | b.moveGenerator.genDiagonalRays(pieceSquare, allPieces);
+						mobility	 = std::popcount(pieceAttacks & ~friendly);
+						mg += stmMultiplier * EvalParams::mgQueenMobility[mobility];
+						eg += stmMultiplier * EvalParams::egQueenMobility[mobility];
+						if constexpr (TRACE) trace->queenMobility[mobility] += stmMultiplier;
 						break;
 					}
 					case ROOK: {
-						Bitboard attacks = b.moveGenerator.genStraightRays(pieceSquare, allPieces);
-						attacks &= ~friendly;
-						score += stmMultiplier * rookMobilityScore[std::popcount(attacks)];
+						pieceAttacks = b.moveGenerator.genStraightRays(pieceSquare, allPieces);
+						mobility	 = std::popcount(pieceAttacks & ~friendly);
+						mg += stmMultiplier * EvalParams::mgRookMobility[mobility];
+						eg += stmMultiplier * EvalParams::egRookMobility[mobility];
+						if constexpr (TRACE) trace->rookMobility[mobility] += stmMultiplier;
 						break;
 					}
 					case BISHOP: {
-						Bitboard attacks = b.moveGenerator.genDiagonalRays(pieceSquare, allPieces);
-						attacks &= ~friendly;
-						score += stmMultiplier * bishopMobilityScore[std::popcount(attacks)];
-						break;
-					}
-					case KNIGHT: {
-						Bitboard attacks = LookupTables::s_knightAttacks[pieceSquare];
-						attacks &= ~friendly;
-						score += stmMultiplier * knightMobilityScore[std::popcount(attacks)];
+						pieceAttacks = b.moveGenerator.genDiagonalRays(pieceSquare, allPieces);
+						mobility	 = std::popcount(pieceAttacks & ~friendly);
+						mg += stmMultiplier * EvalParams::mgBishopMobility[mobility];
+						eg += stmMultiplier * EvalParams::egBishopMobility[mobility];
+						if constexpr (TRACE) trace->bishopMobility[mobility] += stmMultiplier;
 						break;
 					}
 					default: {
+						pieceAttacks = LookupTables::s_knightAttacks[pieceSquare];
+						mobility	 = std::popcount(pieceAttacks & ~friendly);
+						mg += stmMultiplier * EvalParams::mgKnightMobility[mobility];
+						eg += stmMultiplier * EvalParams::egKnightMobility[mobility];
+						if constexpr (TRACE) trace->knightMobility[mobility] += stmMultiplier;
 						break;
 					}
 				}
 
+				attacks.attackedBy[color][pieceType] |= pieceAttacks;
+				attacks.attackedByAll[color] |= pieceAttacks;
+				if (Bitboard zoneAttacks = pieceAttacks & enemyZone) {
+					attacks.kingAttackers[color]++;
+					attacks.kingAttackUnits[color] += EvalParams::kingAttackWeights[pieceType] * std::popcount(zoneAttacks);
+				}
+
 				piece ^= LS1B(piece);
 			};
 		}
 	}
-	return score * (b.boardState.sideToMove == WHITE ? 1 : -1);
+
+	for (Color color : {WHITE, BLACK}) {
+		int stmMultiplier = color == WHITE ? 1 : -1;
+		mg += stmMultiplier * (pawnShelter<TRACE>(b, color, trace) - kingDanger<TRACE>(b, color, attacks, trace));
+	}
+}
+
+Centipawns Eval::trace(const Board& b, EvalTrace& trace) {
+	trace = EvalTrace{};
+	// the board keeps material and piece squares as sums, so the trace counts them piece by piece
+	for (Color color : {WHITE, BLACK}) {
+		int stmMultiplier = color == WHITE ? 1 : -1;
+		for (Piece pieceType : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+			Bitboard piece = b.boardState.pieces[color][pieceType];
+			while (piece) {
+				int square = bitscan(piece);
+				trace.pieceValues[pieceType] += stmMultiplier;
+				trace.psqt[pieceType][color == WHITE ? square : square ^ 56] += stmMultiplier;
+				piece ^= LS1B(piece);
+			}
+		}
+	}
+	int mg = b.boardState.mgScore;
+	int eg = b.boardState.egScore;
+	addPieceTerms<true>(b, mg, eg, &trace);
+	return taper(mg, eg, b.boardState.phase);
+}
+
+template <bool TRACE>
+int Eval::kingDanger(const Board& b, Color color, const AttackMap& attacks, EvalTrace* trace) {
+	Color attacker	  = (Color)!color;
+	Square kingSquare = (Square)bitscan(b.boardState.pieces[color][KING]);
+	Bitboard occ	  = b.boardState.allColorPieces[WHITE] | b.boardState.allColorPieces[BLACK];
+
+	// squares a piece could check the king from without being taken, going by the attack map rather than a full exchange
+	Bitboard safe		  = ~attacks.attackedByAll[color] & ~b.boardState.allColorPieces[attacker];
+	Bitboard straight	  = MoveGen::genStraightRays(kingSquare, occ) & safe;
+	Bitboard diagonal	  = MoveGen::genDiagonalRays(kingSquare, occ) & safe;
+	Bitboard knightChecks = LookupTables::s_knightAttacks[kingSquare] & safe;
+
+	int checkUnits = EvalParams::safeCheckWeights[QUEEN] * std::popcount((straight | diagonal) & attacks.attackedBy[attacker][QUEEN]) +
+					 EvalParams::safeCheckWeights[ROOK] * std::popcount(straight & attacks.attackedBy[attacker][ROOK]) +
+					 EvalParams::safeCheckWeights[BISHOP] * std::popcount(diagonal & attacks.attackedBy[attacker][BISHOP]) +
+					 EvalParams::safeCheckWeights[KNIGHT] * std::popcount(knightChecks & attacks.attackedBy[attacker][KNIGHT]);
+
+	// a lone piece near the king is rarely a threat unless it can also check
+	if (attacks.kingAttackers[attacker] < 2 && !checkUnits) return 0;
+	int units = std::min<int>(attacks.kingAttackUnits[attacker] + checkUnits, EvalParams::kingSafetyTable.size() - 1);
+	if constexpr (TRACE) trace->kingSafety[units] -= color == WHITE ? 1 : -1;
+	return EvalParams::kingSafetyTable[units];
+}
+
+template <bool TRACE>
+int Eval::pawnShelter(const Board& b, Color color, EvalTrace* trace) {
+	Square kingSquare = (Square)bitscan(b.boardState.pieces[color][KING]);
+	int kingFile	  = kingSquare % 8;
+	int kingRank	  = kingSquare / 8;
+
+	// everything on the ranks in front of the king, from its sides POV
+	Bitboard inFront = color == WHITE ? (~0UL << 8) << (8 * kingRank) : (~0UL >> 8) >> (8 * (7 - kingRank));
+	int score		 = 0;
+	for (int file = std::max(kingFile - 1, 0); file <= std::min(kingFile + 1, 7); file++) {
+		Bitboard column = (aFile << file) & inFront;
+		for (Color owner : {color, (Color)!color}) {
+			Bitboard pawns = b.boardState.pieces[owner][PAWN] & column;
+			int distance   = 0;
+			if (pawns) {
+				int nearest = color == WHITE ? bitscan(pawns) : 63 - std::countl_zero(pawns);
+				distance	= std::abs(nearest / 8 - kingRank);
+			}
+			if (owner == color) {
+				int index = std::min<int>(distance, EvalParams::pawnShield.size() - 1);
+				score += EvalParams::pawnShield[index];
+				if constexpr (TRACE) trace->pawnShield[index] += color == WHITE ? 1 : -1;
+			} else {
+				int index = std::min<int>(distance, EvalParams::pawnStorm.size() - 1);
+				score -= EvalParams::pawnStorm[index];
+				if constexpr (TRACE) trace->pawnStorm[index] -= color == WHITE ? 1 : -1;
+			}
+		}
+	}
+	return score;
 }
 
 Centipawns Eval::quiescence_search(Board& b, Centipawns alpha, Centipawns beta) {
-	Centipawns static_eval = evaluate(b);
+	SearchContext ctx;
+	return quiescence_search(ctx, b, alpha, beta);
+}
+
+Centipawns Eval::quiescence_search(SearchContext& ctx, Board& b, Centipawns alpha, Centipawns beta, int plyFromRoot) {
+	// checked before the node is counted, so a node limit is never overshot. the score is garbage, search throws it away
+	if (ctx.stopped()) {
+		return alpha;
+	}
+	ctx.qnodes++;
+	ctx.tick();
+	ctx.selDepth = std::max(ctx.selDepth, plyFromRoot);
+	Centipawns static_eval = evaluate(ctx, b, alpha, beta);
 
 	Centipawns bestScore = static_eval;
 	if (bestScore >= beta) {
@@ -93,11 +320,39 @@ Centipawns Eval::quiescence_search(Board& b, Centipawns alpha, Centipawns beta)
 		alpha = bestScore;
 	}
 
+	bool inCheck = b.moveGenerator.inCheck();
+
+	// big delta pruning. if capturing a queen, plus promoting a pawn if one is about to, still cant reach alpha, no capture will
+	if (!inCheck) {
+		Bitboard promotingPawns = b.boardState.pieces[b.boardState.sideToMove][PAWN] & (b.boardState.sideToMove == WHITE ? seventhRank : secondRank);
+		int bigDelta			= pieceToCentipawns[QUEEN] + DELTA_MARGIN;
+		if (promotingPawns) {
+			bigDelta += pieceToCentipawns[QUEEN] - pieceToCentipawns[PAWN];
+		}
+		if (static_eval + bigDelta < alpha) {
+			return bestScore;
+		}
+	}
+
 	// we only want to generate legal captures for quiescence_search, but if the king is in check, all legal moves must be searched
-	Moves moves = b.moveGenerator.inCheck() ? b.moveGenerator.genLegalMoves() : b.moveGenerator.genLegalCaptures();
+	Moves moves = inCheck ? b.moveGenerator.genLegalMoves() : b.moveGenerator.genLegalCaptures();
 	for (const Move& m : moves) {
+		if (!inCheck) {
+			// delta pruning. the captured material plus a positional margin isnt enough to raise the score to alpha
+			if (!(m.getFlags() & PROMOTION)) {
+				int optimisticScore = static_eval + capturedPieceValue(b, m) + DELTA_MARGIN;
+				if (optimisticScore <= alpha) {
+					bestScore = std::max<int>(bestScore, optimisticScore);
+					continue;
+				}
+			}
+			// captures that lose material can't raise the stand pat score
+			if (staticExchangeEvaluation(b, m) < 0) {
+				continue;
+			}
+		}
 		b.execute(m);
-		Centipawns score = -quiescence_search(b, -beta, -alpha);
+		Centipawns score = -quiescence_search(ctx, b, -beta, -alpha, plyFromRoot + 1);
 		b.undoMove();
 
 		if (score >= beta) {
@@ -114,29 +369,51 @@ Centipawns Eval::quiescence_search(Board& b, Centipawns alpha, Centipawns beta)
 }
 
 SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previousPV, Centipawns alpha, Centipawns beta, int plyFromRoot) {
+	SearchContext ctx;
+	ctx.previousPV		= previousPV;
+	SearchResult result = search(ctx, b, depthLeft, alpha, beta, plyFromRoot);
+	topLine				= Moves(ctx.pvTable[plyFromRoot].begin() + plyFromRoot, ctx.pvTable[plyFromRoot].begin() + ctx.pvLength[plyFromRoot]);
+	return result;
+}
+
+SearchResult Eval::search(SearchContext& ctx, Board& b, int depthLeft, Centipawns alpha, Centipawns beta, int plyFromRoot) {
+	ctx.clearPV(plyFromRoot);
+	if (plyFromRoot == 0) ctx.rootBestScore = NONE_SCORE;
 	if (b.is50MoveRule() || b.isInsufficientMaterial()) {
 		return {0, SEARCH_COMPLETE};
 	}
-	if (depthLeft <= 0) {
-		return {quiescence_search(b, alpha, beta), SEARCH_COMPLETE};
+	// repeating a position inside the search means neither side could make progress, so treat it as a draw
+	if (plyFromRoot > 0 && b.isRepetition()) {
+		return {DRAW_SCORE, SEARCH_COMPLETE};
+	}
+	if (depthLeft <= 0 || plyFromRoot >= SearchContext::MAX_SEARCH_DEPTH) {
+		Centipawns score = quiescence_search(ctx, b, alpha, beta, plyFromRoot);
+		return {score, ctx.stopped() ? SEARCH_ABORTED : SEARCH_COMPLETE};
 	}
 
 	Centipawns originalAlpha = alpha;
 
-	MoveGen& mg = b.moveGenerator;
-	Moves moves = mg.genLegalMoves();
+	MoveGen& mg		 = b.moveGenerator;
+	bool inCheck	 = mg.inCheck();
+	Color us		 = b.boardState.sideToMove;
+	SearchStackEntry& ss = ctx.stack[plyFromRoot];
+	ss.staticEval	 = NONE_SCORE;
+
+	const Move killerMove1 = ctx.killerMoves[plyFromRoot][0];
+	const Move killerMove2 = ctx.killerMoves[plyFromRoot][1];
 
-	const Move killerMove1 = killerMoves[plyFromRoot][0];
-	const Move killerMove2 = killerMoves[plyFromRoot][1];
+	// pv nodes never take tt cutoffs, so the line from the root always runs all the way down to quiescence search
+	bool isPVNode = beta - alpha > 1;
 
-	const TTEntry& entry = TranspositionTable::getEntry(b.boardState.hash);
+	// with root moves excluded the root score is only the best of the remaining moves, which must not end up in the tt
+	bool excludingRootMoves = plyFromRoot == 0 && (!ctx.excludedRootMoves.empty() || !ctx.rootMoves.empty());
+
+	const TTEntry& entry = ctx.tt->getEntry(b.boardState.hash);
 	Move ttMove;
 	if (entry.partial_hash == (b.boardState.hash & 0xFFFF) && entry.bestMove.piece != NONE_PIECE) {
 		ttMove = TranspositionTable::getMove(entry.bestMove);
-		if (entry.depth >= depthLeft) {
+		if (!isPVNode && entry.depth >= depthLeft) {
 			if (entry.flag == EXACT) {
-				topLine.clear();
-				topLine.push_back(TranspositionTable::getMove(entry.bestMove));
 				return {(Centipawns)entry.score, SEARCH_COMPLETE};
 			} else if (entry.flag == LOWER_BOUND) {
 				alpha = std::max(alpha, entry.score);
@@ -145,16 +422,60 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 			}
 		}
 		if (alpha >= beta) {
-			topLine.clear();
-			topLine.push_back(TranspositionTable::getMove(entry.bestMove));
 			return {(Centipawns)entry.score, SEARCH_COMPLETE};
 		}
 	}
 
+	// tablebase probe, only right after a capture or pawn move so the 50 move counter hasnt eaten into the stored result. not needed
+	// when the root already has a table, its dtz ranking keeps the search on the right moves. a set that failed its self check is
+	// never probed
+	if (plyFromRoot > 0 && b.boardState.hmClock == 0 && ctx.rootMoves.empty() && Syzygy::canProbe(b) && Syzygy::verified()) {
+		Syzygy::ProbeState state;
+		Syzygy::WDLScore wdl = Syzygy::probeWDL(b, state);
+		if (state != Syzygy::PROBE_FAIL) {
+			ctx.tbHits++;
+			// cursed wins and blessed losses are draws under the 50 move rule, kept just off zero
+			Centipawns score = wdl == Syzygy::WDL_WIN	 ? TB_WIN_SCORE - plyFromRoot
+							 : wdl == Syzygy::WDL_LOSS ? -TB_WIN_SCORE + plyFromRoot
+													   : DRAW_SCORE + 2 * wdl;
+			// a win is only a lower bound, there could still be a mate, and a loss only an upper bound
+			if ((wdl == Syzygy::WDL_WIN && score >= beta) || (wdl == Syzygy::WDL_LOSS && score <= alpha) || std::abs(wdl) < 2) {
+				return {score, SEARCH_COMPLETE};
+			}
+		}
+	}
+
+	// shallow depth pruning based on the static eval. never in check or at pv nodes, and never when mate scores are involved
+	bool canFutilityPrune = false;
+	if (!isPVNode && !inCheck && depthLeft <= std::max({RFP_DEPTH, RAZOR_DEPTH, FUTILITY_DEPTH})) {
+		Centipawns staticEval = evaluate(b);
+		ss.staticEval		  = staticEval;
+		if (!isMateScore(staticEval) && !isMateScore(alpha) && !isMateScore(beta)) {
+			// reverse futility pruning. the position is so far above beta that giving up a margin per ply still fails high
+			if (depthLeft <= RFP_DEPTH && staticEval - RFP_MARGIN * depthLeft >= beta) {
+				return {staticEval, SEARCH_COMPLETE};
+			}
+			// razoring. the position is so far below alpha that only captures could save it, so drop into quiescence search
+			if (depthLeft <= RAZOR_DEPTH && staticEval + RAZOR_MARGIN * depthLeft < alpha) {
+				Centipawns score = quiescence_search(ctx, b, alpha, beta, plyFromRoot);
+				if (ctx.stopped()) {
+					return {NONE_SCORE, SEARCH_ABORTED};
+				}
+				if (score <= alpha) {
+					return {score, SEARCH_COMPLETE};
+				}
+			}
+			// futility pruning. quiet moves near the horizon cant make up the gap to alpha
+			canFutilityPrune = depthLeft <= FUTILITY_DEPTH && staticEval + FUTILITY_MARGIN * depthLeft <= alpha;
+		}
+	}
+
+	Moves moves = mg.genLegalMoves();
+
 	const uint32_t k1Key = killerMove1.getSignature();
 	const uint32_t k2Key = killerMove2.getSignature();
 	const uint32_t ttKey = ttMove.getSignature();
-	const uint32_t pvKey = (plyFromRoot < previousPV.size()) ? previousPV[plyFromRoot].getSignature() : 0;
+	const uint32_t pvKey = (plyFromRoot < ctx.previousPV.size()) ? ctx.previousPV[plyFromRoot].getSignature() : 0;
 
 	for (Move& m : moves) {
 		uint32_t mKey = m.getSignature();
@@ -163,6 +484,8 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 		else if (mKey == pvKey) m.setScore(MAX_MOVE_SCORE - 1);
 		else if (mKey == k1Key) m.setScore(KILLER_MOVE_1_SCORE);
 		else if (mKey == k2Key) m.setScore(KILLER_MOVE_2_SCORE);
+		else if (m.getFlags() & CAPTURE && staticExchangeEvaluation(b, m) < 0) m.setScore(BAD_CAPTURE_SCORE);
+		else if (!(m.getFlags() & (CAPTURE | PROMOTION))) m.setScore(ctx.historyScore(us, m));
 	}
 
 	/*
@@ -173,9 +496,10 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 	// 	return a.getScore() > b.getScore();
 	// });
 
-	Moves subline;
 	int movesSearched = 0;
 	Move bestMove;
+	std::array<Move, 64> quietsTried;
+	int numQuietsTried = 0;
 	for (size_t i = 0; i < moves.size(); i++) {
 		int bestIdx = i;
 		for (size_t j = i + 1; j < moves.size(); j++) {
@@ -186,17 +510,31 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 		std::swap(moves[i], moves[bestIdx]);
 
 		const Move& m = moves[i];
-		if (std::chrono::high_resolution_clock::now() > m_iterative_deepening_cutoff_time) {
+		if (ctx.stopped()) {
 			return {NONE_SCORE, SEARCH_ABORTED};
 		}
+		if (excludingRootMoves && ctx.isExcludedRootMove(m)) {
+			continue;
+		}
+
+		// only captures already flagged as bad need their exchange rechecked against the depth scaled margin
+		if (!inCheck && movesSearched > 0 && depthLeft <= SEE_PRUNING_DEPTH && m.getScore() == BAD_CAPTURE_SCORE &&
+			staticExchangeEvaluation(b, m) < -SEE_PRUNING_MARGIN * depthLeft) {
+			continue;
+		}
+		bool isQuietMove = !(m.getFlags() & (CAPTURE | PROMOTION));
+		if (canFutilityPrune && movesSearched > 0 && isQuietMove) {
+			continue;
+		}
 		movesSearched++;
-		totalNodesSearched++;
+		ctx.nodes++;
+		ctx.tick();
+		ss.currentMove = m;
 		b.execute(m);
 
 		Centipawns score = -INF_SCORE;
 
 		int depthReduction = 0;
-		bool isQuietMove   = !(m.getFlags() & (CAPTURE | PROMOTION));
 
 		// lmr
 		if (isQuietMove && movesSearched > 3 && depthLeft >= 3) {
@@ -205,7 +543,7 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 
 		if (movesSearched == 1) {
 			// full window search
-			auto [childScore, searchState] = search(subline, b, depthLeft - 1, previousPV, -beta, -alpha, plyFromRoot + 1);
+			auto [childScore, searchState] = search(ctx, b, depthLeft - 1, -beta, -alpha, plyFromRoot + 1);
 			if (searchState == SEARCH_ABORTED) {
 				b.undoMove();
 				return {NONE_SCORE, SEARCH_ABORTED};
@@ -214,7 +552,7 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 		} else {
 			// zero window search
 			int newDepth				   = depthLeft - 1 - depthReduction;
-			auto [childScore, searchState] = search(subline, b, newDepth, previousPV, -alpha - 1, -alpha, plyFromRoot + 1);
+			auto [childScore, searchState] = search(ctx, b, newDepth, -alpha - 1, -alpha, plyFromRoot + 1);
 			if (searchState == SEARCH_ABORTED) {
 				b.undoMove();
 				return {NONE_SCORE, SEARCH_ABORTED};
@@ -224,7 +562,7 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 			// lmr failed high
 			if (depthReduction > 0 && score > alpha) {
 				// re-search full depth
-				auto [childScore, searchState] = search(subline, b, depthLeft - 1, previousPV, -beta, -alpha, plyFromRoot + 1);
+				auto [childScore, searchState] = search(ctx, b, depthLeft - 1, -beta, -alpha, plyFromRoot + 1);
 				if (searchState == SEARCH_ABORTED) {
 					b.undoMove();
 					return {NONE_SCORE, SEARCH_ABORTED};
@@ -233,7 +571,7 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 			}
 			if (score > alpha && beta - alpha > 1) {
 				// re-search full window
-				auto [childScore, searchState] = search(subline, b, depthLeft - 1, previousPV, -beta, -alpha, plyFromRoot + 1);
+				auto [childScore, searchState] = search(ctx, b, depthLeft - 1, -beta, -alpha, plyFromRoot + 1);
 				if (searchState == SEARCH_ABORTED) {
 					b.undoMove();
 					return {NONE_SCORE, SEARCH_ABORTED};
@@ -243,117 +581,279 @@ SearchResult Eval::search(Moves& topLine, Board& b, int depthLeft, Moves& previo
 		}
 		b.undoMove();
 		if (score >= beta) {
-			if (m != killerMoves[plyFromRoot][0]) {
-				killerMoves[plyFromRoot][1] = killerMoves[plyFromRoot][0];
-				killerMoves[plyFromRoot][0] = m;
+			ctx.storeKiller(plyFromRoot, m);
+			if (isQuietMove) {
+				ctx.updateHistory(us, m, quietsTried.data(), numQuietsTried, depthLeft);
 			}
-			topLine.clear();
-			topLine.push_back(m);
-			topLine.insert(topLine.end(), subline.begin(), subline.end());
-			TranspositionTable::add(b.boardState.hash, score, depthLeft, TTFlag::LOWER_BOUND, m);
+			ctx.updatePV(plyFromRoot, m);
+			if (plyFromRoot == 0) ctx.rootBestScore = score;
+			if (!excludingRootMoves) ctx.tt->add(b.boardState.hash, score, depthLeft, TTFlag::LOWER_BOUND, m);
 			return {score, SEARCH_COMPLETE};
 		}
 		if (score > alpha) {
 			alpha	 = score;
 			bestMove = m;
-			topLine.clear();
-			topLine.push_back(m);
-			topLine.insert(topLine.end(), subline.begin(), subline.end());
+			ctx.updatePV(plyFromRoot, m);
+			if (plyFromRoot == 0) ctx.rootBestScore = score;
 		}
+		if (isQuietMove && numQuietsTried < quietsTried.size()) {
+			quietsTried[numQuietsTried++] = m;
+		}
+	}
+	if (excludingRootMoves) {
+		return {alpha, SEARCH_COMPLETE};
 	}
 	if (alpha <= originalAlpha) {
-		TranspositionTable::add(b.boardState.hash, alpha, depthLeft, TTFlag::UPPER_BOUND, bestMove);
+		ctx.tt->add(b.boardState.hash, alpha, depthLeft, TTFlag::UPPER_BOUND, bestMove);
 	} else if (alpha >= beta) {
-		TranspositionTable::add(b.boardState.hash, alpha, depthLeft, TTFlag::LOWER_BOUND, bestMove);
+		ctx.tt->add(b.boardState.hash, alpha, depthLeft, TTFlag::LOWER_BOUND, bestMove);
 	} else {
-		TranspositionTable::add(b.boardState.hash, alpha, depthLeft, TTFlag::EXACT, bestMove);
+		ctx.tt->add(b.boardState.hash, alpha, depthLeft, TTFlag::EXACT, bestMove);
 	}
 	return {alpha, SEARCH_COMPLETE};
 }
 
 Centipawns Eval::iterative_deepening_ply(Moves& topLine, Board& b, int maxDepth) {
-	Centipawns finalScore;
-	Moves previousPV;
-
-	auto searchStartTime = std::chrono::high_resolution_clock::now();
-	for (size_t depth = 1; depth <= maxDepth; depth++) {
-		auto [eval, searchState] = search(topLine, b, depth, previousPV, -INF_SCORE, INF_SCORE, 0);
-
-		if (topLine.size() < depth) {
-			// early alpha beta cutoff
-			// fill the rest of the line with tt moves
-			Board copy = b;
-			for (Move m : topLine) copy.execute(m);
-			int topLineSize = topLine.size();
-			for (size_t i = 0; i < depth - topLineSize; i++) {
-				const TTEntry& entry = TranspositionTable::getEntry(copy.boardState.hash);
-				if (entry.partial_hash == (copy.boardState.hash & 0xFFFF) && entry.bestMove.piece != NONE_PIECE) {
-					Move m = TranspositionTable::getMove(entry.bestMove);
-					topLine.push_back(m);
-					copy.execute(m);
-				} else break;
+	SearchContext ctx;
+	return iterative_deepening_ply(ctx, topLine, b, maxDepth);
+}
+
+Centipawns Eval::iterative_deepening_ply(SearchContext& ctx, Moves& topLine, Board& b, int maxDepth) {
+	return iterative_deepening(ctx, topLine, b, TimeControl(), maxDepth);
+}
+
+Centipawns Eval::iterative_deepening_time(Moves& topLine, Board& b, int maxTimeMs) {
+	SearchContext ctx;
+	return iterative_deepening_time(ctx, topLine, b, maxTimeMs);
+}
+
+Centipawns Eval::iterative_deepening_time(SearchContext& ctx, Moves& topLine, Board& b, int maxTimeMs) {
+	TimeControl tc;
+	tc.moveTimeMs = maxTimeMs;
+	return iterative_deepening_time(ctx, topLine, b, tc);
+}
+
+Centipawns Eval::iterative_deepening_time(SearchContext& ctx, Moves& topLine, Board& b, const TimeControl& tc) {
+	return iterative_deepening(ctx, topLine, b, tc, SearchContext::MAX_SEARCH_DEPTH);
+}
+
+Centipawns Eval::iterative_deepening_nodes(SearchContext& ctx, Moves& topLine, Board& b, uint64_t maxNodes) {
+	ctx.nodeLimit	  = maxNodes;
+	Centipawns score = iterative_deepening(ctx, topLine, b, TimeControl(), SearchContext::MAX_SEARCH_DEPTH);
+	ctx.nodeLimit	  = 0;
+	return score;
+}
+
+Centipawns Eval::iterative_deepening(SearchContext& ctx, Moves& topLine, Board& b, const TimeControl& tc, int maxDepth) {
+	TimeManager tm;
+	// a clock always applies, even to a deterministic search, which is only reproducible without one
+	tm.start(tc);
+	ctx.startSearch(tm.hardLimitMs());
+	probeRootTablebases(ctx, b);
+
+	Centipawns finalScore = NONE_SCORE;
+	int completedDepth	  = 0;
+	for (int depth = 1; depth <= std::min(maxDepth, SearchContext::MAX_SEARCH_DEPTH); depth++) {
+		auto [eval, searchState] = search(ctx, b, depth, -INF_SCORE, INF_SCORE, 0);
+		if (searchState == SearchState::SEARCH_ABORTED) {
+			// root moves that finished before the abort were searched to the full depth, so if one of them
+			// is already the best move of this iteration it is better information than the last iteration
+			if (ctx.rootBestScore != NONE_SCORE && ctx.pvLength[0] > 0) {
+				finalScore	   = ctx.rootBestScore;
+				ctx.previousPV = ctx.principalVariation();
+				completedDepth = depth;
+				reportIteration(ctx, depth, finalScore, true);
 			}
+			break;
 		}
 
-		for (Move m : topLine) {
-			std::cout << m.notation() << " ";
-		}
-		std::cout << " (depth " << depth << ")\n";
+		finalScore	   = eval;
+		ctx.previousPV = ctx.principalVariation();
+		completedDepth = depth;
+		reportIteration(ctx, depth, finalScore, false);
 
-		finalScore = eval;
-		previousPV = std::move(topLine);
+		// a forced mate wont change with more depth
 		if (abs(finalScore) >= INF_SCORE - 2000) break;
+		if (ctx.previousPV.empty()) break;
+
+		tm.onIterationComplete(ctx.previousPV[0], finalScore);
+		if (!ctx.pondering() && !tm.shouldStartIteration(ctx.clockElapsedMs())) break;
+	}
+	// stopped before even the first iteration finished. any legal move beats returning nothing
+	if (ctx.previousPV.empty()) {
+		Moves legalMoves = ctx.rootMoves.empty() ? b.moveGenerator.genLegalMoves() : ctx.rootMoves;
+		if (!legalMoves.empty()) ctx.previousPV.push_back(legalMoves[0]);
+		finalScore = evaluate(b);
 	}
-	topLine = std::move(previousPV);
-	std::cout << "NPS: " << totalNodesSearched / std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - searchStartTime).count() << "\n";
+	topLine = ctx.previousPV;
+	if (ctx.listener) ctx.listener->onSearchEnd(searchInfo(ctx, completedDepth, finalScore, topLine, false));
 	return finalScore;
 }
 
-Centipawns Eval::iterative_deepening_time(Moves& topLine, Board& b, int maxTimeMs) {
-	Centipawns finalScore;
-	Moves previousPV;
-
-	m_iterative_deepening_cutoff_time = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(maxTimeMs);
-	int depth						  = 0;
-	auto searchStartTime			  = std::chrono::high_resolution_clock::now();
-	while (1) {
-		if (std::chrono::high_resolution_clock::now() > m_iterative_deepening_cutoff_time) break;
-		auto [eval, searchState] = search(topLine, b, ++depth, previousPV, -INF_SCORE, INF_SCORE, 0);
-		if (searchState == SearchState::SEARCH_ABORTED) break;
-
-		finalScore = eval;
-		previousPV = std::move(topLine);
-
-		if (topLine.size() < depth) {
-			// early alpha beta cutoff
-			// fill the rest of the line with tt moves
-			Board copy = b;
-			for (Move m : topLine) copy.execute(m);
-			int topLineSize = topLine.size();
-			for (size_t i = 0; i < depth - topLineSize; i++) {
-				const TTEntry& entry = TranspositionTable::getEntry(copy.boardState.hash);
-				if (entry.partial_hash == (copy.boardState.hash & 0xFFFF) && entry.bestMove.piece != NONE_PIECE) {
-					Move m = TranspositionTable::getMove(entry.bestMove);
-					topLine.push_back(m);
-					copy.execute(m);
-				} else break;
+std::vector<PVLine> Eval::iterative_deepening_multipv(SearchContext& ctx, Board& b, int numPV, const TimeControl& tc, int maxDepth) {
+	TimeManager tm;
+	tm.start(tc);
+	ctx.startSearch(tm.hardLimitMs());
+	probeRootTablebases(ctx, b);
+
+	numPV = std::min<int>(numPV, ctx.rootMoves.empty() ? b.moveGenerator.genLegalMoves().size() : ctx.rootMoves.size());
+	std::vector<PVLine> lines;
+	for (int depth = 1; depth <= std::min(maxDepth, SearchContext::MAX_SEARCH_DEPTH); depth++) {
+		std::vector<PVLine> depthLines;
+		ctx.excludedRootMoves.clear();
+		bool aborted = false;
+		for (int i = 0; i < numPV; i++) {
+			// each line orders its own move from the last depth first
+			ctx.previousPV				= i < (int)lines.size() ? lines[i].pv : Moves();
+			Centipawns previousScore	= i < (int)lines.size() ? lines[i].score : NONE_SCORE;
+			auto [score, searchState] = aspirationSearch(ctx, b, depth, previousScore);
+			if (searchState == SEARCH_ABORTED || ctx.pvLength[0] == 0) {
+				aborted = searchState == SEARCH_ABORTED;
+				break;
 			}
+			Moves pv = ctx.principalVariation();
+			depthLines.push_back({pv[0], score, depth, pv});
+			ctx.excludedRootMoves.push_back(pv[0]);
+		}
+		ctx.excludedRootMoves.clear();
+
+		// a half finished depth has fewer lines than the last one, so it is only used if no depth finished at all
+		if (aborted && !lines.empty()) break;
+		std::stable_sort(depthLines.begin(), depthLines.end(), [](const PVLine& x, const PVLine& y) {
+			return x.score > y.score;
+		});
+		lines = depthLines;
+		for (size_t i = 0; i < lines.size(); i++) {
+			ctx.previousPV = lines[i].pv;
+			reportIteration(ctx, depth, lines[i].score, aborted, i + 1);
 		}
+		if (aborted || lines.empty() || isMateScore(lines[0].score)) break;
+
+		tm.onIterationComplete(lines[0].move, lines[0].score);
+		if (!ctx.pondering() && !tm.shouldStartIteration(ctx.clockElapsedMs())) break;
+	}
+	// stopped before even the first line finished. any legal move beats returning nothing
+	if (lines.empty()) {
+		Moves legalMoves = ctx.rootMoves.empty() ? b.moveGenerator.genLegalMoves() : ctx.rootMoves;
+		if (!legalMoves.empty()) lines.push_back({legalMoves[0], evaluate(b), 0, {legalMoves[0]}});
+	}
+	ctx.previousPV = lines.empty() ? Moves() : lines[0].pv;
+	if (ctx.listener && !lines.empty()) ctx.listener->onSearchEnd(searchInfo(ctx, lines[0].depth, lines[0].score, lines[0].pv, false));
+	return lines;
+}
 
-		for (Move m : topLine) {
-			std::cout << m.notation() << " ";
+SearchResult Eval::aspirationSearch(SearchContext& ctx, Board& b, int depth, Centipawns previousScore) {
+	if (depth < ASPIRATION_DEPTH || previousScore == NONE_SCORE || isMateScore(previousScore)) {
+		return search(ctx, b, depth, -INF_SCORE, INF_SCORE, 0);
+	}
+	int delta		 = ASPIRATION_WINDOW;
+	Centipawns alpha = std::max<int>(previousScore - delta, -INF_SCORE);
+	Centipawns beta	 = std::min<int>(previousScore + delta, INF_SCORE);
+	while (true) {
+		SearchResult result = search(ctx, b, depth, alpha, beta, 0);
+		if (result.state == SEARCH_ABORTED) return result;
+		if (result.score <= alpha && alpha > -INF_SCORE) {
+			alpha = delta > ASPIRATION_MAX_DELTA ? -INF_SCORE : std::max<int>(result.score - delta, -INF_SCORE);
+		} else if (result.score >= beta && beta < INF_SCORE) {
+			beta = delta > ASPIRATION_MAX_DELTA ? INF_SCORE : std::min<int>(result.score + delta, INF_SCORE);
+		} else {
+			return result;
 		}
-		std::cout << " (depth " << depth << ")\n";
-		if (abs(finalScore) >= INF_SCORE - 2000) {
-			std::cout << "MATE FOUND\n";
-			break;
+		delta *= 2;
+	}
+}
+
+void Eval::probeRootTablebases(SearchContext& ctx, Board& b) {
+	ctx.rootMoves.clear();
+	if (!Syzygy::canProbe(b) || !Syzygy::verified()) return;
+	if (Syzygy::rootMoves(b, ctx.rootMoves)) ctx.tbHits += ctx.rootMoves.size();
+}
+
+void Eval::reportIteration(SearchContext& ctx, int depth, Centipawns score, bool partial, int multiPV) {
+	if (ctx.listener) ctx.listener->onIteration(searchInfo(ctx, depth, score, ctx.previousPV, partial, multiPV));
+}
+
+SearchInfo Eval::searchInfo(SearchContext& ctx, int depth, Centipawns score, const Moves& pv, bool partial, int multiPV) {
+	uint64_t nodes	  = ctx.nodes + ctx.qnodes;
+	int64_t elapsedMs = ctx.elapsedMs();
+	return {depth, ctx.selDepth, score, nodes, nodes * 1000 / std::max<int64_t>(1, elapsedMs), ctx.tt->hashfull(), elapsedMs, pv, partial, multiPV, ctx.tbHits};
+}
+
+Centipawns Eval::staticExchangeEvaluation(const Board& b, const Move& m) {
+	const Board::BoardState& bs = b.boardState;
+	Square to					= m.getTo();
+	Bitboard occ				= (bs.allColorPieces[WHITE] | bs.allColorPieces[BLACK]) ^ (1UL << m.getFrom());
+
+	// gain[i] is the material balance after the ith capture from the POV of the side that made it
+	std::array<int, 32> gain{};
+	gain[0] = capturedPieceValue(b, m);
+	if (m.getFlags() & EN_PASSANT) {
+		occ ^= 1UL << (to + (bs.sideToMove == WHITE ? -8 : 8));
+	}
+
+	Piece pieceOnSquare = m.getPieceType();
+	if (m.getFlags() & PROMOTION) {
+		gain[0] += pieceToCentipawns[m.getPromoPiece()] - pieceToCentipawns[PAWN];
+		pieceOnSquare = m.getPromoPiece();
+	}
+
+	const Bitboard diagonalSliders = bs.pieces[WHITE][BISHOP] | bs.pieces[BLACK][BISHOP] | bs.pieces[WHITE][QUEEN] | bs.pieces[BLACK][QUEEN];
+	const Bitboard straightSliders = bs.pieces[WHITE][ROOK] | bs.pieces[BLACK][ROOK] | bs.pieces[WHITE][QUEEN] | bs.pieces[BLACK][QUEEN];
+
+	Bitboard attackers = b.moveGenerator.attackersTo(to, occ);
+	Color side		   = (Color)!bs.sideToMove;
+	int depth		   = 0;
+	while (true) {
+		Bitboard sideAttackers = attackers & bs.allColorPieces[side];
+		if (!sideAttackers) break;
+
+		Piece nextAttacker		 = NONE_PIECE;
+		Bitboard nextAttackerBit = 0;
+		for (Piece p : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING}) {
+			if (sideAttackers & bs.pieces[side][p]) {
+				nextAttacker	= p;
+				nextAttackerBit = LS1B(sideAttackers & bs.pieces[side][p]);
+				break;
+			}
+		}
+		// the king can only recapture if the square isnt defended anymore
+		if (nextAttacker == KING && (attackers & bs.allColorPieces[!side])) break;
+
+		depth++;
+		gain[depth] = pieceToCentipawns[pieceOnSquare] - gain[depth - 1];
+
+		// removing the attacker from occ uncovers any slider lined up behind it
+		occ ^= nextAttackerBit;
+		if (nextAttacker == PAWN || nextAttacker == BISHOP || nextAttacker == QUEEN) {
+			attackers |= MoveGen::genDiagonalRays(to, occ) & diagonalSliders;
+		}
+		if (nextAttacker == ROOK || nextAttacker == QUEEN) {
+			attackers |= MoveGen::genStraightRays(to, occ) & straightSliders;
 		}
+		attackers &= occ;
+
+		pieceOnSquare = nextAttacker;
+		side		  = (Color)!side;
 	}
-	topLine = std::move(previousPV);
-	std::cout << "NPS: " << totalNodesSearched / std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - searchStartTime).count() << "\n";
-	std::cout << "Score: " << finalScore << "\n";
-	totalNodesSearched = 0;
-	return finalScore;
+
+	// each side can stop capturing whenever continuing would be worse, so negamax the gains back to the first capture
+	for (; depth > 0; depth--) {
+		gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+	}
+	return gain[0];
+}
+
+Centipawns Eval::capturedPieceValue(const Board& b, const Move& m) {
+	if (m.getFlags() & EN_PASSANT) {
+		return pieceToCentipawns[PAWN];
+	}
+	const auto& theirPieces = b.boardState.pieces[!b.boardState.sideToMove];
+	for (Piece p : {QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+		if (theirPieces[p] & 1UL << m.getTo()) {
+			return pieceToCentipawns[p];
+		}
+	}
+	return 0;
 }
 
 int Eval::calculateReductionFactor(int movesSearched, int depthLeft) {
@@ -363,6 +863,7 @@ int Eval::calculateReductionFactor(int movesSearched, int depthLeft) {
 	return log2_N / 2;
 }
 
-Centipawns Eval::positionalValue(Piece pieceType, Color color, Square square) {
-	return m_materialWeights[pieceType][color][(int)square];
+Centipawns Eval::taper(int mg, int eg, int phase) {
+	phase = std::min(phase, EvalParams::MAX_PHASE);
+	return eg + (mg - eg) * phase / EvalParams::MAX_PHASE;
 }
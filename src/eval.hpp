@@ -2,25 +2,58 @@
 #define EVAL_H
 
 #include <array>
-#include <chrono>
+#include <vector>
 
 #include "board.hpp"
 #include "consts.hpp"
+#include "eval_params.hpp"
 #include "move.hpp"
+#include "search_context.hpp"
+#include "search_listener.hpp"
+#include "time_manager.hpp"
 
 struct SearchResult {
 	Centipawns score;
 	SearchState state;
 };
 
-class Eval {
-public:
+/**
+* @brief one line of a multi pv search
+*/
+struct PVLine {
+	Move move;
+	Centipawns score;
 
 	/**
-	* @brief Tracks the total number of nodes searched during the current search session.
-	* This counter is used for performance monitoring and calculating nodes per second (NPS).
+	* @brief depth the line was last completed at
 	*/
-	static uint64_t totalNodesSearched;
+	int depth;
+	Moves pv;
+};
+
+/**
+* @brief coefficients of every handcrafted evaluation weight in one position, whites count minus blacks. the white POV score is the
+* sum of each coefficient times its weight, tapered, so a tuner can score a position with new weights without evaluating it again.
+* mobility is indexed like its table, kingSafety by attack units, pawnShield and pawnStorm by distance
+*/
+struct EvalTrace {
+	std::array<int, NONE_PIECE> pieceValues{};
+	std::array<std::array<int, 64>, NONE_PIECE> psqt{};
+	std::array<int, EvalParams::mgQueenMobility.size()> queenMobility{};
+	std::array<int, EvalParams::mgRookMobility.size()> rookMobility{};
+	std::array<int, EvalParams::mgBishopMobility.size()> bishopMobility{};
+	std::array<int, EvalParams::mgKnightMobility.size()> knightMobility{};
+
+	/**
+	* @brief middlegame only terms
+	*/
+	std::array<int, EvalParams::kingSafetyTable.size()> kingSafety{};
+	std::array<int, EvalParams::pawnShield.size()> pawnShield{};
+	std::array<int, EvalParams::pawnStorm.size()> pawnStorm{};
+};
+
+class Eval {
+public:
 
 	// /**
 	// * @brief sums up material count from whites POV.
@@ -29,60 +62,178 @@ public:
 
 	/**
 	* @brief spits out evaluation given a position. its sign is whether or not the count is favorable to whoevers turn it is.
+	* uses the nnue when the board has an accumulator, the handcrafted terms otherwise. endgames registered in Endgame are scored or
+	* scaled by their entry
 	*/
 	static Centipawns evaluate(Board&);
 
 	/**
-	* @brief negamax search with alpha beta pruning. its sign is whether or not the count is favorable to whoevers turn it is. stores the top engine line in topLine.
+	* @brief lazy evaluate for when only the side of the window the score falls on matters, as for the stand pat in quiescence search.
+	* returns the material and piece square score right away when it is more than lazyMargin outside [alpha, beta], skipping
+	* mobility and king safety. the exits are counted in ctx.lazyEvals
+	*/
+	static Centipawns evaluate(SearchContext& ctx, Board& b, Centipawns alpha, Centipawns beta);
+
+	/**
+	* @brief blends a middlegame and an endgame score by the game phase, all middlegame at MAX_PHASE and all endgame at 0
 	*/
-	static SearchResult search(Moves& topLine, Board&, int, Moves& previousPV, Centipawns alpha = -INF_SCORE, Centipawns beta = INF_SCORE, int plyFromRoot = 0);
+	static Centipawns taper(int mg, int eg, int phase);
+
+	/**
+	* @brief fills trace with the coefficients of the handcrafted evaluation of b and returns the score from whites POV. doesnt
+	* look for mates and ignores the nnue
+	*/
+	static Centipawns trace(const Board& b, EvalTrace& trace);
+
+	/**
+	* @brief negamax search with alpha beta pruning. its sign is whether or not the count is favorable to whoevers turn it is.
+	* killers, history, node counts and the time limit all come from ctx, and the top engine line is left in row plyFromRoot of ctx.pvTable.
+	*/
+	static SearchResult search(SearchContext& ctx, Board&, int depthLeft, Centipawns alpha = -INF_SCORE, Centipawns beta = INF_SCORE, int plyFromRoot = 0);
+
+	/**
+	* @brief runs search with a fresh context whose previous pv is previousPV. stores the top engine line in topLine.
+	*/
+	static SearchResult search(Moves& topLine, Board&, int depthLeft, Moves& previousPV, Centipawns alpha = -INF_SCORE, Centipawns beta = INF_SCORE, int plyFromRoot = 0);
 
 	/**
 	* @brief Performs iterative deepening search to improve move ordering and find the best move.
 	* This method repeatedly calls the search function with increasing depth limits until the maximum depth is reached or time runs out.
 	* It helps in finding the best move by progressively deepening the search and using results from shallower searches to improve efficiency.
+	* @param ctx The search context to use. its history and killers carry over from earlier searches.
 	* @param topLine A reference to a Moves object where the best line of moves will be stored.
 	* @param b The current board state.
 	* @param maxDepth The maximum depth to search to.
 	* @return The evaluation score of the best move found.
 	*/
+	static Centipawns iterative_deepening_ply(SearchContext& ctx, Moves& topLine, Board& b, int maxDepth);
+
+	/**
+	* @brief runs iterative_deepening_ply with a fresh search context
+	*/
 	static Centipawns iterative_deepening_ply(Moves& topLine, Board& b, int maxDepth);
 
 	/**
 	* @brief Performs iterative deepening search with a time constraint to improve move ordering and find the best move.
 	* This method repeatedly calls the search function with increasing depth limits until the maximum depth is reached or the time limit is exceeded.
 	* It helps in finding the best move by progressively deepening the search and using results from shallower searches to improve efficiency.
+	* @param ctx The search context to use. its history and killers carry over from earlier searches.
 	* @param topLine A reference to a Moves object where the best line of moves will be stored.
 	* @param b The current board state.
 	* @param maxTimeMs The maximum time allowed for the search in milliseconds.
 	* @return The evaluation score of the best move found.
 	*/
+	static Centipawns iterative_deepening_time(SearchContext& ctx, Moves& topLine, Board& b, int maxTimeMs);
+
+	/**
+	* @brief Performs iterative deepening search under a clock. a TimeManager turns the time control into a soft limit, checked
+	* before each new iteration and scaled by best move stability and score drops, and a hard limit that aborts the search.
+	* if the hard limit hits mid iteration, the root moves that iteration already finished are still used.
+	* @param ctx The search context to use. its history and killers carry over from earlier searches.
+	* @param topLine A reference to a Moves object where the best line of moves will be stored.
+	* @param b The current board state.
+	* @param tc Clock of the side to move.
+	* @return The evaluation score of the best move found.
+	*/
+	static Centipawns iterative_deepening_time(SearchContext& ctx, Moves& topLine, Board& b, const TimeControl& tc);
+
+	/**
+	* @brief Performs iterative deepening search until exactly maxNodes main and quiescence nodes have been searched, or the maximum depth
+	* is reached. the node count doesnt depend on the machine or its load, so with ctx.deterministic set the same position and context
+	* always give the same line, score and node count.
+	* @param ctx The search context to use. its node limit is set for this search and cleared afterwards.
+	* @param topLine A reference to a Moves object where the best line of moves will be stored.
+	* @param b The current board state.
+	* @param maxNodes Node budget of the search.
+	* @return The evaluation score of the best move found.
+	*/
+	static Centipawns iterative_deepening_nodes(SearchContext& ctx, Moves& topLine, Board& b, uint64_t maxNodes);
+
+	/**
+	* @brief the iterative deepening loop behind the other entry points. stops at maxDepth, when the time manager says so,
+	* when a node limit set in ctx runs out or when ctx is stopped. while ctx is pondering the soft limit is ignored and the hard limit
+	* doesnt run, both start counting from the ponderhit. completed iterations and the end of the search are passed to ctx.listener if set,
+	* nothing is ever printed.
+	* @param ctx The search context to use.
+	* @param topLine A reference to a Moves object where the best line of moves will be stored.
+	* @param b The current board state.
+	* @param tc Clock of the side to move, default constructed for no time limit.
+	* @param maxDepth The maximum depth to search to.
+	* @return The evaluation score of the best move found.
+	*/
+	static Centipawns iterative_deepening(SearchContext& ctx, Moves& topLine, Board& b, const TimeControl& tc, int maxDepth);
+
+	/**
+	* @brief iterative deepening that finds the best numPV root moves instead of only the best one. at each depth line i is searched
+	* with the root moves of lines 0..i-1 excluded, in an aspiration window around its score from the last depth. root moves are never
+	* written to the tt while excluded, but everything below the root is, so later lines mostly run through tt hits.
+	* @param ctx The search context to use.
+	* @param b The current board state.
+	* @param numPV Number of lines wanted, capped at the number of legal moves.
+	* @param tc Clock of the side to move, default constructed for no time limit.
+	* @param maxDepth The maximum depth to search to.
+	* @return The lines of the last completed depth, best first. empty only if there are no legal moves.
+	*/
+	static std::vector<PVLine> iterative_deepening_multipv(SearchContext& ctx, Board& b, int numPV, const TimeControl& tc, int maxDepth);
+
+	/**
+	* @brief runs iterative_deepening_time with a fresh search context
+	*/
 	static Centipawns iterative_deepening_time(Moves& topLine, Board& b, int maxTimeMs);
 
 	/**
 	* @brief quiescensce search to avoid horizon effect.
 	*/
+	static Centipawns quiescence_search(SearchContext& ctx, Board& b, Centipawns alpha, Centipawns beta, int plyFromRoot = 0);
+
+	/**
+	* @brief runs quiescence_search with a fresh search context
+	*/
 	static Centipawns quiescence_search(Board& b, Centipawns alpha, Centipawns beta);
 
-	static constexpr int MAX_SEARCH_DEPTH = 64;
-	static constexpr int NUM_KILLER_MOVES = 2;
+	/**
+	* @brief static exchange evaluation. plays out the sequence of captures on the destination square of the move,
+	* always recapturing with the least valuable attacker, and returns the material won or lost by the side making the move.
+	* x-ray attackers hiding behind the capturing sliders are added as the pieces in front of them are used up. pins are ignored.
+	* @param b The board the move will be played on.
+	* @param m The capture to evaluate.
+	* @return The expected material balance of the exchange from the moving sides POV.
+	*/
+	static Centipawns staticExchangeEvaluation(const Board& b, const Move& m);
 
+private:
 	/**
-	* @brief store killer moves.the killer move is a quiet move which caused a beta cutoff in a sibling cut branch. the idea is that these moves are likely to be good in this branch as well
+	* @brief restricts ctx.rootMoves to the moves the tablebases rank best if the root position has a table, clears it otherwise
 	*/
-	static std::array<std::array<Move, NUM_KILLER_MOVES>, MAX_SEARCH_DEPTH> killerMoves;
+	static void probeRootTablebases(SearchContext& ctx, Board& b);
 
 	/**
-	* @brief clears killer moves array
+	* @brief hands a finished (or partially finished) iteration to ctx.listener, if there is one
 	*/
-	static void resetKillerMoves();
+	static void reportIteration(SearchContext& ctx, int depth, Centipawns score, bool partial, int multiPV = 1);
 
-private:
 	/**
-    * @brief The end time for the search to be cut off.
-    * This variable is used to determine when the search should stop based on the time constraint.
-    */
-	static std::chrono::time_point<std::chrono::high_resolution_clock> m_iterative_deepening_cutoff_time;
+	* @brief snapshot of the search so far, reporting pv as its line
+	*/
+	static SearchInfo searchInfo(SearchContext& ctx, int depth, Centipawns score, const Moves& pv, bool partial, int multiPV = 1);
+
+	/**
+	* @brief searches the root in a window around the last score of the line, widening it on each fail until the score fits.
+	* used by multi pv, where each line has its own expected score
+	*/
+	static SearchResult aspirationSearch(SearchContext& ctx, Board& b, int depth, Centipawns previousScore);
+
+	/**
+	* @brief aspiration windows start at ASPIRATION_WINDOW on each side from this depth on, shallower depths use the full window
+	*/
+	static constexpr int ASPIRATION_DEPTH			= 4;
+	static constexpr Centipawns ASPIRATION_WINDOW = 25;
+
+	/**
+	* @brief once the window has been widened past this, a side that fails again is opened all the way, which ends the widening
+	* after a handful of fails instead of doubling the window until it overflows
+	*/
+	static constexpr int ASPIRATION_MAX_DELTA = 400;
 
 	/**
 	* @brief Calculates the reduction factor for late move reduction (LMR)
@@ -93,152 +244,78 @@ private:
 	static int calculateReductionFactor(int movesSearched, int depthLeft);
 
 	/**
-	* @brief Calculates the weight given to each piece based on its location for evaluation.
-	* This function is used to adjust the material value of pieces depending on their position on the board.
-	* The weight can vary for different pieces and colors, reflecting strategic considerations such as control of the center,
-	* piece activity, and other positional factors.
-	* 
-	* @param pieceType The type of the piece (e.g., QUEEN, ROOK, BISHOP, KNIGHT, PAWN).
-	* @param color The color of the piece (WHITE or BLACK).
-	* @param position The position of the piece on the board.
-	* @return A multiplier that adjusts the material value of the piece based on its position.
-	*/
-	static Centipawns positionalValue(Piece pieceType, Color color, Square position);
-
-	constexpr const static std::array<std::array<std::array<Centipawns, 64>, 2>, 6> m_materialWeights = {{
-		// clang-format off
-		// KING
-		{{
-			// WHITE
-			{   8,   13,   -1,   -5,   -1,   -5,   13,   13,
-			    0,   -3,   -8,   -8,   -8,   -8,   -3,    0,
-			  -10,  -13,  -15,  -15,  -15,  -15,  -13,  -10,
-			  -30,  -30,  -30,  -30,  -30,  -30,  -30,  -30,
-			  -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
-			  -50,  -50,  -50,  -50,  -50,  -50,  -50,  -50,
-			  -60,  -60,  -60,  -60,  -60,  -60,  -60,  -60,
-			  -70,  -70,  -70,  -70,  -70,  -70,  -70,  -70},
-			// BLACK
-			{ -70,  -70,  -70,  -70,  -70,  -70,  -70,  -70,
-			  -60,  -60,  -60,  -60,  -60,  -60,  -60,  -60,
-			  -50,  -50,  -50,  -50,  -50,  -50,  -50,  -50,
-			  -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
-			  -30,  -30,  -30,  -30,  -30,  -30,  -30,  -30,
-			  -10,  -13,  -15,  -15,  -15,  -15,  -13,  -10,
-			    0,   -3,   -8,   -8,   -8,   -8,   -3,    0,
-			    8,   13,   -1,   -5,   -1,   -1,   13,   13},
-		}},
-		// QUEEN
-		{{
-			// WHITE
-			{0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0},
-			// BLACK
-			{0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0}
-		}},
-		// ROOK
-		{{
-			// WHITE
-			{0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0},
-			// BLACK
-			{0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0,
-			 0, 0, 0, 0, 0, 0, 0, 0}
-		}},
-		// BISHOP
-		{{
-			// WHITE
-			{-10, -10, -10, -10, -10, -10, -10, -10,
-			  -5,  10,   0,   5,   5,   0,  10,  -5,
-			 -10,   0,   0,  10,  10,   0,   0, -10,
-			 -10,   0,  10,   7,   7,  10,   0, -10,
-			 -10,   7,   0,   7,   7,   0,   7, -10,
-			 -10,   0,   0,   0,   0,   0,   0, -10,
-			 -10,   0,   0,   0,   0,   0,   0, -10,
-			 -10, -10, -10, -10, -10, -10, -10, -10},
-			// BLACK
-			{-10, -10, -10, -10, -10, -10, -10, -10,
-			 -10,   0,   0,   0,   0,   0,   0, -10,
-			 -10,   0,   0,   0,   0,   0,   0, -10,
-			 -10,   7,   0,   7,   7,   0,   7, -10,
-			 -10,   0,  10,   7,   7,  10,   0, -10,
-			 -10,   0,   0,  10,  10,   0,   0, -10,
-			  -5,  10,   0,   5,   5,   0,  10,  -5,
-			 -10, -10, -10, -10, -10, -10, -10, -10},
-		}},
-		// KNIGHT
-		{{
-			// WHITE
-			{-7, -2, -5, -5, -5, -5, -2, -7,
-			 -7,  0,  0,  0,  0,  0,  0, -7,
-			 -5,  0,  5,  5,  5,  5,  0, -5,
-			 -5,  5,  6,  6,  6,  6,  5, -5,
-			 -5,  5,  6,  6,  6,  6,  5, -5,
-			 -5,  0,  5,  5,  5,  5,  0, -5,
-			 -5,  0,  0,  0,  0,  0,  0, -5,
-			 -7, -5, -5, -5, -5, -5, -5, -7},
-			// BLACK
-			{-7, -5, -5, -5, -5, -5, -5, -7,
-			 -5,  0,  0,  0,  0,  0,  0, -5,
-			 -5,  0,  5,  5,  5,  5,  0, -5,
-			 -5,  5,  6,  6,  6,  6,  5, -5,
-			 -5,  5,  6,  6,  6,  6,  5, -5,
-			 -5,  0,  5,  5,  5,  5,  0, -5,
-			 -7,  0,  0,  0,  0,  0,  0, -7,
-			 -7, -2, -5, -5, -5, -5, -2, -7},
-		}},
-		// PAWN
-		{{
-			// WHITE
-			{ 0,  0,  0,  0,  0,  0,  0,  0,
-			  0,  0,  0,  0,  0,  0,  0,  0,
-			  0,  0, -1,  2,  2, -1,  0,  0,
-			  0,  0,  0,  7,  7,  0,  0,  0,
-			 10, 10, 10,  7,  7, 10, 10, 10,
-			 20, 20, 20, 20, 20, 20, 20, 20,
-			 60, 60, 60, 60, 60, 60, 60, 60,
-			  0,  0,  0,  0,  0,  0,  0,  0},
-			// BLACK
-			{ 0,  0,  0,  0,  0,  0,  0,  0,
-			 60, 60, 60, 60, 60, 60, 60, 60,
-			 20, 20, 20, 20, 20, 20, 20, 20,
-			 10, 10, 10,  7,  7, 10, 10, 10,
-			  0,  0,  0,  7,  7,  0,  0,  0,
-			  0,  0, -1,  2,  2, -1,  0,  0,
-			  0,  0,  0,  0,  0,  0,  0,  0,
-			  0,  0,  0,  0,  0,  0,  0,  0}
-		}}
-		// clang-format on
-	}};
-
-	constexpr static std::array<int, 28> queenMobilityScore	 = {-23, -20, -15, -12, -8, -5, 0, 2, 2, 3, 5, 5, 6, 6, 8, 9, 9, 11, 12, 12, 14, 14, 15, 17, 17, 20, 21, 23};
-	constexpr static std::array<int, 15> rookMobilityScore	 = {-10, -8, -5, -3, 0, 2, 3, 4, 5, 6, 6, 7, 8, 8, 9};
-	constexpr static std::array<int, 14> bishopMobilityScore = {-10, -8, -5, -3, 0, 2, 3, 4, 5, 6, 6, 7, 8, 8};
-	constexpr static std::array<int, 9> knightMobilityScore	 = {-8, -5, -3, 0, 2, 4, 5, 6, 8};
+	* @brief captures that lose at least SEE_PRUNING_MARGIN per ply of remaining depth are skipped when this close to the horizon
+	*/
+	static constexpr int SEE_PRUNING_DEPTH			= 3;
+	static constexpr Centipawns SEE_PRUNING_MARGIN = 100;
+
+	/**
+	* @brief depth limits and per ply margins for reverse futility pruning, razoring and futility pruning
+	*/
+	static constexpr int RFP_DEPTH				  = 6;
+	static constexpr Centipawns RFP_MARGIN		  = 80;
+	static constexpr int RAZOR_DEPTH			  = 2;
+	static constexpr Centipawns RAZOR_MARGIN	  = 250;
+	static constexpr int FUTILITY_DEPTH			  = 3;
+	static constexpr Centipawns FUTILITY_MARGIN = 120;
+
+	/**
+	* @brief positional slack allowed on top of the captured material before a capture is delta pruned in quiescence search
+	*/
+	static constexpr Centipawns DELTA_MARGIN = 200;
+
+	/**
+	* @brief how much the evaluation terms after material and piece squares can move the score of b at most. a real bound, summed
+	* from the extremes of the mobility tables for the pieces on the board and of the king safety and shelter tables
+	*/
+	static int lazyMargin(const Board& b);
+
+	/**
+	* @brief evaluate with a lazy exit, lazyExit tells whether it was taken. the window is (-INF_SCORE, INF_SCORE) for a full evaluation
+	*/
+	static Centipawns evaluate(Board& b, Centipawns alpha, Centipawns beta, bool& lazyExit);
+
+	/**
+	* @brief squares attacked by each side, filled in once per evaluation while mobility is computed and then read by king safety
+	*/
+	struct AttackMap {
+		std::array<std::array<Bitboard, NONE_PIECE>, 2> attackedBy{};
+		std::array<Bitboard, 2> attackedByAll{};
+
+		/**
+		* @brief the kings square, the squares around it and the three in front of those
+		*/
+		std::array<Bitboard, 2> kingZone{};
+
+		/**
+		* @brief number of pieces of a color attacking the enemy king zone and the attack units they add up to
+		*/
+		std::array<int, 2> kingAttackers{};
+		std::array<int, 2> kingAttackUnits{};
+	};
+
+	/**
+	* @brief adds mobility and king safety, everything the board doesnt keep incrementally, to mg and eg from whites POV.
+	* with TRACE their coefficients are counted in trace too, otherwise trace is unused
+	*/
+	template <bool TRACE>
+	static void addPieceTerms(const Board& b, int& mg, int& eg, EvalTrace* trace);
+
+	/**
+	* @brief middlegame penalty for the king of color from the enemy attacks in attacks, positive when the king is in danger
+	*/
+	template <bool TRACE>
+	static int kingDanger(const Board& b, Color color, const AttackMap& attacks, EvalTrace* trace);
+
+	/**
+	* @brief middlegame bonus for the pawns sheltering the king of color, minus the enemy pawns storming it
+	*/
+	template <bool TRACE>
+	static int pawnShelter(const Board& b, Color color, EvalTrace* trace);
+
+	/**
+	* @brief returns the material value of the piece a move captures, or 0 if it isnt a capture
+	*/
+	static Centipawns capturedPieceValue(const Board& b, const Move& m);
 };
 #endif
@@ -0,0 +1,179 @@
+#ifndef EVAL_PARAMS_H
+#define EVAL_PARAMS_H
+
+#include <array>
+
+#include "consts.hpp"
+
+/**
+* @brief weights of the handcrafted evaluation. every term has a middlegame and an endgame value, evaluate blends the two
+* by the game phase. piece square tables are from whites POV with a1 first, so the first row of each table is the first rank.
+* black looks them up with the square flipped vertically
+*/
+namespace EvalParams {
+/**
+* @brief phase each piece adds while on the board. the starting position has MAX_PHASE, only kings and pawns have 0
+*/
+inline constexpr std::array<int, NONE_PIECE> phaseWeights = {0, 4, 2, 1, 1, 0};
+inline constexpr int MAX_PHASE							  = 24;
+
+inline constexpr std::array<Centipawns, NONE_PIECE> mgPieceValues = {0, 900, 500, 310, 300, 100};
+inline constexpr std::array<Centipawns, NONE_PIECE> egPieceValues = {0, 910, 520, 320, 290, 120};
+
+using PieceSquareTable = std::array<Centipawns, 64>;
+
+// clang-format off
+inline constexpr std::array<PieceSquareTable, NONE_PIECE> mgPsqt = {{
+	// KING
+	{   8,   13,   -1,   -5,   -1,   -5,   13,   13,
+	    0,   -3,   -8,   -8,   -8,   -8,   -3,    0,
+	  -10,  -13,  -15,  -15,  -15,  -15,  -13,  -10,
+	  -30,  -30,  -30,  -30,  -30,  -30,  -30,  -30,
+	  -40,  -40,  -40,  -40,  -40,  -40,  -40,  -40,
+	  -50,  -50,  -50,  -50,  -50,  -50,  -50,  -50,
+	  -60,  -60,  -60,  -60,  -60,  -60,  -60,  -60,
+	  -70,  -70,  -70,  -70,  -70,  -70,  -70,  -70},
+	// QUEEN
+	{0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0},
+	// ROOK
+	{0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0,
+	 0, 0, 0, 0, 0, 0, 0, 0},
+	// BISHOP
+	{-10, -10, -10, -10, -10, -10, -10, -10,
+	  -5,  10,   0,   5,   5,   0,  10,  -5,
+	 -10,   0,   0,  10,  10,   0,   0, -10,
+	 -10,   0,  10,   7,   7,  10,   0, -10,
+	 -10,   7,   0,   7,   7,   0,   7, -10,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10, -10, -10, -10, -10, -10, -10, -10},
+	// KNIGHT
+	{-7, -2, -5, -5, -5, -5, -2, -7,
+	 -7,  0,  0,  0,  0,  0,  0, -7,
+	 -5,  0,  5,  5,  5,  5,  0, -5,
+	 -5,  5,  6,  6,  6,  6,  5, -5,
+	 -5,  5,  6,  6,  6,  6,  5, -5,
+	 -5,  0,  5,  5,  5,  5,  0, -5,
+	 -5,  0,  0,  0,  0,  0,  0, -5,
+	 -7, -5, -5, -5, -5, -5, -5, -7},
+	// PAWN
+	{ 0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0, -1,  2,  2, -1,  0,  0,
+	  0,  0,  0,  7,  7,  0,  0,  0,
+	 10, 10, 10,  7,  7, 10, 10, 10,
+	 20, 20, 20, 20, 20, 20, 20, 20,
+	 60, 60, 60, 60, 60, 60, 60, 60,
+	  0,  0,  0,  0,  0,  0,  0,  0},
+}};
+
+inline constexpr std::array<PieceSquareTable, NONE_PIECE> egPsqt = {{
+	// KING, walks to the center once the queens are off
+	{-50, -30, -30, -30, -30, -30, -30, -50,
+	 -30, -10,   0,   0,   0,   0, -10, -30,
+	 -30,   0,  10,  15,  15,  10,   0, -30,
+	 -30,   5,  15,  20,  20,  15,   5, -30,
+	 -30,   5,  15,  20,  20,  15,   5, -30,
+	 -30,   0,  10,  15,  15,  10,   0, -30,
+	 -30, -10,   0,   0,   0,   0, -10, -30,
+	 -50, -30, -30, -30, -30, -30, -30, -50},
+	// QUEEN
+	{-10, -5, -5, -5, -5, -5, -5, -10,
+	  -5,  0,  0,  0,  0,  0,  0,  -5,
+	  -5,  0,  5,  5,  5,  5,  0,  -5,
+	  -5,  0,  5, 10, 10,  5,  0,  -5,
+	  -5,  0,  5, 10, 10,  5,  0,  -5,
+	  -5,  0,  5,  5,  5,  5,  0,  -5,
+	  -5,  0,  0,  0,  0,  0,  0,  -5,
+	 -10, -5, -5, -5, -5, -5, -5, -10},
+	// ROOK
+	{ 0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0,  0,  0,  0,  0,  0,  0,
+	  0,  0,  0,  0,  0,  0,  0,  0,
+	 10, 10, 10, 10, 10, 10, 10, 10,
+	  0,  0,  0,  0,  0,  0,  0,  0},
+	// BISHOP
+	{-10, -5, -5, -5, -5, -5, -5, -10,
+	  -5,  0,  0,  0,  0,  0,  0,  -5,
+	  -5,  0,  5,  5,  5,  5,  0,  -5,
+	  -5,  0,  5, 10, 10,  5,  0,  -5,
+	  -5,  0,  5, 10, 10,  5,  0,  -5,
+	  -5,  0,  5,  5,  5,  5,  0,  -5,
+	  -5,  0,  0,  0,  0,  0,  0,  -5,
+	 -10, -5, -5, -5, -5, -5, -5, -10},
+	// KNIGHT
+	{-20, -10, -10, -10, -10, -10, -10, -20,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -10,   0,   5,   5,   5,   5,   0, -10,
+	 -10,   0,   5, 10, 10,   5,   0, -10,
+	 -10,   0,   5, 10, 10,   5,   0, -10,
+	 -10,   0,   5,   5,   5,   5,   0, -10,
+	 -10,   0,   0,   0,   0,   0,   0, -10,
+	 -20, -10, -10, -10, -10, -10, -10, -20},
+	// PAWN, passers matter more the fewer pieces are left to stop them
+	{  0,   0,   0,   0,   0,   0,   0,   0,
+	   0,   0,   0,   0,   0,   0,   0,   0,
+	   5,   5,   5,   5,   5,   5,   5,   5,
+	  15,  15,  15,  15,  15,  15,  15,  15,
+	  30,  30,  30,  30,  30,  30,  30,  30,
+	  55,  55,  55,  55,  55,  55,  55,  55,
+	  90,  90,  90,  90,  90,  90,  90,  90,
+	   0,   0,   0,   0,   0,   0,   0,   0},
+}};
+// clang-format on
+
+/**
+* @brief mobility bonuses indexed by the number of squares a piece attacks that arent occupied by its own pieces
+*/
+inline constexpr std::array<Centipawns, 28> mgQueenMobility	 = {-23, -20, -15, -12, -8, -5, 0, 2, 2, 3, 5, 5, 6, 6, 8, 9, 9, 11, 12, 12, 14, 14, 15, 17, 17, 20, 21, 23};
+inline constexpr std::array<Centipawns, 28> egQueenMobility	 = {-30, -25, -20, -15, -10, -6, -2, 2, 5, 8, 10, 12, 14, 16, 18, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32};
+inline constexpr std::array<Centipawns, 15> mgRookMobility	 = {-10, -8, -5, -3, 0, 2, 3, 4, 5, 6, 6, 7, 8, 8, 9};
+inline constexpr std::array<Centipawns, 15> egRookMobility	 = {-20, -15, -10, -5, 0, 4, 8, 11, 14, 16, 18, 20, 22, 23, 24};
+inline constexpr std::array<Centipawns, 14> mgBishopMobility = {-10, -8, -5, -3, 0, 2, 3, 4, 5, 6, 6, 7, 8, 8};
+inline constexpr std::array<Centipawns, 14> egBishopMobility = {-15, -10, -6, -3, 0, 3, 5, 7, 9, 10, 11, 12, 13, 14};
+inline constexpr std::array<Centipawns, 9> mgKnightMobility	 = {-8, -5, -3, 0, 2, 4, 5, 6, 8};
+inline constexpr std::array<Centipawns, 9> egKnightMobility	 = {-12, -8, -4, 0, 3, 5, 7, 8, 9};
+
+/**
+* @brief king safety. every piece that attacks squares in the enemy king zone adds its weight per attacked square to the attack
+* units, and every safe check it could give adds its check weight. the units index kingSafetyTable, a middlegame only penalty that
+* grows slowly for a lone attacker and steeply once several pieces join in
+*/
+inline constexpr std::array<int, NONE_PIECE> kingAttackWeights = {0, 5, 3, 2, 2, 0};
+inline constexpr std::array<int, NONE_PIECE> safeCheckWeights  = {0, 6, 5, 2, 3, 0};
+
+// clang-format off
+inline constexpr std::array<Centipawns, 100> kingSafetyTable = {
+	  0,   0,   0,   1,   1,   2,   3,   4,   6,   7,   9,  11,  13,  15,  17,  19,  22,  25,  28,  31,
+	 34,  37,  41,  42,  44,  48,  52,  56,  61,  65,  70,  75,  84,  90,  95, 101, 106, 112, 118, 124,
+	130, 136, 141, 147, 153, 159, 165, 171, 177, 183, 188, 194, 200, 206, 212, 218, 224, 229, 235, 241,
+	247, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250,
+	250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250, 250,
+};
+// clang-format on
+
+/**
+* @brief pawn shield and storm on the king file and the files next to it, middlegame only. pawnShield is indexed by how many ranks
+* in front of the king the nearest own pawn is, 0 if there is none. pawnStorm is the penalty for the nearest enemy pawn in front of
+* the king by the same distance, 0 if there is none
+*/
+inline constexpr std::array<Centipawns, 4> pawnShield = {-20, 15, 5, -10};
+inline constexpr std::array<Centipawns, 5> pawnStorm  = {0, 5, 25, 15, 5};
+}  // namespace EvalParams
+#endif
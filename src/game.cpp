@@ -1,3 +1,4 @@
+#include "book.hpp"
 #include "eval.hpp"
 #include "game.hpp"
 #include "transposition_table.hpp"
@@ -6,18 +7,38 @@
 #include "backends/imgui_impl_opengl3.h"
 #include "imgui.h"
 
-Game::Game(Board& b, Color pC) : m_board(b), m_playerColor(pC), m_gui(b, pC, [this](Square sq) { m_clicked = sq; }) {
-	m_clicked	  = NONE_SQUARE;
-	m_startOfMove = NONE_SQUARE;
+#include <algorithm>
+#include <chrono>
+
+Game::Game(Board& b, Color pC)
+	: m_board(b), m_playerColor(pC), m_gui(b, pC, [this](Square sq) { m_clicked = sq; }, [this]() { cancelPonder(); m_engine.stop(); }, [this]() { cancelPonder(); }) {
+	m_clicked				  = NONE_SQUARE;
+	m_startOfMove			  = NONE_SQUARE;
+	m_engineClock.remainingMs = ENGINE_START_TIME_MS;
+	m_engineClock.incrementMs = ENGINE_INCREMENT_MS;
 }
 
 void Game::gameLogic() {
 	if (m_board.isGameOver()) return;
 	if (m_board.boardState.sideToMove != m_playerColor) {
-		Move aiMove = getAIMove();
+		// the search runs on the engine thread, so this frame only checks on it and goes back to rendering.
+		// clicks made while the engine thinks are dropped
+		m_clicked = NONE_SQUARE;
+		Move aiMove;
+		if (!m_aiMove.valid()) {
+			// while the game is in the book the engine doesnt think at all
+			aiMove = Book::probe(m_board);
+			if (aiMove.getPieceType() == NONE_PIECE) startAIMove();
+		}
+		bool searched = m_aiMove.valid();
+		if (searched) aiMove = pollAIMove();
+		if (aiMove.getPieceType() == NONE_PIECE) return;
 		m_gui.setSelected(aiMove.getTo());
 		m_gui.gameHistory.push_back({aiMove.notationWithAnnotations(m_board), (Color)!m_playerColor, (int)m_board.boardState.fmClock});
 		m_board.execute(aiMove);
+
+		SearchInfo info;
+		if (searched && m_engine.latestIteration(info) && !info.pv.empty() && info.pv[0] == aiMove) startPonder(info.pv);
 		return;
 	}
 
@@ -37,6 +58,7 @@ void Game::gameLogic() {
 		if (selectedMove.getPieceType() != NONE_PIECE) {
 			m_gui.gameHistory.push_back({selectedMove.notationWithAnnotations(m_board), m_playerColor, (int)m_board.boardState.fmClock});
 			m_board.execute(selectedMove);
+			resolvePonder(selectedMove);
 		}
 	} else if ((m_board.boardState.allColorPieces[WHITE] | m_board.boardState.allColorPieces[BLACK]) & (1UL << m_clicked)) {
 		m_startOfMove = m_clicked;
@@ -45,11 +67,49 @@ void Game::gameLogic() {
 	m_clicked = NONE_SQUARE;
 }
 
-Move Game::getAIMove() {
-	Moves topLine;
-	Eval::iterative_deepening_time(topLine, m_board, 5000);
-	TranspositionTable::reset();
-	return topLine[0];
+void Game::startAIMove() {
+	m_aiMoveStart = std::chrono::steady_clock::now();
+	m_aiMove	  = m_engine.search(m_board, m_engineClock);
+}
+
+Move Game::pollAIMove() {
+	if (m_aiMove.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return Move();
+	Move aiMove	  = m_aiMove.get();
+	int elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_aiMoveStart).count();
+	// the engine plays on its own clock, as if it were in a game with increment
+	m_engineClock.remainingMs = std::max(0, m_engineClock.remainingMs - elapsedMs) + m_engineClock.incrementMs;
+	// the engine thread is done with the tt once the future is ready
+	TranspositionTable::shared().reset();
+	return aiMove;
+}
+
+void Game::startPonder(const Moves& pv) {
+	if (pv.size() < 2 || m_board.isGameOver()) return;
+	Board expected = m_board;
+	expected.execute(pv[1]);
+	m_ponderMove   = pv[1];
+	m_ponderResult = m_engine.search(expected, m_engineClock, SearchContext::MAX_SEARCH_DEPTH, true);
+}
+
+void Game::resolvePonder(const Move& playerMove) {
+	if (!m_ponderResult.valid()) return;
+	if (playerMove == m_ponderMove) {
+		// the search keeps everything it found so far, and the engine clock starts running now
+		m_engine.ponderhit();
+		m_aiMoveStart = std::chrono::steady_clock::now();
+		m_aiMove	  = std::move(m_ponderResult);
+		m_ponderMove  = Move();
+	} else {
+		cancelPonder();
+	}
+}
+
+void Game::cancelPonder() {
+	if (!m_ponderResult.valid()) return;
+	// the next startAIMove joins the stopped search before it starts its own
+	m_engine.stop();
+	m_ponderResult = std::future<Move>();
+	m_ponderMove   = Move();
 }
 
 void Game::run() {
@@ -61,6 +121,10 @@ void Game::run() {
 		ImGui::NewFrame();
 
 		gameLogic();
+		SearchInfo info;
+		bool hasInfo = m_engine.latestIteration(info);
+		bool pondering = m_ponderResult.valid();
+		m_gui.setEngineStatus(m_engine.searching() && !pondering, pondering, hasInfo ? &info : nullptr);
 		m_gui.drawUI();
 
 		ImGui::Render();
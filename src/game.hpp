@@ -3,7 +3,12 @@
 
 #include <GLFW/glfw3.h>
 #include "board.hpp"
+#include "engine_thread.hpp"
 #include "gui.hpp"
+#include "time_manager.hpp"
+
+#include <chrono>
+#include <future>
 
 
 class Game {
@@ -13,8 +18,52 @@ private:
 	Color m_playerColor;
 	Gui m_gui;
 	Board& m_board;
+	EngineThread m_engine;
+	TimeControl m_engineClock;
+
+	/**
+	* @brief best move of the search running on the engine thread, invalid while the engine isnt thinking
+	*/
+	std::future<Move> m_aiMove;
+	std::chrono::steady_clock::time_point m_aiMoveStart;
+
+	/**
+	* @brief best move of the ponder search on the position after m_ponderMove, invalid while the engine isnt pondering
+	*/
+	std::future<Move> m_ponderResult;
+
+	/**
+	* @brief the reply the engine expects from the player, taken from the pv of its last move
+	*/
+	Move m_ponderMove;
+
+	static constexpr int ENGINE_START_TIME_MS = 5 * 60 * 1000;
+	static constexpr int ENGINE_INCREMENT_MS  = 3000;
+
+	/**
+	* @brief starts the engine thinking on the current position without waiting for it
+	*/
+	void startAIMove();
+
+	/**
+	* @brief returns the engine move once its search is done, or a null move while it is still thinking
+	*/
+	Move pollAIMove();
+
+	/**
+	* @brief starts the engine thinking on the players turn, on the position after the reply it expects
+	*/
+	void startPonder(const Moves& pv);
+
+	/**
+	* @brief turns the ponder search into the engine move if the player played the expected reply, otherwise throws it away
+	*/
+	void resolvePonder(const Move& playerMove);
 
-	Move getAIMove();
+	/**
+	* @brief stops the ponder search and forgets it, for when the position it was started on is gone
+	*/
+	void cancelPonder();
 
 public:
 	Game(Board&, Color);
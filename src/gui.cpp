@@ -30,7 +30,8 @@ static ImTextureID LoadTextureFromFile(const char* filename, int* out_width = nu
 	return (ImTextureID)(intptr_t)tex;
 }
 
-Gui::Gui(Board& b, Color pC, std::function<void(Square)> func) : m_board(b), m_playerColor(pC), m_Window(nullptr), m_sendClick(func) {
+Gui::Gui(Board& b, Color pC, std::function<void(Square)> func, std::function<void()> stopFunc, std::function<void()> undoFunc)
+	: m_board(b), m_playerColor(pC), m_Window(nullptr), m_sendClick(func), m_sendStop(stopFunc), m_sendUndo(undoFunc) {
 	m_selected = NONE_SQUARE;
 	init();
 
@@ -68,6 +69,36 @@ void Gui::setSelected(Square sq) {
 	m_selected = sq;
 }
 
+void Gui::setEngineStatus(bool thinking, bool pondering, const SearchInfo* info) {
+	m_engineThinking  = thinking;
+	m_enginePondering = pondering;
+	m_hasEngineInfo	  = info != nullptr;
+	if (info) m_engineInfo = *info;
+}
+
+void Gui::drawEnginePanel() {
+	ImGui::Begin("Engine");
+	ImGui::Text("%s", m_engineThinking ? "Thinking..." : m_enginePondering ? "Pondering, waiting for your move." : "Waiting for your move.");
+	if (m_hasEngineInfo) {
+		std::ostringstream pv;
+		for (const Move& m : m_engineInfo.pv) {
+			pv << m.UCInotation() << " ";
+		}
+		if (isMateScore(m_engineInfo.score)) {
+			ImGui::Text("Depth %d  Eval: mate", m_engineInfo.depth);
+		} else {
+			ImGui::Text("Depth %d  Eval: %+.2f", m_engineInfo.depth, m_engineInfo.score / 100.0);
+		}
+		ImGui::Text("Nodes %llu  Time %lld ms", (unsigned long long)m_engineInfo.nodes, (long long)m_engineInfo.elapsedMs);
+		ImGui::TextWrapped("PV: %s", pv.str().c_str());
+	}
+	// stopping only cuts the search short, the engine still plays the best move it has found
+	if (m_engineThinking && ImGui::Button("STOP", ImVec2(200, 50))) {
+		m_sendStop();
+	}
+	ImGui::End();
+}
+
 void Gui::drawUI() {
 	ImGui::BeginChild("Move History");
 	ImGui::TextWrapped("%s", outputMoveHistory().c_str());
@@ -77,9 +108,13 @@ void Gui::drawUI() {
 		setSelected(NONE_SQUARE);
 	}
 	ImGui::EndChild();
+	drawEnginePanel();
 	ImGui::Begin("Undo Move");
 	ImGui::Text("Press to undo last move. Undos move regardless of who played it.");
-	if (ImGui::Button("UNDO MOVE", ImVec2(200, 100))) {
+	// undoing while the engine thinks would leave it answering a position that is no longer on the board. a ponder search is
+	// thrown away by the undo callback instead
+	if (ImGui::Button("UNDO MOVE", ImVec2(200, 100)) && !m_engineThinking) {
+		m_sendUndo();
 		m_board.undoMove();
 		gameHistory.pop_back();
 		if (gameHistory.size() > 0) {
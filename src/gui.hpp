@@ -5,6 +5,7 @@
 #include <functional>
 #include "board.hpp"
 #include "imgui.h"
+#include "search_listener.hpp"
 
 #include <list>
 
@@ -23,16 +24,32 @@ private:
 	bool m_resigned = false;
 	std::array<std::array<ImTextureID, 6>, 2> pieceTextures;
 	std::function<void(Square)> m_sendClick;
+	std::function<void()> m_sendStop;
+	std::function<void()> m_sendUndo;
+	bool m_engineThinking  = false;
+	bool m_enginePondering = false;
+	bool m_hasEngineInfo   = false;
+	SearchInfo m_engineInfo{};
 	std::string outputMoveHistory();
+	void drawEnginePanel();
 
 public:
 	GLFWwindow* m_Window;
 	std::list<MoveHistory> gameHistory;
 
-	Gui(Board&, Color, std::function<void(Square)>);
+	/**
+	* @brief the callbacks get clicked squares, presses of STOP, and presses of UNDO MOVE right before the moves are taken back
+	*/
+	Gui(Board&, Color, std::function<void(Square)>, std::function<void()>, std::function<void()>);
 	void init();
 	void drawUI();
 	void setSelected(Square);
+
+	/**
+	* @brief sets what the engine panel shows this frame. thinking is a search for the engines own move, pondering one on the players
+	* turn. info is the last completed iteration, or nullptr if there is none yet
+	*/
+	void setEngineStatus(bool thinking, bool pondering, const SearchInfo* info);
 };
 
 #endif
@@ -1,5 +1,7 @@
 #include "lookup_tables.hpp"
 
+#include <cstddef>
+
 std::array<Bitboard, 64> LookupTables::s_knightAttacks{};
 std::array<Bitboard, 64> LookupTables::s_kingAttacks{};
 std::array<std::array<Bitboard, 4>, 64> LookupTables::s_straightRayTable{};
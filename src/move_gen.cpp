@@ -3,6 +3,8 @@
 #include "lookup_tables.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+
 MoveGen::MoveGen(Board& b) : m_board(b) {
 	m_attacks = genAttacks();
 }
@@ -415,7 +417,7 @@ bool MoveGen::hasLegalMoves() {
 	Bitboard theirPieces = m_board.boardState.sideToMove == WHITE ? m_board.boardState.allColorPieces[BLACK] : m_board.boardState.allColorPieces[WHITE];
 
 	Bitboard pawns = m_board.boardState.pieces[m_board.boardState.sideToMove][PAWN];
-	do {
+	while (pawns) {
 		Bitboard pawn				= LS1B(pawns);
 		Bitboard captureMoveTargets = (pawn & ~aFile ? pawn << 7 : 0) | (pawn & ~hFile ? pawn << 9 : 0);
 		if (m_board.boardState.sideToMove == BLACK) {
@@ -436,17 +438,19 @@ bool MoveGen::hasLegalMoves() {
 			if (isLegal((Square)bitscan(pawn), (Square)bitscan(LS1B(targets)), PAWN)) return true;
 			removeLS1B(targets);
 		}
-	} while (removeLS1B(pawns));
+		removeLS1B(pawns);
+	}
 
 	Bitboard knights = m_board.boardState.pieces[m_board.boardState.sideToMove][KNIGHT];
-	do {
+	while (knights) {
 		Bitboard knight	 = LS1B(knights);
 		Bitboard targets = LookupTables::s_knightAttacks[bitscan(knight)] & ~yourPieces;
 		while (targets) {
 			if (isLegal((Square)bitscan(knight), (Square)bitscan(LS1B(targets)), KNIGHT, LS1B(targets) & theirPieces ? CAPTURE : NORMAL_MOVE)) return true;
 			removeLS1B(targets);
 		}
-	} while (removeLS1B(knights));
+		removeLS1B(knights);
+	}
 
 	// sliding moves
 	for (Piece p : {BISHOP, ROOK, QUEEN}) {
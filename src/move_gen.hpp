@@ -179,6 +179,13 @@ struct MoveGen {
 	*/
 	Bitboard genAttacks() const;
 
+	/**
+	* @brief returns a bitboard of every piece of either color that attacks a square
+	* @param square -- square being attacked
+	* @param occ -- bitboard representing all occupied squares. pieces removed from occ are seen through so x-ray attackers can be found
+	*/
+	Bitboard attackersTo(Square square, Bitboard occ) const;
+
 	/**
 	* @brief returns attacks bitboard
 	*/
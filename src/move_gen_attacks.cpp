@@ -127,3 +127,18 @@ Bitboard MoveGen::genQueenAttacks() const {
 Bitboard MoveGen::genAttacks() const {
 	return genPawnAttacks() | genKnightAttacks() | genKingAttacks() | genBishopAttacks() | genRookAttacks() | genQueenAttacks();
 }
+
+Bitboard MoveGen::attackersTo(Square square, Bitboard occ) const {
+	const auto& pieces = m_board.boardState.pieces;
+	Bitboard target	   = 1UL << square;
+
+	// a white pawn attacks the square from one rank below, a black pawn from one rank above
+	Bitboard whitePawns = (((target & ~aFile) >> 9) | ((target & ~hFile) >> 7)) & pieces[WHITE][PAWN];
+	Bitboard blackPawns = (((target & ~aFile) << 7) | ((target & ~hFile) << 9)) & pieces[BLACK][PAWN];
+	Bitboard knights	= LookupTables::s_knightAttacks[square] & (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT]);
+	Bitboard kings		= LookupTables::s_kingAttacks[square] & (pieces[WHITE][KING] | pieces[BLACK][KING]);
+	Bitboard diagonals	= genDiagonalRays(square, occ) & (pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN]);
+	Bitboard straights	= genStraightRays(square, occ) & (pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN]);
+
+	return (whitePawns | blackPawns | knights | kings | diagonals | straights) & occ;
+}
@@ -0,0 +1,181 @@
+#include "nnue.hpp"
+#include "move.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+bool NNUE::s_loaded = false;
+alignas(32) std::array<std::array<int16_t, NNUE::HIDDEN_SIZE>, NNUE::INPUT_SIZE> NNUE::s_featureWeights{};
+alignas(32) std::array<int16_t, NNUE::HIDDEN_SIZE> NNUE::s_featureBiases{};
+alignas(32) std::array<int16_t, 2 * NNUE::HIDDEN_SIZE> NNUE::s_outputWeights{};
+int32_t NNUE::s_outputBias = 0;
+
+bool NNUE::load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	char magic[8];
+	uint32_t version, hiddenSize;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+	file.read(reinterpret_cast<char*>(&hiddenSize), sizeof(hiddenSize));
+	if (!file || std::memcmp(magic, "TYPHNNUE", 8) != 0 || version != NET_VERSION || hiddenSize != HIDDEN_SIZE) return false;
+
+	// read everything into a scratch copy first, so a truncated file leaves the current net alone
+	auto featureWeights = std::make_unique<std::array<std::array<int16_t, HIDDEN_SIZE>, INPUT_SIZE>>();
+	std::array<int16_t, HIDDEN_SIZE> featureBiases;
+	std::array<int16_t, 2 * HIDDEN_SIZE> outputWeights;
+	int32_t outputBias;
+	file.read(reinterpret_cast<char*>(featureWeights->data()), sizeof(*featureWeights));
+	file.read(reinterpret_cast<char*>(featureBiases.data()), sizeof(featureBiases));
+	file.read(reinterpret_cast<char*>(outputWeights.data()), sizeof(outputWeights));
+	file.read(reinterpret_cast<char*>(&outputBias), sizeof(outputBias));
+	if (!file || file.peek() != EOF) return false;
+
+	s_featureWeights = *featureWeights;
+	s_featureBiases	 = featureBiases;
+	s_outputWeights	 = outputWeights;
+	s_outputBias	 = outputBias;
+	s_loaded		 = true;
+	return true;
+}
+
+void NNUE::randomize(uint64_t seed) {
+	std::mt19937_64 rng(seed);
+	std::uniform_int_distribution<int> featureWeight(-QA / 8, QA / 8);
+	std::uniform_int_distribution<int> outputWeight(-QB, QB);
+	for (auto& row : s_featureWeights) {
+		for (int16_t& w : row) w = featureWeight(rng);
+	}
+	for (int16_t& b : s_featureBiases) b = featureWeight(rng);
+	for (int16_t& w : s_outputWeights) w = outputWeight(rng);
+	s_outputBias = 0;
+	s_loaded	 = true;
+}
+
+void NNUE::unload() {
+	s_loaded = false;
+}
+
+bool NNUE::isLoaded() {
+	return s_loaded;
+}
+
+void NNUE::refresh(const PieceBitboards& pieces, Accumulator& acc) {
+	refreshPerspective(pieces, WHITE, acc);
+	refreshPerspective(pieces, BLACK, acc);
+}
+
+void NNUE::refreshPerspective(const PieceBitboards& pieces, Color perspective, Accumulator& acc) {
+	Square kingSquare						 = (Square)bitscan(pieces[perspective][KING]);
+	std::array<int16_t, HIDDEN_SIZE>& values = acc.values[perspective];
+	values									 = s_featureBiases;
+	for (Color color : {WHITE, BLACK}) {
+		for (Piece piece : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+			Bitboard bb = pieces[color][piece];
+			while (bb) {
+				addFeature(values, featureIndex(perspective, kingSquare, color, piece, (Square)bitscan(bb)));
+				bb &= bb - 1;
+			}
+		}
+	}
+}
+
+NNUE::DirtyPieces NNUE::dirtyPieces(Color mover, const Move& m, Piece captured) {
+	DirtyPieces dirty;
+	dirty.mover		= mover;
+	dirty.kingMoved = m.getPieceType() == KING;
+	MoveFlag flags	= m.getFlags();
+
+	if (flags & (KS_CASTLE | QS_CASTLE)) {
+		int rank		 = mover == WHITE ? 0 : 56;
+		bool kingside	 = flags & KS_CASTLE;
+		dirty.removed[0] = {mover, KING, (Square)(rank + 4)};
+		dirty.added[0]	 = {mover, KING, (Square)(rank + (kingside ? 6 : 2))};
+		dirty.removed[1] = {mover, ROOK, (Square)(rank + (kingside ? 7 : 0))};
+		dirty.added[1]	 = {mover, ROOK, (Square)(rank + (kingside ? 5 : 3))};
+		dirty.numRemoved = dirty.numAdded = 2;
+		return dirty;
+	}
+
+	dirty.removed[dirty.numRemoved++] = {mover, m.getPieceType(), m.getFrom()};
+	dirty.added[dirty.numAdded++]	  = {mover, (flags & PROMOTION) ? m.getPromoPiece() : m.getPieceType(), m.getTo()};
+	if (captured != NONE_PIECE) {
+		Square capturedSquare			  = (flags & EN_PASSANT) ? (Square)(m.getTo() + (mover == WHITE ? -8 : 8)) : m.getTo();
+		dirty.removed[dirty.numRemoved++] = {(Color)!mover, captured, capturedSquare};
+	}
+	return dirty;
+}
+
+void NNUE::update(const PieceBitboards& pieces, const DirtyPieces& dirty, const Accumulator& before, Accumulator& after) {
+	for (Color perspective : {WHITE, BLACK}) {
+		if (dirty.kingMoved && perspective == dirty.mover) {
+			refreshPerspective(pieces, perspective, after);
+			continue;
+		}
+		Square kingSquare						 = (Square)bitscan(pieces[perspective][KING]);
+		std::array<int16_t, HIDDEN_SIZE>& values = after.values[perspective];
+		values									 = before.values[perspective];
+		for (int i = 0; i < dirty.numRemoved; i++) {
+			const PieceChange& c = dirty.removed[i];
+			subFeature(values, featureIndex(perspective, kingSquare, c.color, c.piece, c.sq));
+		}
+		for (int i = 0; i < dirty.numAdded; i++) {
+			const PieceChange& c = dirty.added[i];
+			addFeature(values, featureIndex(perspective, kingSquare, c.color, c.piece, c.sq));
+		}
+	}
+}
+
+Centipawns NNUE::evaluate(const Accumulator& acc, Color sideToMove) {
+	int32_t sum = clippedDot(acc.values[sideToMove].data(), s_outputWeights.data()) +
+				  clippedDot(acc.values[!sideToMove].data(), s_outputWeights.data() + HIDDEN_SIZE);
+	int64_t score = ((int64_t)sum + s_outputBias) * EVAL_SCALE / (QA * QB);
+	// the net has no idea about mates, so keep it clear of the mate range
+	return (Centipawns)std::clamp<int64_t>(score, -CHECKMATE_SCORE + 1, CHECKMATE_SCORE - 1);
+}
+
+void NNUE::addFeature(std::array<int16_t, HIDDEN_SIZE>& values, int feature) {
+	// plain loops over a fixed width, which the compiler vectorizes on its own
+	const std::array<int16_t, HIDDEN_SIZE>& weights = s_featureWeights[feature];
+	for (int i = 0; i < HIDDEN_SIZE; i++) values[i] += weights[i];
+}
+
+void NNUE::subFeature(std::array<int16_t, HIDDEN_SIZE>& values, int feature) {
+	const std::array<int16_t, HIDDEN_SIZE>& weights = s_featureWeights[feature];
+	for (int i = 0; i < HIDDEN_SIZE; i++) values[i] -= weights[i];
+}
+
+int32_t NNUE::clippedDot(const int16_t* values, const int16_t* weights) {
+#if defined(__AVX2__)
+	static_assert(HIDDEN_SIZE % 16 == 0);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i qa   = _mm256_set1_epi16(QA);
+	__m256i sum		   = _mm256_setzero_si256();
+	for (int i = 0; i < HIDDEN_SIZE; i += 16) {
+		__m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i));
+		__m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+		v		  = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+		// clamped values are at most QA, so each pair of products fits in the int32 lanes madd produces
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, w));
+	}
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half		 = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half		 = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(half);
+#else
+	int32_t sum = 0;
+	for (int i = 0; i < HIDDEN_SIZE; i++) {
+		sum += std::clamp<int32_t>(values[i], 0, QA) * weights[i];
+	}
+	return sum;
+#endif
+}
@@ -0,0 +1,142 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "consts.hpp"
+
+class Move;
+
+/**
+* @brief efficiently updatable neural network evaluation. HalfKA inputs (own king square x piece color x piece type x square, seen from
+* each side) feed a HIDDEN_SIZE wide int16 accumulator per perspective, which goes through a clipped relu into a single int16 output neuron.
+* the accumulators live in Board and are updated move by move, so an evaluation is only the output layer and whatever updates
+* are still pending since the last evaluated position.
+*
+* net file layout, all little endian:
+*   char[8]  magic "TYPHNNUE"
+*   uint32   version, NET_VERSION
+*   uint32   hidden size, HIDDEN_SIZE
+*   int16    feature weights [INPUT_SIZE][HIDDEN_SIZE], scaled by QA
+*   int16    feature biases [HIDDEN_SIZE], scaled by QA
+*   int16    output weights [2 * HIDDEN_SIZE], side to move half first, scaled by QB
+*   int32    output bias, scaled by QA * QB
+*/
+class NNUE {
+public:
+	static constexpr int INPUT_SIZE	   = 64 * 12 * 64;
+	static constexpr int HIDDEN_SIZE   = 128;
+	static constexpr int QA			   = 255;
+	static constexpr int QB			   = 64;
+	static constexpr int EVAL_SCALE	   = 400;
+	static constexpr uint32_t NET_VERSION = 1;
+
+	/**
+	* @brief hidden layer pre activations for both perspectives, indexed by color
+	*/
+	struct Accumulator {
+		alignas(32) std::array<std::array<int16_t, HIDDEN_SIZE>, 2> values;
+	};
+
+	/**
+	* @brief loads a net from a file in the layout above. the current net is kept if the file cant be read or doesnt match
+	* @return true if the net was loaded
+	*/
+	static bool load(const std::string& path);
+
+	/**
+	* @brief fills the net with small random weights. only useful for tests and for measuring the cost of inference without a trained net
+	*/
+	static void randomize(uint64_t seed);
+
+	/**
+	* @brief drops the net, so evaluation goes back to the handcrafted evaluator
+	*/
+	static void unload();
+
+	/**
+	* @brief returns true if a net is loaded
+	*/
+	static bool isLoaded();
+
+	/**
+	* @brief a piece appearing on or leaving a square
+	*/
+	struct PieceChange {
+		Color color;
+		Piece piece;
+		Square sq;
+	};
+
+	/**
+	* @brief what a move changed on the board, recorded in execute so the accumulator update can wait until the position is evaluated.
+	* at most two pieces leave a square and two arrive on one, castling being the only move that needs both
+	*/
+	struct DirtyPieces {
+		Color mover;
+		bool kingMoved;
+		int numRemoved = 0;
+		int numAdded   = 0;
+		std::array<PieceChange, 2> removed;
+		std::array<PieceChange, 2> added;
+	};
+
+	using PieceBitboards = std::array<std::array<Bitboard, 6>, 2>;
+
+	/**
+	* @brief computes both perspectives of the accumulator from scratch
+	*/
+	static void refresh(const PieceBitboards& pieces, Accumulator& acc);
+
+	/**
+	* @brief works out the pieces m adds and removes
+	* @param mover The side that played m.
+	* @param m The move that was played.
+	* @param captured The piece m captured, NONE_PIECE if it isnt a capture.
+	*/
+	static DirtyPieces dirtyPieces(Color mover, const Move& m, Piece captured);
+
+	/**
+	* @brief computes the accumulator of the position after a move from the one before it. the perspective of a side whose
+	* king moved is refreshed, since every one of its features depends on the king square
+	* @param pieces The pieces after the move.
+	* @param dirty The changes the move made.
+	* @param before The accumulator of the position before the move.
+	* @param after Set to the accumulator of the position after the move.
+	*/
+	static void update(const PieceBitboards& pieces, const DirtyPieces& dirty, const Accumulator& before, Accumulator& after);
+
+	/**
+	* @brief runs the output layer, from the POV of the side to move
+	*/
+	static Centipawns evaluate(const Accumulator& acc, Color sideToMove);
+
+private:
+	static bool s_loaded;
+	alignas(32) static std::array<std::array<int16_t, HIDDEN_SIZE>, INPUT_SIZE> s_featureWeights;
+	alignas(32) static std::array<int16_t, HIDDEN_SIZE> s_featureBiases;
+	alignas(32) static std::array<int16_t, 2 * HIDDEN_SIZE> s_outputWeights;
+	static int32_t s_outputBias;
+
+	/**
+	* @brief index of a piece on a square as seen from perspective, whose king is on kingSquare. black sees the board flipped
+	* vertically and with the colors swapped, so both perspectives share the same weights
+	*/
+	static inline int featureIndex(Color perspective, Square kingSquare, Color pieceColor, Piece piece, Square sq) {
+		int flip	 = perspective == WHITE ? 0 : 56;
+		int relColor = pieceColor == perspective ? 0 : 1;
+		return ((kingSquare ^ flip) * 12 + relColor * 6 + piece) * 64 + (sq ^ flip);
+	}
+
+	static void refreshPerspective(const PieceBitboards& pieces, Color perspective, Accumulator& acc);
+	static void addFeature(std::array<int16_t, HIDDEN_SIZE>& values, int feature);
+	static void subFeature(std::array<int16_t, HIDDEN_SIZE>& values, int feature);
+
+	/**
+	* @brief sum of clamp(values[i], 0, QA) * weights[i], with avx2 if the build has it
+	*/
+	static int32_t clippedDot(const int16_t* values, const int16_t* weights);
+};
+#endif
@@ -0,0 +1,131 @@
+#include "search_context.hpp"
+#include "transposition_table.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+SearchContext::SearchContext() : tt(&TranspositionTable::shared()), m_stop(false), m_pondering(false) {}
+
+void SearchContext::reset() {
+	for (auto& killers : killerMoves) killers.fill(Move());
+	for (auto& fromTable : history) {
+		for (auto& toTable : fromTable) toTable.fill(0);
+	}
+	for (SearchStackEntry& entry : stack) {
+		entry.staticEval  = NONE_SCORE;
+		entry.currentMove = Move();
+	}
+	pvLength.fill(0);
+	previousPV.clear();
+	excludedRootMoves.clear();
+	rootMoves.clear();
+	tbHits				  = 0;
+	nodes				  = 0;
+	qnodes				  = 0;
+	lazyEvals			  = 0;
+	selDepth			  = 0;
+	startTime			  = Clock::now();
+	cutoffTime			  = Clock::time_point::max();
+	clockStartTime		  = startTime;
+	m_stop				  = false;
+	m_pondering			  = false;
+	m_clockPending		  = false;
+	m_searchPrepared	  = false;
+	m_nodesUntilTimeCheck = TIME_CHECK_INTERVAL;
+	nodeLimit			  = 0;
+}
+
+void SearchContext::startSearch(int maxTimeMs) {
+	previousPV.clear();
+	tbHits				  = 0;
+	nodes				  = 0;
+	qnodes				  = 0;
+	lazyEvals			  = 0;
+	selDepth			  = 0;
+	startTime			  = Clock::now();
+	m_maxTimeMs			  = maxTimeMs;
+	m_nodesUntilTimeCheck = TIME_CHECK_INTERVAL;
+	// a prepared search already had its stop flag cleared by the caller, anything set since then is a real stop
+	if (!m_searchPrepared) m_stop = false;
+	m_searchPrepared = false;
+	m_clockPending		  = pondering();
+	if (m_clockPending) {
+		cutoffTime = Clock::time_point::max();
+	} else {
+		startClock(startTime);
+	}
+}
+
+void SearchContext::prepareSearch() {
+	m_stop			 = false;
+	m_searchPrepared = true;
+}
+
+void SearchContext::setPondering(bool pondering) {
+	m_pondering.store(pondering, std::memory_order_relaxed);
+}
+
+void SearchContext::ponderhit() {
+	m_pondering.store(false, std::memory_order_relaxed);
+}
+
+void SearchContext::startClock(Clock::time_point now) {
+	clockStartTime = now;
+	cutoffTime	   = m_maxTimeMs < 0 ? Clock::time_point::max() : now + std::chrono::milliseconds(m_maxTimeMs);
+	m_clockPending = false;
+}
+
+void SearchContext::stop() {
+	m_stop.store(true, std::memory_order_relaxed);
+}
+
+bool SearchContext::checkTime() {
+	if (deterministic && m_maxTimeMs < 0) return stopped();
+	// ponderhit only flips an atomic, the search thread starts its own clock the next time it looks
+	if (m_clockPending) {
+		if (pondering()) return stopped();
+		startClock(Clock::now());
+	}
+	if (cutoffTime != Clock::time_point::max() && Clock::now() > cutoffTime) {
+		m_stop.store(true, std::memory_order_relaxed);
+	}
+	return stopped();
+}
+
+Moves SearchContext::principalVariation() const {
+	return Moves(pvTable[0].begin(), pvTable[0].begin() + pvLength[0]);
+}
+
+void SearchContext::storeKiller(int plyFromRoot, const Move& m) {
+	if (plyFromRoot >= MAX_SEARCH_DEPTH) return;
+	if (m != killerMoves[plyFromRoot][0]) {
+		killerMoves[plyFromRoot][1] = killerMoves[plyFromRoot][0];
+		killerMoves[plyFromRoot][0] = m;
+	}
+}
+
+void SearchContext::updateHistory(Color side, const Move& cutoffMove, const Move* quietsTried, int numQuietsTried, int depthLeft) {
+	int bonus = std::min(depthLeft * depthLeft, MAX_HISTORY / 4);
+	applyHistoryBonus(history[side][cutoffMove.getFrom()][cutoffMove.getTo()], bonus);
+	for (int i = 0; i < numQuietsTried; i++) {
+		applyHistoryBonus(history[side][quietsTried[i].getFrom()][quietsTried[i].getTo()], -bonus);
+	}
+}
+
+MoveScore SearchContext::historyScore(Color side, const Move& m) const {
+	return history[side][m.getFrom()][m.getTo()] - MAX_HISTORY;
+}
+
+int64_t SearchContext::elapsedMs() const {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count();
+}
+
+int64_t SearchContext::clockElapsedMs() {
+	checkTime();
+	if (m_clockPending) return 0;
+	return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - clockStartTime).count();
+}
+
+void SearchContext::applyHistoryBonus(int& entry, int bonus) {
+	entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+}
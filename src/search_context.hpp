@@ -0,0 +1,337 @@
+#ifndef SEARCH_CONTEXT_H
+#define SEARCH_CONTEXT_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "consts.hpp"
+#include "move.hpp"
+
+class SearchListener;
+class TranspositionTable;
+
+/**
+* @brief per ply scratch data for the node currently being searched at that ply
+*/
+struct SearchStackEntry {
+	/**
+	* @brief static evaluation of the node, NONE_SCORE if it wasnt needed
+	*/
+	Centipawns staticEval = NONE_SCORE;
+
+	/**
+	* @brief move currently being searched from this node
+	*/
+	Move currentMove;
+};
+
+/**
+* @brief owns all the mutable state of one search. Eval only holds constants, so any number of
+* searches can run at once as long as each one has its own context. the transposition table is still shared.
+*/
+class SearchContext {
+public:
+	static constexpr int MAX_SEARCH_DEPTH = 64;
+	static constexpr int NUM_KILLER_MOVES = 2;
+
+	/**
+	* @brief history scores are kept in [-MAX_HISTORY, MAX_HISTORY] so they can be mapped below BAD_CAPTURE_SCORE
+	*/
+	static constexpr int MAX_HISTORY = 8192;
+
+	/**
+	* @brief the clock is only read once every this many nodes. at around a million nodes per second this bounds
+	* the time overshoot to a couple of milliseconds
+	*/
+	static constexpr int TIME_CHECK_INTERVAL = 2048;
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	/**
+	* @brief store killer moves.the killer move is a quiet move which caused a beta cutoff in a sibling cut branch. the idea is that these moves are likely to be good in this branch as well
+	*/
+	std::array<std::array<Move, NUM_KILLER_MOVES>, MAX_SEARCH_DEPTH> killerMoves{};
+
+	/**
+	* @brief butterfly history table indexed by [side to move][from][to]. quiet moves that cause beta cutoffs anywhere in the tree gain score
+	*/
+	std::array<std::array<std::array<int, 64>, 64>, 2> history{};
+
+	/**
+	* @brief per ply stack, index 0 is the root
+	*/
+	std::array<SearchStackEntry, MAX_SEARCH_DEPTH + 1> stack{};
+
+	/**
+	* @brief triangular principal variation table. row ply holds the best line from the node at that ply,
+	* stored in columns [ply, pvLength[ply]) so a parent can copy its childs row without shifting it
+	*/
+	std::array<std::array<Move, MAX_SEARCH_DEPTH + 1>, MAX_SEARCH_DEPTH + 1> pvTable{};
+
+	/**
+	* @brief end column of each row of pvTable
+	*/
+	std::array<int, MAX_SEARCH_DEPTH + 1> pvLength{};
+
+	/**
+	* @brief score of the best root move found so far in the current iteration, NONE_SCORE until the first root move
+	* has been searched. lets an aborted iteration still report the moves it finished
+	*/
+	Centipawns rootBestScore = NONE_SCORE;
+
+	/**
+	* @brief principal variation of the last completed iteration, searched first at each ply
+	*/
+	Moves previousPV;
+
+	/**
+	* @brief root moves the search skips. multi pv fills this with the moves of the lines it already found
+	*/
+	Moves excludedRootMoves;
+
+	/**
+	* @brief the only root moves the search looks at, empty for all of them. filled from the tablebase dtz ranking when the root
+	* position has a table, so the search only has to choose among the moves that keep the best result
+	*/
+	Moves rootMoves;
+
+	/**
+	* @brief positions answered by the tablebases since startSearch
+	*/
+	uint64_t tbHits = 0;
+
+	/**
+	* @brief number of nodes searched by the main search
+	*/
+	uint64_t nodes = 0;
+
+	/**
+	* @brief number of quiescence search nodes visited
+	*/
+	uint64_t qnodes = 0;
+
+	/**
+	* @brief number of quiescence stand pats the lazy evaluation answered without computing mobility
+	*/
+	uint64_t lazyEvals = 0;
+
+	/**
+	* @brief the search stops once nodes + qnodes reaches this, 0 for no limit. kept across startSearch calls.
+	* no node is counted after the limit is reached, so a search always ends on exactly this many nodes
+	*/
+	uint64_t nodeLimit = 0;
+
+	/**
+	* @brief never reads the clock in a search without a time limit, so the result only depends on the position, the depth and node
+	* limits and the state of the context and tt, which makes searches reproducible across runs and machines. a search given a time
+	* limit still keeps to it, so an engine in deterministic mode never loses on time. kept across reset and startSearch
+	*/
+	bool deterministic = false;
+
+	/**
+	* @brief deepest ply reached since startSearch, quiescence search included
+	*/
+	int selDepth = 0;
+
+	/**
+	* @brief table the search reads and writes, not owned, TranspositionTable::shared() unless set. searches running at the same time
+	* must not share one
+	*/
+	TranspositionTable* tt;
+
+	/**
+	* @brief receives every iteration of iterative deepening and the end of the search. not owned, nullptr for a silent search
+	*/
+	SearchListener* listener = nullptr;
+
+	/**
+	* @brief time the current search started
+	*/
+	Clock::time_point startTime = Clock::now();
+
+	/**
+	* @brief the search is aborted once this point in time has passed
+	*/
+	Clock::time_point cutoffTime = Clock::time_point::max();
+
+	/**
+	* @brief time the clock of the side to move started running. the same as startTime, unless the search started as a ponder search,
+	* in which case it is the moment the ponderhit was noticed
+	*/
+	Clock::time_point clockStartTime = Clock::now();
+
+	SearchContext();
+
+	/**
+	* @brief clears the killers, history and counters, and removes the time and node limits
+	*/
+	void reset();
+
+	/**
+	* @brief starts a new search with the given time limit, keeping the history and killers from the last one.
+	* if the context is pondering the time limit only starts counting once ponderhit is called
+	* @param maxTimeMs Time limit in milliseconds, or a negative number for no limit.
+	*/
+	void startSearch(int maxTimeMs = -1);
+
+	/**
+	* @brief clears the stop flag for a search that is about to start on another thread. call it before launching that thread,
+	* then a stop that comes in before the thread reaches startSearch still stops the search instead of being cleared by it
+	*/
+	void prepareSearch();
+
+	/**
+	* @brief marks the next search as a ponder search on the opponents expected reply. its clock doesnt run until ponderhit
+	*/
+	void setPondering(bool pondering);
+
+	/**
+	* @brief the opponent played the expected reply, so the ponder search turns into a normal timed search without restarting.
+	* safe to call from another thread
+	*/
+	void ponderhit();
+
+	/**
+	* @brief returns true while the search is a ponder search that hasnt been hit yet
+	*/
+	inline bool pondering() const {
+		return m_pondering.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* @brief asks the search to stop as soon as possible. safe to call from another thread
+	*/
+	void stop();
+
+	/**
+	* @brief reads the clock and raises the stop flag if the time limit has passed. returns true if the search should stop.
+	* never reads the clock in deterministic mode without a time limit
+	*/
+	bool checkTime();
+
+	/**
+	* @brief counts one visited node (main or quiescence) and calls checkTime once every TIME_CHECK_INTERVAL of them
+	*/
+	inline void tick() {
+		if (nodeLimit && nodes + qnodes >= nodeLimit) {
+			m_stop.store(true, std::memory_order_relaxed);
+		}
+		if (--m_nodesUntilTimeCheck <= 0) {
+			m_nodesUntilTimeCheck = TIME_CHECK_INTERVAL;
+			checkTime();
+		}
+	}
+
+	/**
+	* @brief returns true if the search has been stopped or has run out of time. only a relaxed atomic load, cheap enough for every move
+	*/
+	inline bool stopped() const {
+		return m_stop.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* @brief empties the line of the node at the given ply. called on entry to every node
+	*/
+	inline void clearPV(int plyFromRoot) {
+		pvLength[plyFromRoot] = plyFromRoot;
+	}
+
+	/**
+	* @brief sets the line of the node at the given ply to m followed by the line of its child
+	*/
+	inline void updatePV(int plyFromRoot, const Move& m) {
+		pvTable[plyFromRoot][plyFromRoot] = m;
+		for (int i = plyFromRoot + 1; i < pvLength[plyFromRoot + 1]; i++) {
+			pvTable[plyFromRoot][i] = pvTable[plyFromRoot + 1][i];
+		}
+		pvLength[plyFromRoot] = std::max(pvLength[plyFromRoot + 1], plyFromRoot + 1);
+	}
+
+	/**
+	* @brief returns true if m is in excludedRootMoves, or rootMoves is set and m isnt in it
+	*/
+	inline bool isExcludedRootMove(const Move& m) const {
+		if (!rootMoves.empty() && std::find(rootMoves.begin(), rootMoves.end(), m) == rootMoves.end()) return true;
+		return std::find(excludedRootMoves.begin(), excludedRootMoves.end(), m) != excludedRootMoves.end();
+	}
+
+	/**
+	* @brief returns the line found from the root by the last search
+	*/
+	Moves principalVariation() const;
+
+	/**
+	* @brief records a quiet move that caused a beta cutoff at the given ply
+	*/
+	void storeKiller(int plyFromRoot, const Move& m);
+
+	/**
+	* @brief rewards the quiet move that caused a cutoff and penalizes the quiet moves that were searched before it
+	* @param side The side that made the moves.
+	* @param cutoffMove The move that caused the beta cutoff.
+	* @param quietsTried The quiet moves searched before the cutoff move.
+	* @param numQuietsTried Number of moves in quietsTried.
+	* @param depthLeft Remaining depth of the node, deeper cutoffs get bigger bonuses.
+	*/
+	void updateHistory(Color side, const Move& cutoffMove, const Move* quietsTried, int numQuietsTried, int depthLeft);
+
+	/**
+	* @brief ordering score for a quiet move. always in [-2 * MAX_HISTORY, 0] so quiet moves stay behind bad captures
+	*/
+	MoveScore historyScore(Color side, const Move& m) const;
+
+	/**
+	* @brief milliseconds since startSearch was called
+	*/
+	int64_t elapsedMs() const;
+
+	/**
+	* @brief milliseconds the clock has been running for, which is what the time limits are measured against. 0 while pondering
+	*/
+	int64_t clockElapsedMs();
+
+private:
+	/**
+	* @brief set from outside the search thread to abort it
+	*/
+	std::atomic<bool> m_stop;
+
+	/**
+	* @brief set while pondering, cleared from outside the search thread on ponderhit
+	*/
+	std::atomic<bool> m_pondering;
+
+	/**
+	* @brief true from the start of a ponder search until the search thread has noticed the ponderhit and started the clock
+	*/
+	bool m_clockPending = false;
+
+	/**
+	* @brief set by prepareSearch, tells the next startSearch to keep the stop flag as it is
+	*/
+	bool m_searchPrepared = false;
+
+	/**
+	* @brief time limit passed to startSearch, applied once the clock starts
+	*/
+	int m_maxTimeMs = -1;
+
+	/**
+	* @brief nodes left until tick next reads the clock
+	*/
+	int m_nodesUntilTimeCheck = TIME_CHECK_INTERVAL;
+
+	/**
+	* @brief adds bonus to a history entry, scaled down as the entry approaches MAX_HISTORY so it never leaves the range
+	*/
+	static void applyHistoryBonus(int& entry, int bonus);
+
+	/**
+	* @brief starts the time limit running from now
+	*/
+	void startClock(Clock::time_point now);
+};
+#endif
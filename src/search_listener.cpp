@@ -0,0 +1,60 @@
+#include "search_listener.hpp"
+
+#include <sstream>
+
+UciSearchListener::UciSearchListener(std::ostream& out, std::mutex* outMutex) : m_out(out), m_outMutex(outMutex) {}
+
+void UciSearchListener::onIteration(const SearchInfo& info) {
+	std::string line = formatInfo(info);
+	if (m_outMutex) {
+		std::lock_guard<std::mutex> lock(*m_outMutex);
+		m_out << line << std::endl;
+	} else {
+		m_out << line << std::endl;
+	}
+}
+
+std::string UciSearchListener::formatScore(Centipawns score, const Moves& pv) {
+	if (score >= CHECKMATE_SCORE) return "mate " + std::to_string((pv.size() + 1) / 2);
+	if (score <= -CHECKMATE_SCORE) return "mate -" + std::to_string(pv.size() / 2);
+	return "cp " + std::to_string(score);
+}
+
+std::string UciSearchListener::formatInfo(const SearchInfo& info) {
+	std::ostringstream line;
+	line << "info depth " << info.depth << " seldepth " << info.selDepth << " multipv " << info.multiPV << " score " << formatScore(info.score, info.pv)
+		 << " nodes " << info.nodes << " nps " << info.nps << " hashfull " << info.hashfull << " tbhits " << info.tbHits << " time " << info.elapsedMs << " pv";
+	for (const Move& m : info.pv) {
+		line << " " << m.UCInotation();
+	}
+	return line.str();
+}
+
+JsonSearchListener::JsonSearchListener(std::ostream& out) : m_out(out) {}
+
+void JsonSearchListener::onIteration(const SearchInfo& info) {
+	m_out << formatJson("iteration", info) << '\n';
+}
+
+void JsonSearchListener::onSearchEnd(const SearchInfo& info) {
+	// flushed once per search rather than per line, the iterations before it go out with it
+	m_out << formatJson("end", info) << std::endl;
+}
+
+std::string JsonSearchListener::formatJson(const std::string& type, const SearchInfo& info) {
+	std::ostringstream json;
+	json << "{\"type\":\"" << type << "\",\"depth\":" << info.depth << ",\"seldepth\":" << info.selDepth << ",\"multipv\":" << info.multiPV;
+	if (isMateScore(info.score)) {
+		// same sign convention as uci, negative if the side to move gets mated
+		json << ",\"mate\":" << (info.score > 0 ? (int)(info.pv.size() + 1) / 2 : -(int)info.pv.size() / 2);
+	} else {
+		json << ",\"cp\":" << info.score;
+	}
+	json << ",\"nodes\":" << info.nodes << ",\"nps\":" << info.nps << ",\"hashfull\":" << info.hashfull << ",\"tbhits\":" << info.tbHits << ",\"time\":" << info.elapsedMs
+		 << ",\"partial\":" << (info.partial ? "true" : "false") << ",\"pv\":[";
+	for (size_t i = 0; i < info.pv.size(); i++) {
+		json << (i ? "," : "") << "\"" << info.pv[i].UCInotation() << "\"";
+	}
+	json << "]}";
+	return json.str();
+}
@@ -0,0 +1,129 @@
+#ifndef SEARCH_LISTENER_H
+#define SEARCH_LISTENER_H
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include "consts.hpp"
+#include "move.hpp"
+
+/**
+* @brief snapshot of a search, sent after every iteration of iterative deepening and once more when the search ends
+*/
+struct SearchInfo {
+	int depth;
+
+	/**
+	* @brief deepest ply reached so far, quiescence search included
+	*/
+	int selDepth;
+	Centipawns score;
+
+	/**
+	* @brief main and quiescence nodes searched so far
+	*/
+	uint64_t nodes;
+	uint64_t nps;
+
+	/**
+	* @brief transposition table usage in permille
+	*/
+	int hashfull;
+	int64_t elapsedMs;
+	Moves pv;
+
+	/**
+	* @brief true if the iteration was aborted and only the root moves it finished are reported
+	*/
+	bool partial;
+
+	/**
+	* @brief 1 based index of the line in a multi pv search, always 1 otherwise
+	*/
+	int multiPV = 1;
+
+	/**
+	* @brief positions answered by the endgame tablebases
+	*/
+	uint64_t tbHits = 0;
+};
+
+/**
+* @brief receives search progress from iterative deepening. the search never prints anything itself, so every bit of output
+* goes through one of these. called on the thread running the search, so implementations must be cheap and thread safe
+*/
+class SearchListener {
+public:
+	virtual ~SearchListener() = default;
+
+	/**
+	* @brief called after every completed (or partially completed) iteration, once per line in a multi pv search
+	*/
+	virtual void onIteration(const SearchInfo& info) = 0;
+
+	/**
+	* @brief called once when the search is over, with the final line, score and node count
+	*/
+	virtual void onSearchEnd(const SearchInfo& info) {}
+};
+
+/**
+* @brief drops everything
+*/
+class SilentSearchListener : public SearchListener {
+public:
+	void onIteration(const SearchInfo& info) override {}
+};
+
+/**
+* @brief writes each iteration as a UCI info line
+*/
+class UciSearchListener : public SearchListener {
+public:
+	/**
+	* @param out Stream the info lines are written to.
+	* @param outMutex Held while writing a line if set, for streams shared with other threads.
+	*/
+	UciSearchListener(std::ostream& out, std::mutex* outMutex = nullptr);
+
+	void onIteration(const SearchInfo& info) override;
+
+	/**
+	* @brief formats a score as "cp x" or "mate n". mate distances are read off the pv, which always ends in the mate
+	*/
+	static std::string formatScore(Centipawns score, const Moves& pv);
+
+	/**
+	* @brief formats an info line, without the trailing newline
+	*/
+	static std::string formatInfo(const SearchInfo& info);
+
+private:
+	std::ostream& m_out;
+	std::mutex* m_outMutex;
+};
+
+/**
+* @brief writes each iteration, and the end of the search, as one JSON object per line for tools that dont want to parse UCI
+*/
+class JsonSearchListener : public SearchListener {
+public:
+	/**
+	* @param out Stream the JSON lines are written to.
+	*/
+	JsonSearchListener(std::ostream& out);
+
+	void onIteration(const SearchInfo& info) override;
+	void onSearchEnd(const SearchInfo& info) override;
+
+	/**
+	* @brief formats info as a single line JSON object whose type field is type
+	*/
+	static std::string formatJson(const std::string& type, const SearchInfo& info);
+
+private:
+	std::ostream& m_out;
+};
+#endif
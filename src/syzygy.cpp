@@ -0,0 +1,989 @@
+#include "syzygy.hpp"
+#include "endgame.hpp"
+#include "lookup_tables.hpp"
+#include "move.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * the file format and the position indexing follow the syzygy generator. a table file starts with a 4 byte magic and a header
+ * listing the order the pieces are encoded in, followed by one sub table per side to move (wdl only, and only if the material isnt
+ * symmetric) and per file of the leading pawn (a to d, tables with pawns only). each sub table is a sequence of fixed size blocks of
+ * canonical huffman codes, whose symbols expand through a tree of pairs ("recursive pairing") into the stored values.
+ *
+ * pieces in the files use their own codes: 1 to 6 for pawn, knight, bishop, rook, queen and king, plus 8 for black.
+ */
+
+namespace {
+// flags of a sub table
+constexpr uint8_t TB_STM		  = 1;
+constexpr uint8_t TB_MAPPED		  = 2;
+constexpr uint8_t TB_WIN_PLIES	  = 4;
+constexpr uint8_t TB_LOSS_PLIES	  = 8;
+constexpr uint8_t TB_WIDE		  = 16;
+constexpr uint8_t TB_SINGLE_VALUE = 128;
+
+// flags of the file header
+constexpr uint8_t TB_SPLIT	   = 1;
+constexpr uint8_t TB_HAS_PAWNS = 2;
+
+constexpr uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+constexpr uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+/**
+* @brief dtz values are ranked against each other at the root, a certain win is worth this much
+*/
+constexpr int MAX_DTZ = 1 << 18;
+
+template <typename T>
+T readLittleEndian(const uint8_t* p) {
+	T value = 0;
+	for (size_t i = 0; i < sizeof(T); i++) value |= T(p[i]) << (8 * i);
+	return value;
+}
+
+template <typename T>
+T readBigEndian(const uint8_t* p) {
+	T value = 0;
+	for (size_t i = 0; i < sizeof(T); i++) value = value << 8 | p[i];
+	return value;
+}
+
+inline int fileOf(int sq) {
+	return sq & 7;
+}
+inline int rankOf(int sq) {
+	return sq >> 3;
+}
+
+/**
+* @brief distance of a square from the a1-h8 diagonal, positive above it
+*/
+inline int offDiagonal(int sq) {
+	return rankOf(sq) - fileOf(sq);
+}
+
+inline int flipDiagonal(int sq) {
+	return ((sq >> 3) | (sq << 3)) & 63;
+}
+
+/**
+* @brief code of piece as used in the table files
+*/
+inline uint8_t fileCode(Color color, Piece piece) {
+	return (6 - piece) | color << 3;
+}
+
+/**
+* @brief fen of a position holding only the pieces in squares, given as fen characters with a1 first
+*/
+std::string fenOf(const std::array<char, 64>& squares, Color sideToMove) {
+	std::string fen;
+	for (int rank = 7; rank >= 0; rank--) {
+		int empty = 0;
+		for (int file = 0; file < 8; file++) {
+			char piece = squares[rank * 8 + file];
+			if (!piece) {
+				empty++;
+				continue;
+			}
+			if (empty) fen += std::to_string(empty);
+			fen += piece;
+			empty = 0;
+		}
+		if (empty) fen += std::to_string(empty);
+		if (rank) fen += '/';
+	}
+	return fen + (sideToMove == WHITE ? " w - - 0 1" : " b - - 0 1");
+}
+
+int s_mapPawns[64];
+int s_mapB1H1H7[64];
+int s_mapA1D1D4[64];
+int s_mapKK[10][64];
+uint64_t s_binomial[7][64];
+int s_leadPawnIdx[6][64];
+int s_leadPawnsSize[6][4];
+}  // namespace
+
+/**
+* @brief one sub table: the huffman code, pair tree and blocks of a side to move and leading pawn file, plus how its pieces are grouped
+*/
+struct Syzygy::PairsData {
+	uint8_t flags = 0;
+	size_t blockSize = 0;
+
+	/**
+	* @brief there is a sparse index entry every span values
+	*/
+	size_t span = 0;
+	uint32_t numBlocks = 0;
+	int maxSymLen = 0;
+
+	/**
+	* @brief also holds the value of a single value table
+	*/
+	int minSymLen = 0;
+
+	/**
+	* @brief lowest symbol of each code length, uint16 each
+	*/
+	const uint8_t* lowestSym = nullptr;
+
+	/**
+	* @brief the two symbols each symbol expands to, 12 bits each in 3 bytes. a right symbol of 0xFFF marks a value
+	*/
+	const uint8_t* btree = nullptr;
+
+	/**
+	* @brief number of values in each block minus one, uint16 each
+	*/
+	const uint8_t* blockLength = nullptr;
+	size_t blockLengthSize = 0;
+
+	/**
+	* @brief block (uint32) and offset into it (uint16) of every span-th value, starting half a span in
+	*/
+	const uint8_t* sparseIndex = nullptr;
+	size_t sparseIndexSize = 0;
+	const uint8_t* data = nullptr;
+
+	/**
+	* @brief lowest code of each length, left aligned in 64 bits, so the length of the next code is the first entry it isnt below
+	*/
+	std::vector<uint64_t> base64;
+
+	/**
+	* @brief number of values each symbol expands to, minus one
+	*/
+	std::vector<uint8_t> symlen;
+	std::array<uint8_t, MAX_PIECES> pieces{};
+	std::array<uint64_t, MAX_PIECES + 1> groupIdx{};
+	std::array<int, MAX_PIECES + 1> groupLen{};
+
+	/**
+	* @brief start of the dtz value map of each result, dtz tables only
+	*/
+	std::array<uint16_t, 4> mapIdx{};
+};
+
+/**
+* @brief a wdl or dtz file of a table, mapped on its first probe
+*/
+struct Syzygy::MappedFile {
+	std::string path;
+	std::atomic<bool> ready{false};
+	void* base = nullptr;
+	size_t size = 0;
+
+	/**
+	* @brief [side to move][leading pawn file], dtz files only store one side
+	*/
+	std::array<std::array<PairsData, 4>, 2> items;
+
+	/**
+	* @brief dtz value maps, dtz files only
+	*/
+	const uint8_t* dtzMap = nullptr;
+};
+
+/**
+* @brief the tables of one material signature, named with the stronger side first, e.g. KRvK. the same table answers KvKR with the
+* colors swapped
+*/
+struct Syzygy::Table {
+	std::string name;
+	MaterialKey key;
+	MaterialKey key2;
+	int pieceCount;
+	bool hasPawns;
+
+	/**
+	* @brief true if some side has a piece that is the only one of its kind, which lets three pieces be encoded together
+	*/
+	bool hasUniquePieces;
+
+	/**
+	* @brief pawns of the leading color, then of the other color. the leading color is the one with fewer pawns, if both have some
+	*/
+	std::array<int, 2> pawnCount;
+
+	/**
+	* @brief wdl file, then dtz file
+	*/
+	std::array<MappedFile, 2> files;
+
+	PairsData& get(bool dtz, int stm, int file) {
+		return files[dtz].items[dtz ? 0 : stm][hasPawns ? file : 0];
+	}
+};
+
+std::vector<std::unique_ptr<Syzygy::Table>> Syzygy::s_tables;
+std::unordered_map<MaterialKey, Syzygy::Table*> Syzygy::s_byKey;
+int Syzygy::s_largest = 0;
+std::string Syzygy::s_verifyFailure;
+std::mutex Syzygy::s_mapMutex;
+
+void Syzygy::initIndexTables() {
+	static bool initialized = false;
+	if (initialized) return;
+	initialized = true;
+
+	// squares below the a1-h8 diagonal, b1 to h7
+	int code = 0;
+	for (int sq = 0; sq < 64; sq++) {
+		if (offDiagonal(sq) < 0) s_mapB1H1H7[sq] = code++;
+	}
+
+	// the a1-d1-d4 triangle, with the squares on the diagonal last
+	code = 0;
+	std::vector<int> diagonal;
+	for (int sq = 0; sq <= d4; sq++) {
+		if (offDiagonal(sq) < 0 && fileOf(sq) <= 3) s_mapA1D1D4[sq] = code++;
+		else if (!offDiagonal(sq) && fileOf(sq) <= 3) diagonal.push_back(sq);
+	}
+	for (int sq : diagonal) s_mapA1D1D4[sq] = code++;
+
+	// the 462 placements of two kings that arent next to each other with the first in the triangle. if the first is on the
+	// diagonal, the second cant be above it. placements with both kings on the diagonal come last
+	std::vector<std::pair<int, int>> bothOnDiagonal;
+	code = 0;
+	for (int idx = 0; idx < 10; idx++) {
+		for (int sq1 = 0; sq1 <= d4; sq1++) {
+			// b1 is mapped to 0, not a1
+			if (s_mapA1D1D4[sq1] != idx || (!idx && sq1 != b1)) continue;
+			for (int sq2 = 0; sq2 < 64; sq2++) {
+				if (std::abs(fileOf(sq1) - fileOf(sq2)) <= 1 && std::abs(rankOf(sq1) - rankOf(sq2)) <= 1) continue;
+				if (!offDiagonal(sq1) && offDiagonal(sq2) > 0) continue;
+				if (!offDiagonal(sq1) && !offDiagonal(sq2)) bothOnDiagonal.emplace_back(idx, sq2);
+				else s_mapKK[idx][sq2] = code++;
+			}
+		}
+	}
+	for (auto [idx, sq2] : bothOnDiagonal) s_mapKK[idx][sq2] = code++;
+
+	// s_binomial[k][n] ways of picking k of n squares
+	s_binomial[0][0] = 1;
+	for (int n = 1; n < 64; n++) {
+		for (int k = 0; k < 7 && k <= n; k++) {
+			s_binomial[k][n] = (k > 0 ? s_binomial[k - 1][n - 1] : 0) + (k < n ? s_binomial[k][n - 1] : 0);
+		}
+	}
+
+	// s_mapPawns numbers a2-h7 so that the leading pawn, the one closest to the edge and then lowest, has the highest number.
+	// with the leading pawn on a square, the other pawns have that many squares left
+	int availableSquares = 47;
+	for (int leadPawnsCnt = 1; leadPawnsCnt <= 5; leadPawnsCnt++) {
+		for (int file = 0; file < 4; file++) {
+			int idx = 0;
+			for (int rank = 1; rank <= 6; rank++) {
+				int sq = rank * 8 + file;
+				if (leadPawnsCnt == 1) {
+					s_mapPawns[sq]	   = availableSquares--;
+					s_mapPawns[sq ^ 7] = availableSquares--;
+				}
+				s_leadPawnIdx[leadPawnsCnt][sq] = idx;
+				idx += s_binomial[leadPawnsCnt - 1][s_mapPawns[sq]];
+			}
+			s_leadPawnsSize[leadPawnsCnt][file] = idx;
+		}
+	}
+}
+
+int Syzygy::init(const std::string& paths) {
+	clear();
+	initIndexTables();
+	if (paths.empty() || paths == "<empty>") return 0;
+
+	std::istringstream dirs(paths);
+	std::string dir;
+	while (std::getline(dirs, dir, ':')) {
+		std::error_code error;
+		for (const auto& file : std::filesystem::directory_iterator(dir, error)) {
+			if (file.path().extension() != ".rtbw") continue;
+			std::string name = file.path().stem().string();
+
+			// KQRvKN: a king first on each side and at most MAX_PIECES in total
+			size_t v = name.find('v');
+			if (v == std::string::npos || name.find('v', v + 1) != std::string::npos || name.size() > MAX_PIECES + 1 ||
+				name.find_first_not_of("KQRBNPv") != std::string::npos) {
+				continue;
+			}
+			std::string sides[2] = {name.substr(0, v), name.substr(v + 1)};
+			if (sides[0].empty() || sides[1].empty() || sides[0][0] != 'K' || sides[1][0] != 'K') continue;
+
+			std::array<std::array<int, NONE_PIECE>, 2> counts{};
+			for (int color : {WHITE, BLACK}) {
+				for (char c : sides[color]) counts[color][fenPieceChartoPieceType(c)]++;
+			}
+			if (counts[WHITE][KING] != 1 || counts[BLACK][KING] != 1) continue;
+
+			MaterialKey key	 = materialKeyOf(name.c_str());
+			MaterialKey key2 = swapMaterialColors(key);
+			// the first directory with a table wins
+			if (s_byKey.count(key)) continue;
+
+			auto table		   = std::make_unique<Table>();
+			table->name		   = name;
+			table->key		   = key;
+			table->key2		   = key2;
+			table->pieceCount  = name.size() - 1;
+			table->hasPawns	   = counts[WHITE][PAWN] || counts[BLACK][PAWN];
+			table->hasUniquePieces = false;
+			for (int color : {WHITE, BLACK}) {
+				for (int piece = QUEEN; piece < NONE_PIECE; piece++) {
+					if (counts[color][piece] == 1) table->hasUniquePieces = true;
+				}
+			}
+			bool whiteLeads		= !counts[BLACK][PAWN] || (counts[WHITE][PAWN] && counts[BLACK][PAWN] >= counts[WHITE][PAWN]);
+			table->pawnCount	= {counts[whiteLeads ? WHITE : BLACK][PAWN], counts[whiteLeads ? BLACK : WHITE][PAWN]};
+			table->files[0].path = file.path().string();
+			std::filesystem::path dtzPath = file.path();
+			dtzPath.replace_extension(".rtbz");
+			if (std::filesystem::exists(dtzPath, error)) table->files[1].path = dtzPath.string();
+
+			s_byKey[key]  = table.get();
+			s_byKey[key2] = table.get();
+			s_largest	  = std::max(s_largest, table->pieceCount);
+			s_tables.push_back(std::move(table));
+		}
+	}
+	s_verifyFailure = verify();
+	return s_tables.size();
+}
+
+std::string Syzygy::verify() {
+	int found = 0;
+	for (const char* name : {"KQvK", "KRvK", "KPvK"}) {
+		auto it = s_byKey.find(materialKeyOf(name));
+		if (it == s_byKey.end()) continue;
+		found++;
+		bool hasDTZ = !it->second->files[1].path.empty();
+		char piece	= name[1];
+
+		// a prime step through the placements of the three pieces keeps this quick, and still puts each of them on every square
+		for (int idx = 0; idx < 64 * 64 * 64; idx += 251) {
+			int strongKing = idx & 63, strongPiece = (idx >> 6) & 63, weakKing = idx >> 12;
+			if (strongKing == strongPiece || weakKing == strongPiece || strongKing == weakKing ||
+				(LookupTables::s_kingAttacks[strongKing] & 1UL << weakKing)) {
+				continue;
+			}
+			if (piece == 'P' && (strongPiece < 8 || strongPiece >= 56)) continue;
+
+			for (Color strong : {WHITE, BLACK}) {
+				// black as the strong side is the same position upside down
+				int flip = strong == WHITE ? 0 : 56;
+				std::array<char, 64> squares{};
+				squares[strongKing ^ flip]	= strong == WHITE ? 'K' : 'k';
+				squares[strongPiece ^ flip] = strong == WHITE ? piece : (char)std::tolower(piece);
+				squares[weakKing ^ flip]	= strong == WHITE ? 'k' : 'K';
+
+				for (Color sideToMove : {WHITE, BLACK}) {
+					std::string fen = fenOf(squares, sideToMove);
+					Board b;
+					b.setToFen(fen.c_str());
+					if (b.inIllegalCheck()) continue;
+
+					bool strongToMove = sideToMove == strong;
+					Moves legalMoves  = b.moveGenerator.genLegalMoves();
+					WDLScore expected;
+					if (piece == 'P') {
+						bool win = Endgame::probeKPK(strongKing, strongPiece, weakKing, strongToMove ? WHITE : BLACK);
+						expected = !win ? WDL_DRAW : strongToMove ? WDL_WIN : WDL_LOSS;
+					} else if (strongToMove) {
+						expected = WDL_WIN;
+					} else if (legalMoves.empty()) {
+						expected = b.moveGenerator.inCheck() ? WDL_LOSS : WDL_DRAW;
+					} else {
+						bool takes = std::any_of(legalMoves.begin(), legalMoves.end(), [](const Move& m) { return m.getFlags() & CAPTURE; });
+						expected   = takes ? WDL_DRAW : WDL_LOSS;
+					}
+
+					ProbeState state;
+					if (probeWDL(b, state) != expected || state == PROBE_FAIL) return std::string(name) + " gives the wrong result for " + fen;
+					if (!hasDTZ) continue;
+
+					int dtz = probeDTZ(b, state);
+					if (state == PROBE_FAIL || (dtz > 0) != (expected > 0) || (dtz < 0) != (expected < 0)) {
+						return std::string(name) + " gives the wrong dtz for " + fen;
+					}
+					if (!strongToMove) continue;
+					for (const Move& m : legalMoves) {
+						b.execute(m);
+						bool mate = b.moveGenerator.inCheck() && !b.moveGenerator.hasLegalMoves();
+						b.undoMove();
+						if (mate && dtz != 1) return std::string(name) + " misses the mate in one in " + fen;
+					}
+				}
+			}
+		}
+	}
+	return found ? "" : "no KQvK, KRvK or KPvK table to check the set against";
+}
+
+bool Syzygy::verified() {
+	return !s_tables.empty() && s_verifyFailure.empty();
+}
+
+const std::string& Syzygy::verifyFailure() {
+	return s_verifyFailure;
+}
+
+void Syzygy::clear() {
+	for (auto& table : s_tables) {
+		for (MappedFile& file : table->files) {
+			if (file.base) munmap(file.base, file.size);
+		}
+	}
+	s_tables.clear();
+	s_byKey.clear();
+	s_largest = 0;
+	s_verifyFailure.clear();
+}
+
+int Syzygy::largest() {
+	return s_largest;
+}
+
+bool Syzygy::canProbe(const Board& b) {
+	const Board::BoardState& bs = b.boardState;
+	return s_largest && !bs.castlingRights.rights && std::popcount(bs.allColorPieces[WHITE] | bs.allColorPieces[BLACK]) <= s_largest;
+}
+
+MaterialKey Syzygy::materialKey(const Board& b, bool swapColors) {
+	return swapColors ? swapMaterialColors(b.boardState.materialKey) : b.boardState.materialKey;
+}
+
+template <bool DTZ>
+bool Syzygy::map(Table& table) {
+	MappedFile& file = table.files[DTZ];
+	if (file.ready.load(std::memory_order_acquire)) return file.base;
+
+	std::lock_guard<std::mutex> lock(s_mapMutex);
+	if (file.ready.load(std::memory_order_relaxed)) return file.base;
+
+	int fd = file.path.empty() ? -1 : open(file.path.c_str(), O_RDONLY);
+	struct stat st;
+	// every table file is a multiple of 64 bytes plus 16
+	if (fd != -1 && fstat(fd, &st) == 0 && st.st_size % 64 == 16) {
+		void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (base != MAP_FAILED) {
+			madvise(base, st.st_size, MADV_RANDOM);
+			const uint8_t* data = static_cast<const uint8_t*>(base);
+			if (!std::memcmp(data, DTZ ? DTZ_MAGIC : WDL_MAGIC, 4) && setup<DTZ>(table, data + 4, data + st.st_size)) {
+				file.base = base;
+				file.size = st.st_size;
+			} else {
+				munmap(base, st.st_size);
+			}
+		}
+	}
+	if (fd != -1) close(fd);
+	// a file that couldnt be used stays unmapped, without trying again on every probe
+	file.ready.store(true, std::memory_order_release);
+	return file.base;
+}
+
+template <bool DTZ>
+bool Syzygy::setup(Table& table, const uint8_t* data, const uint8_t* end) {
+	MappedFile& file	= table.files[DTZ];
+	const uint8_t* base = data - 4;
+	if (bool(*data & TB_HAS_PAWNS) != table.hasPawns || bool(*data & TB_SPLIT) != (table.key != table.key2)) return false;
+	data++;
+
+	const int sides	  = !DTZ && table.key != table.key2 ? 2 : 1;
+	const int maxFile = table.hasPawns ? 3 : 0;
+	// pawns on both sides, the pawns of the other color are a group of their own
+	const bool pp = table.hasPawns && table.pawnCount[1];
+
+	for (int f = 0; f <= maxFile; f++) {
+		for (int i = 0; i < sides; i++) table.get(DTZ, i, f) = PairsData();
+
+		int order[2][2] = {{*data & 0xF, pp ? data[1] & 0xF : 0xF}, {*data >> 4, pp ? data[1] >> 4 : 0xF}};
+		data += 1 + pp;
+		for (int k = 0; k < table.pieceCount; k++, data++) {
+			for (int i = 0; i < sides; i++) table.get(DTZ, i, f).pieces[k] = i ? *data >> 4 : *data & 0xF;
+		}
+
+		for (int i = 0; i < sides; i++) {
+			// the order of the pieces defines the groups: the leading pawns or the first two or three pieces, then runs of
+			// identical pieces. KRKN gives (3, 1)
+			PairsData& d = table.get(DTZ, i, f);
+			int n = 0, firstLen = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+			d.groupLen[0] = 1;
+			for (int k = 1; k < table.pieceCount; k++) {
+				if (--firstLen > 0 || d.pieces[k] == d.pieces[k - 1]) d.groupLen[n]++;
+				else d.groupLen[++n] = 1;
+			}
+			d.groupLen[++n] = 0;
+
+			// the groups are combined as g1 * N(g2) * N(g3) + g2 * N(g3) + g3, in the order given by the header. the leading group
+			// goes at order[0] and the pawns of the other color, if any, at order[1]
+			int next		= pp ? 2 : 1;
+			int freeSquares = 64 - d.groupLen[0] - (pp ? d.groupLen[1] : 0);
+			uint64_t idx	= 1;
+			for (int k = 0; next < n || k == order[i][0] || k == order[i][1]; k++) {
+				if (k == order[i][0]) {
+					d.groupIdx[0] = idx;
+					idx *= table.hasPawns ? s_leadPawnsSize[d.groupLen[0]][f] : table.hasUniquePieces ? 31332 : 462;
+				} else if (k == order[i][1]) {
+					d.groupIdx[1] = idx;
+					idx *= s_binomial[d.groupLen[1]][48 - d.groupLen[0]];
+				} else {
+					d.groupIdx[next] = idx;
+					idx *= s_binomial[d.groupLen[next]][freeSquares];
+					freeSquares -= d.groupLen[next++];
+				}
+				if (k > MAX_PIECES) return false;
+			}
+			d.groupIdx[n] = idx;
+		}
+	}
+
+	data += (data - base) & 1;
+	for (int f = 0; f <= maxFile; f++) {
+		for (int i = 0; i < sides; i++) {
+			data = setSizes(table.get(DTZ, i, f), data);
+			if (!data || data > end) return false;
+		}
+	}
+
+	if (DTZ) {
+		file.dtzMap = data;
+		for (int f = 0; f <= maxFile; f++) {
+			PairsData& d = table.get(DTZ, 0, f);
+			if (!(d.flags & TB_MAPPED)) continue;
+			if (d.flags & TB_WIDE) {
+				data += (data - base) & 1;
+				for (int i = 0; i < 4 && data < end; i++) {
+					d.mapIdx[i] = (data - file.dtzMap) / 2 + 1;
+					data += 2 * readLittleEndian<uint16_t>(data) + 2;
+				}
+			} else {
+				for (int i = 0; i < 4 && data < end; i++) {
+					d.mapIdx[i] = data - file.dtzMap + 1;
+					data += *data + 1;
+				}
+			}
+		}
+		data += (data - base) & 1;
+	}
+
+	for (int f = 0; f <= maxFile; f++) {
+		for (int i = 0; i < sides; i++) {
+			PairsData& d  = table.get(DTZ, i, f);
+			d.sparseIndex = data;
+			data += d.sparseIndexSize * 6;
+		}
+	}
+	for (int f = 0; f <= maxFile; f++) {
+		for (int i = 0; i < sides; i++) {
+			PairsData& d  = table.get(DTZ, i, f);
+			d.blockLength = data;
+			data += d.blockLengthSize * 2;
+		}
+	}
+	for (int f = 0; f <= maxFile; f++) {
+		for (int i = 0; i < sides; i++) {
+			PairsData& d = table.get(DTZ, i, f);
+			data += (64 - (data - base) % 64) % 64;
+			d.data = data;
+			data += (size_t)d.numBlocks * d.blockSize;
+		}
+	}
+	return data <= end;
+}
+
+const uint8_t* Syzygy::setSizes(PairsData& d, const uint8_t* data) {
+	d.flags = *data++;
+	if (d.flags & TB_SINGLE_VALUE) {
+		d.minSymLen = *data++;
+		return data;
+	}
+
+	// the last group index is the number of positions in the table
+	int groups		   = std::find(d.groupLen.begin(), d.groupLen.end(), 0) - d.groupLen.begin();
+	uint64_t tableSize = d.groupIdx[groups];
+
+	d.blockSize		   = 1ULL << *data++;
+	d.span			   = 1ULL << *data++;
+	d.sparseIndexSize  = (tableSize + d.span - 1) / d.span;
+	int padding		   = *data++;
+	d.numBlocks		   = readLittleEndian<uint32_t>(data);
+	data += 4;
+	// padded so the sparse index never points past the end
+	d.blockLengthSize = d.numBlocks + padding;
+	d.maxSymLen		  = *data++;
+	d.minSymLen		  = *data++;
+	d.lowestSym		  = data;
+	if (d.maxSymLen < d.minSymLen || d.maxSymLen > 32) return nullptr;
+	d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+
+	// in a canonical huffman code longer codes have lower values, so lowestSym[i] >= lowestSym[i + 1]. from that base64[i], the
+	// lowest code of each length padded to 64 bits, satisfies base64[i] >= base64[i + 1], and any code c of length i padded the
+	// same way has base64[i - 1] > c >= base64[i]
+	for (int i = (int)d.base64.size() - 2; i >= 0; i--) {
+		d.base64[i] = (d.base64[i + 1] + readLittleEndian<uint16_t>(d.lowestSym + 2 * i) - readLittleEndian<uint16_t>(d.lowestSym + 2 * (i + 1))) / 2;
+	}
+	for (size_t i = 0; i < d.base64.size(); i++) d.base64[i] <<= 64 - i - d.minSymLen;
+
+	data += d.base64.size() * 2;
+	d.symlen.resize(readLittleEndian<uint16_t>(data));
+	data += 2;
+	d.btree = data;
+
+	std::vector<bool> visited(d.symlen.size());
+	for (size_t s = 0; s < d.symlen.size(); s++) {
+		if (!visited[s]) d.symlen[s] = setSymbolLength(d, s, visited);
+	}
+	return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+}
+
+uint8_t Syzygy::setSymbolLength(PairsData& d, int s, std::vector<bool>& visited) {
+	// the tree is acyclic, so s can be marked before its children are done
+	visited[s]		 = true;
+	const uint8_t* n = d.btree + 3 * s;
+	int right		 = (n[2] << 4) | (n[1] >> 4);
+	if (right == 0xFFF) return 0;
+	int left = ((n[1] & 0xF) << 8) | n[0];
+	if ((size_t)left >= d.symlen.size() || (size_t)right >= d.symlen.size()) return 0;
+
+	if (!visited[left]) d.symlen[left] = setSymbolLength(d, left, visited);
+	if (!visited[right]) d.symlen[right] = setSymbolLength(d, right, visited);
+	return d.symlen[left] + d.symlen[right] + 1;
+}
+
+int Syzygy::decompressPairs(const PairsData& d, uint64_t idx) {
+	if (d.flags & TB_SINGLE_VALUE) return d.minSymLen;
+
+	// sparse index entry k points at value k * span + span / 2, so the block of idx is found by walking from there
+	uint32_t k		  = idx / d.span;
+	const uint8_t* entry = d.sparseIndex + 6 * k;
+	uint32_t block	  = readLittleEndian<uint32_t>(entry);
+	int64_t offset	  = readLittleEndian<uint16_t>(entry + 4);
+	offset += (int64_t)(idx % d.span) - (int64_t)(d.span / 2);
+
+	while (offset < 0) offset += readLittleEndian<uint16_t>(d.blockLength + 2 * --block) + 1;
+	while (offset > readLittleEndian<uint16_t>(d.blockLength + 2 * block)) offset -= readLittleEndian<uint16_t>(d.blockLength + 2 * block++) + 1;
+
+	// the block is a stream of codes, read big endian. skip symbols until the one whose values cover offset
+	const uint8_t* ptr = d.data + (uint64_t)block * d.blockSize;
+	uint64_t buf64	   = readBigEndian<uint64_t>(ptr);
+	ptr += 8;
+	int buf64Size = 64;
+	int sym;
+	while (true) {
+		int len = 0;
+		while (buf64 < d.base64[len]) len++;
+		sym = (int)((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+		sym += readLittleEndian<uint16_t>(d.lowestSym + 2 * len);
+		if (offset < d.symlen[sym] + 1) break;
+
+		offset -= d.symlen[sym] + 1;
+		len += d.minSymLen;
+		buf64 <<= len;
+		buf64Size -= len;
+		if (buf64Size <= 32) {
+			buf64Size += 32;
+			buf64 |= (uint64_t)readBigEndian<uint32_t>(ptr) << (64 - buf64Size);
+			ptr += 4;
+		}
+	}
+
+	// pairs always expand into adjacent values, so walk down the tree to the value at offset
+	while (d.symlen[sym]) {
+		const uint8_t* n = d.btree + 3 * sym;
+		int left		 = ((n[1] & 0xF) << 8) | n[0];
+		if (offset < d.symlen[left] + 1) {
+			sym = left;
+		} else {
+			offset -= d.symlen[left] + 1;
+			sym = (n[2] << 4) | (n[1] >> 4);
+		}
+	}
+	const uint8_t* n = d.btree + 3 * sym;
+	return ((n[1] & 0xF) << 8) | n[0];
+}
+
+template <bool DTZ>
+int Syzygy::probeTable(Board& b, ProbeState& state, WDLScore wdl) {
+	const Board::BoardState& bs = b.boardState;
+	Bitboard occupied			= bs.allColorPieces[WHITE] | bs.allColorPieces[BLACK];
+	// KvK
+	if (std::popcount(occupied) == 2) return WDL_DRAW;
+
+	auto it = s_byKey.find(materialKey(b));
+	if (it == s_byKey.end() || !map<DTZ>(*it->second)) {
+		state = PROBE_FAIL;
+		return 0;
+	}
+	Table& table = *it->second;
+
+	// the tables are stored with the stronger side as white, and symmetric ones only with white to move. anything else is probed
+	// with the colors swapped and the board flipped
+	bool flip		= (bs.sideToMove == BLACK && table.key == table.key2) || materialKey(b) != table.key;
+	int flipColor	= flip ? 8 : 0;
+	int flipSquares = flip ? 56 : 0;
+	int stm			= flip ^ bs.sideToMove;
+
+	int squares[MAX_PIECES];
+	uint8_t pieces[MAX_PIECES];
+	int size = 0, leadPawnsCnt = 0, tbFile = 0;
+	Bitboard leadPawns = 0;
+	auto byMapPawns	   = [](int a, int c) { return s_mapPawns[a] < s_mapPawns[c]; };
+
+	// tables with pawns have a sub table per file of the leading pawn, the pawn closest to the edge and then lowest
+	if (table.hasPawns) {
+		Color leadColor = (Color)((table.get(DTZ, 0, 0).pieces[0] ^ flipColor) >> 3);
+		leadPawns		= bs.pieces[leadColor][PAWN];
+		for (Bitboard pawns = leadPawns; pawns; pawns &= pawns - 1) squares[size++] = bitscan(pawns) ^ flipSquares;
+		leadPawnsCnt = size;
+		std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, byMapPawns));
+		tbFile = std::min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+	}
+
+	// dtz tables only store one side to move
+	if (DTZ) {
+		const PairsData& d = table.get(true, 0, tbFile);
+		if ((d.flags & TB_STM) != stm && !(table.key == table.key2 && !table.hasPawns)) {
+			state = PROBE_CHANGE_STM;
+			return 0;
+		}
+	}
+
+	for (Bitboard rest = occupied ^ leadPawns; rest; rest &= rest - 1) {
+		int sq = bitscan(rest);
+		Color color = (bs.allColorPieces[WHITE] >> sq) & 1 ? WHITE : BLACK;
+		Piece piece = NONE_PIECE;
+		for (int p = KING; p < NONE_PIECE; p++) {
+			if ((bs.pieces[color][p] >> sq) & 1) piece = (Piece)p;
+		}
+		squares[size]  = sq ^ flipSquares;
+		pieces[size++] = fileCode(color, piece) ^ flipColor;
+	}
+
+	// put the pieces in the order of the table
+	PairsData& d = table.get(DTZ, stm, tbFile);
+	for (int i = leadPawnsCnt; i < size - 1; i++) {
+		for (int j = i + 1; j < size; j++) {
+			if (d.pieces[i] == pieces[j]) {
+				std::swap(pieces[i], pieces[j]);
+				std::swap(squares[i], squares[j]);
+				break;
+			}
+		}
+	}
+
+	// mirror so the leading piece is on files a to d
+	if (fileOf(squares[0]) > 3) {
+		for (int i = 0; i < size; i++) squares[i] ^= 7;
+	}
+
+	uint64_t idx;
+	if (table.hasPawns) {
+		idx = s_leadPawnIdx[leadPawnsCnt][squares[0]];
+		std::stable_sort(squares + 1, squares + leadPawnsCnt, byMapPawns);
+		for (int i = 1; i < leadPawnsCnt; i++) idx += s_binomial[i][s_mapPawns[squares[i]]];
+	} else {
+		// without pawns the board can also be flipped vertically and along the diagonal, which puts the leading piece in the
+		// a1-d1-d4 triangle and the first leading piece off the diagonal below it
+		if (rankOf(squares[0]) > 3) {
+			for (int i = 0; i < size; i++) squares[i] ^= 56;
+		}
+		for (int i = 0; i < d.groupLen[0]; i++) {
+			if (!offDiagonal(squares[i])) continue;
+			if (offDiagonal(squares[i]) > 0) {
+				for (int j = i; j < size; j++) squares[j] = flipDiagonal(squares[j]);
+			}
+			break;
+		}
+
+		if (table.hasUniquePieces) {
+			// three pieces encoded together, 31332 placements
+			int adjust1 = squares[1] > squares[0];
+			int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+			if (offDiagonal(squares[0])) {
+				idx = ((uint64_t)s_mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+			} else if (offDiagonal(squares[1])) {
+				idx = (6 * 63 + rankOf(squares[0]) * 28 + s_mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+			} else if (offDiagonal(squares[2])) {
+				idx = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28 + (rankOf(squares[1]) - adjust1) * 28 + s_mapB1H1H7[squares[2]];
+			} else {
+				idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6 + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+			}
+		} else {
+			// only the two kings, 462 placements
+			idx = s_mapKK[s_mapA1D1D4[squares[0]]][squares[1]];
+		}
+	}
+
+	// the other groups, each as a combination of squares that skips the squares of the groups before it
+	idx *= d.groupIdx[0];
+	int* groupSq		= squares + d.groupLen[0];
+	bool remainingPawns = table.hasPawns && table.pawnCount[1];
+	for (int next = 1; d.groupLen[next]; next++) {
+		std::stable_sort(groupSq, groupSq + d.groupLen[next]);
+		uint64_t n = 0;
+		for (int i = 0; i < d.groupLen[next]; i++) {
+			int adjust = std::count_if(squares, groupSq, [&](int sq) { return groupSq[i] > sq; });
+			n += s_binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+		}
+		remainingPawns = false;
+		idx += n * d.groupIdx[next];
+		groupSq += d.groupLen[next];
+	}
+
+	int value = decompressPairs(d, idx);
+	if (!DTZ) return value - 2;
+
+	// dtz values are stored per result as indices into a map sorted by frequency, in moves unless the flags say plies
+	const PairsData& d0 = table.get(true, 0, tbFile);
+	constexpr int WDL_MAP[] = {1, 3, 0, 2, 0};
+	if (d0.flags & TB_MAPPED) {
+		const uint8_t* dtzMap = table.files[1].dtzMap;
+		int mapIdx			  = d0.mapIdx[WDL_MAP[wdl + 2]] + value;
+		value				  = d0.flags & TB_WIDE ? readLittleEndian<uint16_t>(dtzMap + 2 * mapIdx) : dtzMap[mapIdx];
+	}
+	if ((wdl == WDL_WIN && !(d0.flags & TB_WIN_PLIES)) || (wdl == WDL_LOSS && !(d0.flags & TB_LOSS_PLIES)) || wdl == WDL_CURSED_WIN ||
+		wdl == WDL_BLESSED_LOSS) {
+		value *= 2;
+	}
+	return value + 1;
+}
+
+template <bool CHECK_ZEROING_MOVES>
+Syzygy::WDLScore Syzygy::search(Board& b, ProbeState& state) {
+	WDLScore value, bestValue = WDL_LOSS;
+	Moves moves		 = b.moveGenerator.genLegalMoves();
+	size_t moveCount = 0;
+	for (const Move& m : moves) {
+		if (!(m.getFlags() & CAPTURE) && (!CHECK_ZEROING_MOVES || m.getPieceType() != PAWN)) continue;
+		moveCount++;
+
+		b.execute(m);
+		value = (WDLScore)-search<false>(b, state);
+		b.undoMove();
+		if (state == PROBE_FAIL) return WDL_DRAW;
+
+		if (value > bestValue) {
+			bestValue = value;
+			if (value >= WDL_WIN) {
+				state = PROBE_ZEROING_BEST_MOVE;
+				return value;
+			}
+		}
+	}
+
+	// with every move searched the stored value isnt needed, and could be wrong: the tables dont know about en passant
+	bool noMoreMoves = moveCount && moveCount == moves.size();
+	if (noMoreMoves) {
+		value = bestValue;
+	} else {
+		value = (WDLScore)probeTable<false>(b, state);
+		if (state == PROBE_FAIL) return WDL_DRAW;
+	}
+
+	// the stored value is "dont care" when a capture already reaches it
+	if (bestValue >= value) {
+		state = bestValue > WDL_DRAW || noMoreMoves ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+		return bestValue;
+	}
+	state = PROBE_OK;
+	return value;
+}
+
+Syzygy::WDLScore Syzygy::probeWDL(Board& b, ProbeState& state) {
+	state = PROBE_OK;
+	return search<false>(b, state);
+}
+
+int Syzygy::dtzBeforeZeroing(WDLScore wdl) {
+	switch (wdl) {
+		case WDL_WIN: return 1;
+		case WDL_CURSED_WIN: return 101;
+		case WDL_BLESSED_LOSS: return -101;
+		case WDL_LOSS: return -1;
+		default: return 0;
+	}
+}
+
+int Syzygy::probeDTZ(Board& b, ProbeState& state) {
+	state		 = PROBE_OK;
+	WDLScore wdl = search<true>(b, state);
+	// draws have no dtz
+	if (state == PROBE_FAIL || wdl == WDL_DRAW) return 0;
+	if (state == PROBE_ZEROING_BEST_MOVE) return dtzBeforeZeroing(wdl);
+
+	int sign = wdl > 0 ? 1 : -1;
+	int dtz	 = probeTable<true>(b, state, wdl);
+	if (state == PROBE_FAIL) return 0;
+	if (state != PROBE_CHANGE_STM) return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * sign;
+
+	// the table has the other side to move, so take the best move for the result by a 1 ply search
+	int minDTZ = 0xFFFF;
+	for (const Move& m : b.moveGenerator.genLegalMoves()) {
+		bool zeroing = (m.getFlags() & CAPTURE) || m.getPieceType() == PAWN;
+		b.execute(m);
+		// a zeroing move is counted from before it, so only the sign of the position after it matters
+		dtz = zeroing ? -dtzBeforeZeroing(search<false>(b, state)) : -probeDTZ(b, state);
+		if (dtz == 1 && b.moveGenerator.inCheck() && !b.moveGenerator.hasLegalMoves()) minDTZ = 1;
+		if (!zeroing) dtz += dtz > 0 ? 1 : dtz < 0 ? -1 : 0;
+		if (dtz < minDTZ && (dtz > 0) == (sign > 0) && dtz) minDTZ = dtz;
+		b.undoMove();
+		if (state == PROBE_FAIL) return 0;
+	}
+	// no legal moves, mated
+	return minDTZ == 0xFFFF ? -1 : minDTZ;
+}
+
+bool Syzygy::rootMoves(Board& b, Moves& moves) {
+	moves.clear();
+	int cnt50 = b.boardState.hmClock;
+	bool rep  = b.isRepetition();
+
+	Moves legalMoves = b.moveGenerator.genLegalMoves();
+	std::vector<int> ranks;
+	for (const Move& m : legalMoves) {
+		ProbeState state = PROBE_OK;
+		int dtz;
+		b.execute(m);
+		if (b.boardState.hmClock == 0) {
+			dtz = dtzBeforeZeroing((WDLScore)-probeWDL(b, state));
+		} else if (b.is50MoveRule() || b.isThreefoldRepetition()) {
+			dtz = 0;
+		} else {
+			// dtz of the position after the move, one ply further from the root
+			dtz = -probeDTZ(b, state);
+			dtz += dtz > 0 ? 1 : dtz < 0 ? -1 : 0;
+		}
+		if (dtz == 2 && b.moveGenerator.inCheck() && !b.moveGenerator.hasLegalMoves()) dtz = 1;
+		b.undoMove();
+		if (state == PROBE_FAIL) return false;
+
+		// every win that reaches its zeroing move inside the 50 move budget ranks the same, so the search is free to pick among
+		// them. past the budget the faster one is better. losses the same way round
+		int rank = dtz > 0 ? (dtz + cnt50 <= 99 && !rep ? MAX_DTZ : MAX_DTZ - (dtz + cnt50))
+				 : dtz < 0 ? (-dtz * 2 + cnt50 < 100 ? -MAX_DTZ : -MAX_DTZ + (-dtz + cnt50))
+						   : 0;
+		ranks.push_back(rank);
+	}
+	if (legalMoves.empty()) return false;
+
+	int best = *std::max_element(ranks.begin(), ranks.end());
+	for (size_t i = 0; i < legalMoves.size(); i++) {
+		if (ranks[i] == best) moves.push_back(legalMoves[i]);
+	}
+	return true;
+}
+
+template int Syzygy::probeTable<false>(Board&, ProbeState&, WDLScore);
+template int Syzygy::probeTable<true>(Board&, ProbeState&, WDLScore);
@@ -0,0 +1,187 @@
+#ifndef SYZYGY_H
+#define SYZYGY_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "board.hpp"
+#include "consts.hpp"
+
+/**
+* @brief probing of syzygy endgame tablebases. init scans the given directories for .rtbw (win/draw/loss) and .rtbz (distance to
+* zeroing move) files and registers one table per material signature, e.g. KRvK. a file is only memory mapped the first time a
+* position with its material is probed, so a large set costs nothing until the search gets down to it. every function is safe to
+* call from several searches at once, except init and clear, which must not run during a search.
+*
+* the tables only hold positions without castling rights, and their results assume the 50 move rule: a cursed win is a win that
+* comes too late and is a draw under the rule, a blessed loss is the same from the other side.
+*/
+class Syzygy {
+public:
+	/**
+	* @brief the largest tables published have 7 pieces
+	*/
+	static constexpr int MAX_PIECES = 7;
+
+	/**
+	* @brief result of a position for the side to move
+	*/
+	enum WDLScore {
+		WDL_LOSS		 = -2,
+		WDL_BLESSED_LOSS = -1,
+		WDL_DRAW		 = 0,
+		WDL_CURSED_WIN	 = 1,
+		WDL_WIN			 = 2,
+	};
+
+	enum ProbeState {
+		/**
+		* @brief the position has no table, or its file could not be read
+		*/
+		PROBE_FAIL,
+		PROBE_OK,
+
+		/**
+		* @brief the dtz table only stores the other side to move, so the answer needs a 1 ply search
+		*/
+		PROBE_CHANGE_STM,
+
+		/**
+		* @brief the best move is a capture or pawn move, so the dtz stored for the position cant be trusted
+		*/
+		PROBE_ZEROING_BEST_MOVE,
+	};
+
+	/**
+	* @brief replaces the current tables with the ones found in paths, a list of directories separated by ':'. an empty path,
+	* or "<empty>", drops every table. returns the number of wdl tables found
+	*/
+	static int init(const std::string& paths);
+
+	/**
+	* @brief checks the KQvK, KRvK and KPvK tables among the ones found against results known without them, with both colors as the
+	* strong side. KQvK and KRvK are won with the strong side to move, and lost with the weak side to move unless it is stalemated or
+	* can take the piece. KPvK follows the KPK bitbase of Endgame. dtz has to agree with wdl in sign and be 1 when a mate in one is
+	* on the board. returns why the set cant be trusted, the first disagreement or none of the three tables found, "" if it can
+	*/
+	static std::string verify();
+
+	/**
+	* @brief true if the tables passed verify when init found them. the search only probes a set that did, so a decoding bug
+	* cant quietly turn into wrong scores in play
+	*/
+	static bool verified();
+
+	/**
+	* @brief what verify found wrong with the current tables, "" if nothing
+	*/
+	static const std::string& verifyFailure();
+
+	/**
+	* @brief unmaps every file and forgets all tables
+	*/
+	static void clear();
+
+	/**
+	* @brief piece count of the largest table found, 0 without tables
+	*/
+	static int largest();
+
+	/**
+	* @brief returns true if b could have a table: few enough pieces and no castling rights
+	*/
+	static bool canProbe(const Board& b);
+
+	/**
+	* @brief win/draw/loss of the position on b for the side to move. captures are searched on the way, since the tables only store
+	* the result of a position with a winning capture as "dont care". b is restored before returning
+	*/
+	static WDLScore probeWDL(Board& b, ProbeState& state);
+
+	/**
+	* @brief distance in plies to the next capture or pawn move that keeps the result, positive if the side to move wins, negative
+	* if it loses, 0 for a draw. cursed wins and blessed losses are offset by 100
+	*/
+	static int probeDTZ(Board& b, ProbeState& state);
+
+	/**
+	* @brief ranks every legal move of b with the dtz tables and fills moves with the ones that keep the best result in reach,
+	* taking the 50 move counter of b into account. returns false, leaving moves empty, if any move couldnt be probed
+	*/
+	static bool rootMoves(Board& b, Moves& moves);
+
+	/**
+	* @brief material key of b, the key its table is found by, optionally with the colors swapped
+	*/
+	static MaterialKey materialKey(const Board& b, bool swapColors = false);
+
+private:
+	struct PairsData;
+	struct Table;
+	struct MappedFile;
+
+	template <bool DTZ>
+	static int probeTable(Board& b, ProbeState& state, WDLScore wdl = WDL_DRAW);
+
+	/**
+	* @brief maps the file of a table on its first probe, returns false if it doesnt exist or doesnt look like a table
+	*/
+	template <bool DTZ>
+	static bool map(Table& table);
+
+	/**
+	* @brief parses the header of a freshly mapped table and points its PairsData into the file
+	*/
+	template <bool DTZ>
+	static bool setup(Table& table, const uint8_t* data, const uint8_t* end);
+
+	/**
+	* @brief reads the huffman code and pair tree of one sub table, returns the first byte after them
+	*/
+	static const uint8_t* setSizes(PairsData& d, const uint8_t* data);
+
+	/**
+	* @brief number of values the pair symbol s expands to, minus one, computed recursively from the pair tree
+	*/
+	static uint8_t setSymbolLength(PairsData& d, int s, std::vector<bool>& visited);
+
+	/**
+	* @brief value number idx of a sub table, found through the sparse index and the block lengths and then decoded
+	*/
+	static int decompressPairs(const PairsData& d, uint64_t idx);
+
+	/**
+	* @brief best result reachable through captures (and pawn moves for dtz), combined with the probe of the position itself
+	*/
+	template <bool CHECK_ZEROING_MOVES>
+	static WDLScore search(Board& b, ProbeState& state);
+
+	/**
+	* @brief dtz of a position whose best move zeroes the 50 move counter, 1 ply before the move
+	*/
+	static int dtzBeforeZeroing(WDLScore wdl);
+
+	/**
+	* @brief squares encoding tables shared by every table, built once
+	*/
+	static void initIndexTables();
+
+	static std::vector<std::unique_ptr<Table>> s_tables;
+
+	/**
+	* @brief every table under both of its material keys, the stronger side as white and as black
+	*/
+	static std::unordered_map<MaterialKey, Table*> s_byKey;
+	static int s_largest;
+	static std::string s_verifyFailure;
+
+	/**
+	* @brief held while a file is being mapped, so two searches probing the same table for the first time dont both map it
+	*/
+	static std::mutex s_mapMutex;
+};
+#endif
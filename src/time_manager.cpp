@@ -0,0 +1,63 @@
+#include "time_manager.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+void TimeManager::start(const TimeControl& tc) {
+	m_lastBestMove		= Move();
+	m_lastScore			= NONE_SCORE;
+	m_bestMoveStability = 0;
+	m_fixedMoveTime		= tc.moveTimeMs >= 0;
+
+	if (m_fixedMoveTime) {
+		m_hardLimitMs	  = std::max(1, tc.moveTimeMs - MOVE_OVERHEAD_MS);
+		m_baseSoftLimitMs = m_hardLimitMs;
+		m_softLimitMs	  = m_hardLimitMs;
+		return;
+	}
+	if (tc.remainingMs < 0) {
+		m_hardLimitMs	  = -1;
+		m_baseSoftLimitMs = -1;
+		m_softLimitMs	  = -1;
+		return;
+	}
+
+	int available = std::max(1, tc.remainingMs - MOVE_OVERHEAD_MS);
+	int movesToGo = tc.movesToGo > 0 ? std::min(tc.movesToGo, DEFAULT_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+
+	// never plan to use more than the clock can spare, even if the increment is larger than the remaining time
+	int optimum		  = available / movesToGo + tc.incrementMs * 3 / 4;
+	m_hardLimitMs	  = std::max(1, std::min(optimum * HARD_LIMIT_SCALE, available * 3 / 4));
+	m_baseSoftLimitMs = std::max(1, std::min(optimum, m_hardLimitMs));
+	m_softLimitMs	  = m_baseSoftLimitMs;
+}
+
+void TimeManager::onIterationComplete(const Move& bestMove, Centipawns score) {
+	// a fixed move time is always used up, and without a clock there is nothing to scale
+	if (m_fixedMoveTime || m_baseSoftLimitMs < 0) return;
+
+	m_bestMoveStability = bestMove == m_lastBestMove ? m_bestMoveStability + 1 : 0;
+	m_lastBestMove		= bestMove;
+
+	// mate scores swing by thousands between iterations, so they dont count as a drop
+	bool comparable = m_lastScore != NONE_SCORE && !isMateScore(score) && !isMateScore(m_lastScore);
+	int scoreDrop	= comparable ? std::max(0, m_lastScore - score) : 0;
+	m_lastScore		= score;
+
+	int stabilityPercent = STABILITY_SCALE_PERCENT[std::min<int>(m_bestMoveStability, std::size(STABILITY_SCALE_PERCENT) - 1)];
+	int scoreDropPercent = std::min(MAX_SCORE_DROP_PERCENT, scoreDrop * SCORE_DROP_SCALE / 10);
+	int64_t scaled		 = (int64_t)m_baseSoftLimitMs * stabilityPercent / 100 * (100 + scoreDropPercent) / 100;
+	m_softLimitMs		 = (int)std::min<int64_t>(scaled, m_hardLimitMs);
+}
+
+bool TimeManager::shouldStartIteration(int64_t elapsedMs) const {
+	return m_softLimitMs < 0 || elapsedMs < m_softLimitMs;
+}
+
+int TimeManager::softLimitMs() const {
+	return m_softLimitMs;
+}
+
+int TimeManager::hardLimitMs() const {
+	return m_hardLimitMs;
+}
@@ -0,0 +1,127 @@
+#ifndef TIME_MANAGER_H
+#define TIME_MANAGER_H
+
+#include <cstdint>
+
+#include "consts.hpp"
+#include "move.hpp"
+
+/**
+* @brief the clock situation for the side to move, as given by a gui or a tournament manager
+*/
+struct TimeControl {
+	/**
+	* @brief time left on the clock in milliseconds, negative if there is no clock
+	*/
+	int remainingMs = -1;
+
+	/**
+	* @brief time added to the clock after each move in milliseconds
+	*/
+	int incrementMs = 0;
+
+	/**
+	* @brief moves left until the next time control, 0 if the rest of the game has to be played on remainingMs
+	*/
+	int movesToGo = 0;
+
+	/**
+	* @brief exact time to spend on this move in milliseconds, overrides the clock when not negative
+	*/
+	int moveTimeMs = -1;
+};
+
+/**
+* @brief decides how long a single search may run. the soft limit is checked between iterations: once it has passed
+* no new iteration is started. the hard limit aborts the search mid iteration. the soft limit grows while the best
+* move keeps changing or the score is dropping, and shrinks once the best move has been stable for a few iterations.
+*/
+class TimeManager {
+public:
+	/**
+	* @brief time kept in reserve for communication and move overhead
+	*/
+	static constexpr int MOVE_OVERHEAD_MS = 30;
+
+	/**
+	* @brief number of moves the remaining time is split over when movesToGo isnt given
+	*/
+	static constexpr int DEFAULT_MOVES_TO_GO = 30;
+
+	/**
+	* @brief the hard limit is at most this many times the soft limit
+	*/
+	static constexpr int HARD_LIMIT_SCALE = 4;
+
+	/**
+	* @brief computes the limits for a new search and forgets the previous search's iterations
+	*/
+	void start(const TimeControl& tc);
+
+	/**
+	* @brief records the result of a completed iteration and rescales the soft limit
+	* @param bestMove The best root move of the iteration.
+	* @param score The score of the iteration.
+	*/
+	void onIterationComplete(const Move& bestMove, Centipawns score);
+
+	/**
+	* @brief returns true if another iteration is worth starting after elapsedMs
+	*/
+	bool shouldStartIteration(int64_t elapsedMs) const;
+
+	/**
+	* @brief soft limit after scaling, in milliseconds. negative if there is no limit
+	*/
+	int softLimitMs() const;
+
+	/**
+	* @brief the search is aborted after this many milliseconds. negative if there is no limit
+	*/
+	int hardLimitMs() const;
+
+private:
+	/**
+	* @brief soft limit before stability scaling
+	*/
+	int m_baseSoftLimitMs = -1;
+
+	/**
+	* @brief soft limit after stability scaling
+	*/
+	int m_softLimitMs = -1;
+
+	int m_hardLimitMs = -1;
+
+	/**
+	* @brief true if the search was given an exact move time, which is never scaled
+	*/
+	bool m_fixedMoveTime = false;
+
+	/**
+	* @brief best move of the last completed iteration
+	*/
+	Move m_lastBestMove;
+
+	/**
+	* @brief score of the last completed iteration, used to detect score drops
+	*/
+	Centipawns m_lastScore = NONE_SCORE;
+
+	/**
+	* @brief number of consecutive iterations the best move has stayed the same
+	*/
+	int m_bestMoveStability = 0;
+
+	/**
+	* @brief soft limit multiplier in percent indexed by best move stability
+	*/
+	static constexpr int STABILITY_SCALE_PERCENT[] = {140, 120, 100, 85, 75};
+
+	/**
+	* @brief every centipawn the score fell since the last iteration adds this many tenths of a percent to the soft limit, up to MAX_SCORE_DROP_PERCENT
+	*/
+	static constexpr int SCORE_DROP_SCALE		  = 5;
+	static constexpr int MAX_SCORE_DROP_PERCENT = 50;
+};
+#endif
@@ -1,9 +1,27 @@
 #include "transposition_table.hpp"
+
+#include <algorithm>
 #include <iostream>
 
-std::array<TTEntry, TT_SIZE_MB / sizeof(TTEntry)> TranspositionTable::m_table{};
-int TranspositionTable::m_used = 0;
-int TranspositionTable::m_size = TT_SIZE_MB / sizeof(TTEntry);
+// never smaller than the 1000 entries hashfull samples
+TranspositionTable::TranspositionTable(size_t sizeBytes) : m_table(std::max<size_t>(sizeBytes / sizeof(TTEntry), 1000)), m_size(m_table.size()) {}
+
+TranspositionTable& TranspositionTable::shared() {
+	static TranspositionTable table;
+	return table;
+}
+
+void TranspositionTable::resize(size_t sizeBytes) {
+	// a fresh vector rather than resize, so the old allocation is given back before the new one is made
+	m_table = std::vector<TTEntry>();
+	m_table = std::vector<TTEntry>(std::max<size_t>(sizeBytes / sizeof(TTEntry), 1000));
+	m_size	= m_table.size();
+	m_used	= 0;
+}
+
+size_t TranspositionTable::sizeBytes() const {
+	return m_table.size() * sizeof(TTEntry);
+}
 
 void TranspositionTable::add(ZobristHash h, Centipawns s, int d, TTFlag f, Move m) {
 	size_t index = h % m_size;
@@ -22,7 +40,7 @@ Move TranspositionTable::getMove(MoveSkeleton m) {
 	return Move(m.from, m.to, m.piece, m.promoPiece, m.flags);
 }
 
-const TTEntry& TranspositionTable::getEntry(ZobristHash h) {
+const TTEntry& TranspositionTable::getEntry(ZobristHash h) const {
 	size_t index = h % m_size;
 	return m_table[index];
 }
@@ -37,6 +55,16 @@ void TranspositionTable::printCapacity() {
 	std::cout << "Transposition Table Capacity: " << m_used << " / " << m_size << " = " << m_used / (float)m_size * 100.0f << " %\n";
 }
 
+int TranspositionTable::hashfull() const {
+	int used = 0;
+	for (size_t i = 0; i < 1000; i++) {
+		if (m_table[i].partial_hash != 0) {
+			used++;
+		}
+	}
+	return used;
+}
+
 void TranspositionTable::reset() {
 	m_used = 0;
 	for (auto& entry : m_table) {
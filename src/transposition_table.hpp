@@ -1,6 +1,8 @@
 #ifndef TRANSPOSITION_TABLE_H
 #define TRANSPOSITION_TABLE_H
 
+#include <vector>
+
 #include "consts.hpp"
 #include "move.hpp"
 
@@ -97,24 +99,48 @@ struct TTEntry {
 	}
 };
 
+/**
+* @brief hash table of search results. a table is not thread safe, so searches that run at the same time need tables of their own,
+* which is why SearchContext points at the table it uses. the GUI, the uci engine and bench share the one from shared()
+*/
 class TranspositionTable {
 private:
 	/**
 	* @brief transposition table storage array
 	*/
-	static std::array<TTEntry, TT_SIZE_MB / sizeof(TTEntry)> m_table;
+	std::vector<TTEntry> m_table;
 
 	/**
 	* @brief Number of entries currently used in the transposition table.
 	*/
-	static int m_used;
+	int m_used = 0;
 
 	/**
 	* @brief Total size of the transposition table in terms of number of entries.
 	*/
-	static int m_size;
+	int m_size;
 
 public:
+	/**
+	* @brief allocates an empty table of sizeBytes
+	*/
+	explicit TranspositionTable(size_t sizeBytes = TT_SIZE_MB);
+
+	/**
+	* @brief the table searches use unless their context is given another one
+	*/
+	static TranspositionTable& shared();
+
+	/**
+	* @brief reallocates the table with sizeBytes, dropping every entry. no search may be using the table meanwhile
+	*/
+	void resize(size_t sizeBytes);
+
+	/**
+	* @brief size of the table in bytes
+	*/
+	size_t sizeBytes() const;
+
 	/**
 	* @brief adds an entry to the transposition table
 	* @param ZobristHash -- hash of the position
@@ -123,14 +149,14 @@ public:
 	* @param TTFlag -- node type flag
 	* @param Move -- best move found
 	*/
-	static void add(ZobristHash h, Centipawns s, int d, TTFlag f, Move m);
+	void add(ZobristHash h, Centipawns s, int d, TTFlag f, Move m);
 
 	/**
 	* @brief retrieves the best move for a given hash from the transposition table
 	* @param ZobristHash -- hash of the position to look up
 	* @return Move -- best move found, or null move if not found
 	*/
-	static const TTEntry& getEntry(ZobristHash h);
+	const TTEntry& getEntry(ZobristHash h) const;
 
 	/**
 	* @brief retrieves the best move for a given move skeleton from the transposition table
@@ -144,13 +170,19 @@ public:
 	* This function calculates and displays the number of entries used in the transposition table
 	* as a percentage of the total available entries.
 	*/
-	static void printCapacity();
+	void printCapacity();
+
+	/**
+	* @brief Estimates how full the table is in permille by sampling its first 1000 entries, the way UCI reports hashfull.
+	* @return int -- used entries per thousand
+	*/
+	int hashfull() const;
 
 	/**
 	* @brief Resets the transposition table by clearing all entries.
 	* This function sets the number of used entries to zero, effectively
 	* clearing the transposition table.
 	*/
-	static void reset();
+	void reset();
 };
 #endif
@@ -0,0 +1,391 @@
+#include "tuner.hpp"
+#include "datagen.hpp"
+#include "endgame.hpp"
+#include "eval_params.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+const std::vector<Tuner::ParamGroup> Tuner::s_groups = [] {
+	std::vector<ParamGroup> groups = {
+		{"mgPieceValues", "egPieceValues", 0, NONE_PIECE, 0, 0},
+		{"mgPsqt", "egPsqt", 0, NONE_PIECE * 64, NONE_PIECE, 8},
+		{"mgQueenMobility", "egQueenMobility", 0, (int)EvalParams::mgQueenMobility.size(), 0, 0},
+		{"mgRookMobility", "egRookMobility", 0, (int)EvalParams::mgRookMobility.size(), 0, 0},
+		{"mgBishopMobility", "egBishopMobility", 0, (int)EvalParams::mgBishopMobility.size(), 0, 0},
+		{"mgKnightMobility", "egKnightMobility", 0, (int)EvalParams::mgKnightMobility.size(), 0, 0},
+		{"kingSafetyTable", nullptr, 0, (int)EvalParams::kingSafetyTable.size(), 0, 20},
+		{"pawnShield", nullptr, 0, (int)EvalParams::pawnShield.size(), 0, 0},
+		{"pawnStorm", nullptr, 0, (int)EvalParams::pawnStorm.size(), 0, 0},
+	};
+	int offset = 0;
+	for (ParamGroup& group : groups) {
+		group.offset = offset;
+		offset += group.size;
+	}
+	return groups;
+}();
+
+const int Tuner::s_numParams = s_groups.back().offset + s_groups.back().size;
+
+/**
+* @brief chance of a white win predicted from a white POV score, the usual logistic curve on a 400 centipawn scale
+*/
+static double sigmoid(double k, double score) {
+	return 1.0 / (1.0 + std::exp(-k * score * std::log(10.0) / 400.0));
+}
+
+Tuner::Tuner(int threads) : m_threads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {
+	// short to double, one at a time. a range insert of the converted arrays trips -Wstringop-overflow in gcc
+	auto append = [](std::vector<double>& params, const auto& values) {
+		for (auto value : values) params.push_back(value);
+	};
+	m_mg.reserve(s_numParams);
+	m_eg.reserve(s_numParams);
+	append(m_mg, EvalParams::mgPieceValues);
+	for (const auto& table : EvalParams::mgPsqt) append(m_mg, table);
+	append(m_mg, EvalParams::mgQueenMobility);
+	append(m_mg, EvalParams::mgRookMobility);
+	append(m_mg, EvalParams::mgBishopMobility);
+	append(m_mg, EvalParams::mgKnightMobility);
+	append(m_mg, EvalParams::kingSafetyTable);
+	append(m_mg, EvalParams::pawnShield);
+	append(m_mg, EvalParams::pawnStorm);
+
+	append(m_eg, EvalParams::egPieceValues);
+	for (const auto& table : EvalParams::egPsqt) append(m_eg, table);
+	append(m_eg, EvalParams::egQueenMobility);
+	append(m_eg, EvalParams::egRookMobility);
+	append(m_eg, EvalParams::egBishopMobility);
+	append(m_eg, EvalParams::egKnightMobility);
+	m_eg.resize(s_numParams, 0.0);
+
+	m_hasEg.resize(s_numParams);
+	for (const ParamGroup& group : s_groups) {
+		std::fill_n(m_hasEg.begin() + group.offset, group.size, group.egName != nullptr);
+	}
+}
+
+std::vector<int> Tuner::flatten(const EvalTrace& trace) {
+	std::vector<int> flat;
+	flat.reserve(s_numParams);
+	auto append = [&](const auto& values) { flat.insert(flat.end(), values.begin(), values.end()); };
+	append(trace.pieceValues);
+	for (const auto& table : trace.psqt) append(table);
+	append(trace.queenMobility);
+	append(trace.rookMobility);
+	append(trace.bishopMobility);
+	append(trace.knightMobility);
+	append(trace.kingSafety);
+	append(trace.pawnShield);
+	append(trace.pawnStorm);
+	return flat;
+}
+
+bool Tuner::parseLine(const std::string& line, Board& b, std::vector<TunerPosition>& positions, std::vector<TunerTerm>& terms) {
+	// only the first four fields of the fen are used, so lines with or without move counters both work
+	std::istringstream in(line);
+	std::string placement, side, castling, enPassant;
+	if (!(in >> placement >> side >> castling >> enPassant)) return false;
+	if (enPassant.size() > 1 && enPassant.back() == ';') enPassant.pop_back();
+	if (!Board::validPlacement(placement) || (side != "w" && side != "b")) return false;
+	if (castling.find_first_not_of("KQkq-") != std::string::npos) return false;
+	if (enPassant != "-" && (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || (enPassant[1] != '3' && enPassant[1] != '6'))) return false;
+
+	std::string rest = line.substr(std::min<size_t>(line.size(), in.tellg()));
+	int result;
+	if (rest.find("1/2-1/2") != std::string::npos) {
+		result = 1;
+	} else if (rest.find("1-0") != std::string::npos) {
+		result = 2;
+	} else if (rest.find("0-1") != std::string::npos) {
+		result = 0;
+	} else if (size_t bracket = rest.find('['); bracket != std::string::npos) {
+		double value = std::strtod(rest.c_str() + bracket + 1, nullptr);
+		if (value != 0.0 && value != 0.5 && value != 1.0) return false;
+		result = (int)(value * 2);
+	} else {
+		return false;
+	}
+
+	b.setToFen((placement + " " + side + " " + castling + " " + enPassant + " 0 1").c_str());
+	if (!b.moveGenerator.hasLegalMoves() || b.moveGenerator.inCheck()) return false;
+	// endgames with their own evaluation never reach the weights
+	const Endgame::Entry* endgame = Endgame::probe(b);
+	if (endgame && endgame->evaluate) return false;
+
+	EvalTrace trace;
+	Eval::trace(b, trace);
+	std::vector<int> flat = flatten(trace);
+
+	TunerPosition position{(uint32_t)terms.size(), 0, (uint8_t)std::min(b.boardState.phase, EvalParams::MAX_PHASE), (uint8_t)result};
+	for (int i = 0; i < s_numParams; i++) {
+		if (flat[i]) {
+			terms.push_back({(uint16_t)i, (int16_t)flat[i]});
+			position.numTerms++;
+		}
+	}
+	positions.push_back(position);
+	return true;
+}
+
+bool Tuner::addPosition(const std::string& line) {
+	Board b;
+	std::vector<TunerPosition> positions;
+	std::vector<TunerTerm> terms;
+	if (!parseLine(line, b, positions, terms)) return false;
+	positions[0].firstTerm = m_terms.size();
+	m_positions.push_back(positions[0]);
+	m_terms.insert(m_terms.end(), terms.begin(), terms.end());
+	return true;
+}
+
+size_t Tuner::load(const std::string& path) {
+	// datagen output is read as records, anything else as lines of text
+	bool records = path.size() >= 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+	std::ifstream file(path, records ? std::ios::binary : std::ios::in);
+	if (!file) return 0;
+
+	size_t before = size();
+	std::vector<std::string> lines;
+	std::vector<std::vector<TunerPosition>> positions(m_threads);
+	std::vector<std::vector<TunerTerm>> terms(m_threads);
+	while (true) {
+		lines.clear();
+		std::string line;
+		DatagenRecord record;
+		while (lines.size() < LOAD_BATCH_SIZE) {
+			if (records) {
+				if (!file.read(reinterpret_cast<char*>(&record), sizeof(record))) break;
+				lines.push_back(record.fen() + (record.result == 2 ? " [1.0]" : record.result == 1 ? " [0.5]" : " [0.0]"));
+			} else {
+				if (!std::getline(file, line)) break;
+				lines.push_back(std::move(line));
+			}
+		}
+		if (lines.empty()) break;
+
+		parallelFor(lines.size(), [&](size_t begin, size_t end, int thread) {
+			Board b;
+			positions[thread].clear();
+			terms[thread].clear();
+			for (size_t i = begin; i < end; i++) parseLine(lines[i], b, positions[thread], terms[thread]);
+		});
+
+		// appended in thread order, so the positions stay in the order of the file
+		for (int thread = 0; thread < m_threads; thread++) {
+			uint32_t base = m_terms.size();
+			for (TunerPosition position : positions[thread]) {
+				position.firstTerm += base;
+				m_positions.push_back(position);
+			}
+			m_terms.insert(m_terms.end(), terms[thread].begin(), terms[thread].end());
+		}
+	}
+	return size() - before;
+}
+
+template <typename F>
+void Tuner::parallelFor(size_t count, F&& f) const {
+	std::vector<std::thread> workers;
+	size_t chunk = (count + m_threads - 1) / m_threads;
+	for (int thread = 0; thread < m_threads; thread++) {
+		size_t begin = std::min(count, thread * chunk);
+		size_t end	 = std::min(count, begin + chunk);
+		workers.emplace_back([&f, begin, end, thread] { f(begin, end, thread); });
+	}
+	for (std::thread& worker : workers) worker.join();
+}
+
+double Tuner::evaluate(size_t i) const {
+	const TunerPosition& position = m_positions[i];
+	double mg = 0, eg = 0;
+	for (uint32_t t = position.firstTerm; t < position.firstTerm + position.numTerms; t++) {
+		mg += m_terms[t].coefficient * m_mg[m_terms[t].index];
+		eg += m_terms[t].coefficient * m_eg[m_terms[t].index];
+	}
+	return (mg * position.phase + eg * (EvalParams::MAX_PHASE - position.phase)) / EvalParams::MAX_PHASE;
+}
+
+double Tuner::error(double k) const {
+	if (m_positions.empty()) return 0;
+	std::vector<double> sums(m_threads, 0.0);
+	parallelFor(size(), [&](size_t begin, size_t end, int thread) {
+		double sum = 0;
+		for (size_t i = begin; i < end; i++) {
+			double diff = m_positions[i].result / 2.0 - sigmoid(k, evaluate(i));
+			sum += diff * diff;
+		}
+		sums[thread] = sum;
+	});
+	double total = 0;
+	for (double sum : sums) total += sum;
+	return total / size();
+}
+
+double Tuner::fitK() {
+	// scan a range, then a ten times finer one around the best k, down to 4 decimals
+	double start = 0, end = 10, step = 1;
+	double best = m_k, bestError = error(m_k);
+	for (int round = 0; round < 5; round++) {
+		for (double k = start; k <= end + step / 2; k += step) {
+			double e = error(k);
+			if (e < bestError) {
+				bestError = e;
+				best	  = k;
+			}
+		}
+		start = std::max(0.0, best - step);
+		end	  = best + step;
+		step /= 10;
+	}
+	m_k = best;
+	return m_k;
+}
+
+void Tuner::gradient(std::vector<double>& mgGradient, std::vector<double>& egGradient) const {
+	std::vector<std::vector<double>> mgPartial(m_threads, std::vector<double>(s_numParams, 0.0));
+	std::vector<std::vector<double>> egPartial(m_threads, std::vector<double>(s_numParams, 0.0));
+	parallelFor(size(), [&](size_t begin, size_t end, int thread) {
+		std::vector<double>& mg = mgPartial[thread];
+		std::vector<double>& eg = egPartial[thread];
+		for (size_t i = begin; i < end; i++) {
+			const TunerPosition& position = m_positions[i];
+			double s					  = sigmoid(m_k, evaluate(i));
+			// derivative of (result - s)^2 by the score, without the constant factor of 2k ln(10) / 400 that adam scales away
+			double g	  = (s - position.result / 2.0) * s * (1 - s);
+			double mgPart = g * position.phase / EvalParams::MAX_PHASE;
+			double egPart = g - mgPart;
+			for (uint32_t t = position.firstTerm; t < position.firstTerm + position.numTerms; t++) {
+				mg[m_terms[t].index] += m_terms[t].coefficient * mgPart;
+				eg[m_terms[t].index] += m_terms[t].coefficient * egPart;
+			}
+		}
+	});
+
+	mgGradient.assign(s_numParams, 0.0);
+	egGradient.assign(s_numParams, 0.0);
+	for (int thread = 0; thread < m_threads; thread++) {
+		for (int i = 0; i < s_numParams; i++) {
+			mgGradient[i] += mgPartial[thread][i] / size();
+			egGradient[i] += egPartial[thread][i] / size();
+		}
+	}
+}
+
+void Tuner::tune(int epochs, double learningRate, std::ostream& log) {
+	constexpr double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+	constexpr int LOG_INTERVAL = 10;
+	if (m_positions.empty()) return;
+
+	std::vector<double> mgGradient, egGradient;
+	std::vector<double> mgMoment(s_numParams, 0.0), mgVelocity(s_numParams, 0.0);
+	std::vector<double> egMoment(s_numParams, 0.0), egVelocity(s_numParams, 0.0);
+	auto start = std::chrono::steady_clock::now();
+	for (int epoch = 1; epoch <= epochs; epoch++) {
+		gradient(mgGradient, egGradient);
+		double correction1 = 1 - std::pow(BETA1, epoch);
+		double correction2 = 1 - std::pow(BETA2, epoch);
+
+		auto step = [&](double& param, double g, double& moment, double& velocity) {
+			moment	 = BETA1 * moment + (1 - BETA1) * g;
+			velocity = BETA2 * velocity + (1 - BETA2) * g * g;
+			param -= learningRate * (moment / correction1) / (std::sqrt(velocity / correction2) + EPSILON);
+		};
+		for (int i = 0; i < s_numParams; i++) {
+			step(m_mg[i], mgGradient[i], mgMoment[i], mgVelocity[i]);
+			if (m_hasEg[i]) step(m_eg[i], egGradient[i], egMoment[i], egVelocity[i]);
+		}
+
+		if (epoch % LOG_INTERVAL == 0 || epoch == epochs) {
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			log << "epoch " << epoch << " error " << std::setprecision(8) << error(m_k) << " " << std::setprecision(3) << seconds / epoch << " s/epoch" << std::endl;
+		}
+	}
+}
+
+bool Tuner::replaceTable(std::string& header, const std::string& name, const std::vector<double>& values, const ParamGroup& group) {
+	// the declaration is the name followed by =, outside of a comment. other mentions of the name are left alone
+	size_t pos = 0;
+	while ((pos = header.find(name, pos)) != std::string::npos) {
+		size_t next		   = header.find_first_not_of(" \t", pos + name.size());
+		size_t lineStart   = header.rfind('\n', pos) + 1;  // npos + 1 wraps to the start of the header
+		std::string before = header.substr(lineStart, pos - lineStart);
+		bool comment	   = before.find("//") != std::string::npos || before.find('*') != std::string::npos;
+		if (!comment && pos > 0 && std::isspace(header[pos - 1]) && next != std::string::npos && header[next] == '=') break;
+		pos += name.size();
+	}
+	if (pos == std::string::npos) return false;
+
+	auto value = [&](int i) { return (int)std::clamp<long>(std::lround(values[group.offset + i]), INT16_MIN, INT16_MAX); };
+	auto row = [&](int begin, int count, int width) {
+		std::ostringstream out;
+		for (int i = begin; i < begin + count; i++) out << (i > begin ? ", " : "") << std::setw(width) << value(i);
+		return out.str();
+	};
+
+	size_t open = header.find('{', pos);
+	if (open == std::string::npos) return false;
+	if (!group.tables) {
+		size_t close = header.find('}', open);
+		if (close == std::string::npos) return false;
+		std::string text;
+		if (!group.perLine) {
+			text = row(0, group.size, 0);
+		} else {
+			for (int i = 0; i < group.size; i += group.perLine) text += "\n\t" + row(i, std::min(group.perLine, group.size - i), 3) + ",";
+			text += "\n";
+		}
+		header.replace(open + 1, close - open - 1, text);
+		return true;
+	}
+
+	// piece square tables are nested, each one is replaced in place so the comments between them stay
+	size_t cursor		= header[open + 1] == '{' ? open + 2 : open + 1;
+	const int tableSize = group.size / group.tables;
+	for (int table = 0; table < group.tables; table++) {
+		size_t inner;
+		while (true) {
+			inner = header.find_first_of("{/", cursor);
+			if (inner == std::string::npos) return false;
+			if (header[inner] == '{') break;
+			cursor = header.find('\n', inner);
+			if (cursor == std::string::npos) return false;
+		}
+		size_t close = header.find('}', inner);
+		if (close == std::string::npos) return false;
+		std::string text;
+		for (int i = 0; i < tableSize; i += group.perLine) {
+			text += (i ? ",\n\t " : "") + row(table * tableSize + i, group.perLine, 4);
+		}
+		header.replace(inner + 1, close - inner - 1, text);
+		cursor = inner + text.size() + 2;
+	}
+	return true;
+}
+
+std::string Tuner::rewriteHeader(const std::string& header) const {
+	std::string text = header;
+	for (const ParamGroup& group : s_groups) {
+		replaceTable(text, group.mgName, m_mg, group);
+		if (group.egName) replaceTable(text, group.egName, m_eg, group);
+	}
+	return text;
+}
+
+bool Tuner::writeHeader(const std::string& templatePath, const std::string& outPath) const {
+	std::ifstream in(templatePath);
+	if (!in) return false;
+	std::stringstream header;
+	header << in.rdbuf();
+
+	std::ofstream out(outPath);
+	if (!out) return false;
+	out << rewriteHeader(header.str());
+	return (bool)out;
+}
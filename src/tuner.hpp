@@ -0,0 +1,169 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+#include "eval.hpp"
+
+/**
+* @brief one nonzero coefficient of a position, index is into the flat parameter list of the tuner
+*/
+struct TunerTerm {
+	uint16_t index;
+	int16_t coefficient;
+};
+
+/**
+* @brief a labelled position, reduced to its slice of the shared term array. 8 bytes plus 4 per term, around 200 in total
+*/
+struct TunerPosition {
+	uint32_t firstTerm;
+	uint16_t numTerms;
+
+	/**
+	* @brief game phase, capped at MAX_PHASE
+	*/
+	uint8_t phase;
+
+	/**
+	* @brief game result from whites POV in half points, 0 for a loss, 1 for a draw, 2 for a win
+	*/
+	uint8_t result;
+};
+
+/**
+* @brief texel tuner for the weights in eval_params.hpp. each labelled position is traced once when it is loaded, after that its
+* score is the sum of its coefficients times the current weights, so an epoch never touches a board. the weights are fit with adam
+* on the full batch, minimizing the squared difference between the game result and sigmoid(K * score), with the positions split
+* across threads
+*/
+class Tuner {
+public:
+	/**
+	* @brief a tuner with the current EvalParams as its weights, using threads threads, or all cores if threads is 0
+	*/
+	explicit Tuner(int threads = 0);
+
+	/**
+	* @brief parses one line of a dataset, a fen (the move counters are optional) and a result, e.g. "<fen> [0.5]", "<fen>; 1-0" or
+	* an epd with c9 "0-1". positions that are in check or have no legal moves are skipped, since their static score means little,
+	* and so are endgames scored by Endgame. returns whether the position was added
+	*/
+	bool addPosition(const std::string& line);
+
+	/**
+	* @brief adds every position in a dataset file, tracing batches of lines on all threads. files ending in .bin are read as
+	* DatagenRecords, their search scores are ignored. returns the number added
+	*/
+	size_t load(const std::string& path);
+
+	size_t size() const { return m_positions.size(); }
+
+	/**
+	* @brief score of position i from whites POV with the current weights
+	*/
+	double evaluate(size_t i) const;
+
+	/**
+	* @brief mean squared error of the predicted results over all positions, for scaling constant k
+	*/
+	double error(double k) const;
+
+	/**
+	* @brief finds the k with the smallest error for the current weights and keeps it for tune
+	*/
+	double fitK();
+
+	double k() const { return m_k; }
+	void setK(double k) { m_k = k; }
+
+	/**
+	* @brief runs epochs full batch adam steps of learningRate centipawns, logging the error to log every few epochs
+	*/
+	void tune(int epochs, double learningRate, std::ostream& log);
+
+	/**
+	* @brief returns header, the text of an eval_params.hpp, with the values of every tuned table replaced by the current weights.
+	* comments and everything that isnt tuned are kept as they are
+	*/
+	std::string rewriteHeader(const std::string& header) const;
+
+	/**
+	* @brief reads the eval_params.hpp at templatePath and writes it with the current weights to outPath
+	*/
+	bool writeHeader(const std::string& templatePath, const std::string& outPath) const;
+
+	/**
+	* @brief lines traced per batch by load
+	*/
+	static constexpr size_t LOAD_BATCH_SIZE = 1 << 16;
+
+private:
+	/**
+	* @brief a table of eval_params.hpp as a slice of the flat parameter list. tables without an endgame name are middlegame only
+	*/
+	struct ParamGroup {
+		const char* mgName;
+		const char* egName;
+		int offset;
+		int size;
+
+		/**
+		* @brief number of sub tables of 64 for the piece square tables, 0 for a flat table
+		*/
+		int tables;
+
+		/**
+		* @brief values per line when written, 0 to write them all on one line
+		*/
+		int perLine;
+	};
+
+	/**
+	* @brief traces the position in line into positions and terms, returns false if it isnt usable
+	*/
+	static bool parseLine(const std::string& line, Board& b, std::vector<TunerPosition>& positions, std::vector<TunerTerm>& terms);
+
+	/**
+	* @brief the coefficients of trace in the order of the flat parameter list
+	*/
+	static std::vector<int> flatten(const EvalTrace& trace);
+
+	/**
+	* @brief calls f(begin, end, thread) for a slice of [0, count) on each thread and waits for all of them
+	*/
+	template <typename F>
+	void parallelFor(size_t count, F&& f) const;
+
+	/**
+	* @brief mean of the error gradients over all positions for the middlegame and endgame weights
+	*/
+	void gradient(std::vector<double>& mgGradient, std::vector<double>& egGradient) const;
+
+	/**
+	* @brief replaces the values of the table named name in header with values, returns false if there is no such table
+	*/
+	static bool replaceTable(std::string& header, const std::string& name, const std::vector<double>& values, const ParamGroup& group);
+
+	static const std::vector<ParamGroup> s_groups;
+	static const int s_numParams;
+
+	int m_threads;
+	double m_k = 1.0;
+
+	std::vector<double> m_mg;
+	std::vector<double> m_eg;
+
+	/**
+	* @brief whether each parameter has an endgame weight, false for the middlegame only terms whose endgame weight stays 0
+	*/
+	std::vector<bool> m_hasEg;
+
+	std::vector<TunerPosition> m_positions;
+	std::vector<TunerTerm> m_terms;
+};
+#endif
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "endgame.hpp"
+#include "lookup_tables.hpp"
+#include "tuner.hpp"
+#include "zobrist.hpp"
+
+/**
+* @brief tuner <dataset> [-epochs N] [-lr X] [-threads N] [-k X] [-params path] [-out path]
+* fits the weights in params (src/eval_params.hpp by default) to the dataset and writes the tuned header to out. k is fit to
+* the dataset first unless it is given
+*/
+int main(int argc, char** argv) {
+	LookupTables::init();
+	Zobrist::init();
+	Endgame::init();
+
+	if (argc < 2) {
+		std::cerr << "usage: tuner <dataset> [-epochs N] [-lr X] [-threads N] [-k X] [-params path] [-out path]" << std::endl;
+		return 1;
+	}
+
+	std::string dataset = argv[1];
+	std::string params	= "src/eval_params.hpp";
+	std::string out		= "eval_params_tuned.hpp";
+	int epochs			= 500;
+	int threads			= 0;
+	double learningRate = 1.0;
+	double k			= 0;
+	for (int i = 2; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+		if (option == "-epochs") {
+			epochs = std::atoi(argv[i + 1]);
+		} else if (option == "-lr") {
+			learningRate = std::atof(argv[i + 1]);
+		} else if (option == "-threads") {
+			threads = std::atoi(argv[i + 1]);
+		} else if (option == "-k") {
+			k = std::atof(argv[i + 1]);
+		} else if (option == "-params") {
+			params = argv[i + 1];
+		} else if (option == "-out") {
+			out = argv[i + 1];
+		} else {
+			std::cerr << "unknown option " << option << std::endl;
+			return 1;
+		}
+	}
+
+	Tuner tuner(threads);
+	auto start	  = std::chrono::steady_clock::now();
+	size_t loaded = tuner.load(dataset);
+	auto loadMs	  = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "loaded " << loaded << " positions in " << loadMs << " ms" << std::endl;
+	if (!loaded) return 1;
+
+	if (k > 0) {
+		tuner.setK(k);
+	} else {
+		tuner.fitK();
+	}
+	std::cout << "k " << tuner.k() << " error " << tuner.error(tuner.k()) << std::endl;
+
+	tuner.tune(epochs, learningRate, std::cout);
+	if (!tuner.writeHeader(params, out)) {
+		std::cerr << "couldnt write " << out << " from " << params << std::endl;
+		return 1;
+	}
+	std::cout << "wrote " << out << std::endl;
+}
@@ -0,0 +1,268 @@
+#include "uci.hpp"
+#include "bench.hpp"
+#include "book.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "nnue.hpp"
+#include "syzygy.hpp"
+#include "time_manager.hpp"
+#include "transposition_table.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+Uci::Uci(std::istream& in, std::ostream& out) : m_in(in), m_out(out), m_listener(out, &m_outMutex) {
+	m_searchContext.listener = &m_listener;
+}
+
+Uci::~Uci() {
+	stop();
+}
+
+void Uci::loop() {
+	std::string line;
+	while (std::getline(m_in, line)) {
+		if (!handleCommand(line)) break;
+	}
+	stop();
+}
+
+bool Uci::handleCommand(const std::string& line) {
+	std::istringstream args(line);
+	std::string command;
+	args >> command;
+
+	if (command == "uci") uci();
+	else if (command == "isready") send("readyok");
+	else if (command == "ucinewgame") newGame();
+	else if (command == "position") position(args);
+	else if (command == "go") go(args);
+	else if (command == "stop") stop();
+	else if (command == "ponderhit") m_searchContext.ponderhit();
+	else if (command == "setoption") setOption(args);
+	else if (command == "bench") bench(args);
+	else if (command == "quit") return false;
+	else if (!command.empty()) send("info string unknown command " + command);
+	return true;
+}
+
+void Uci::waitForSearch() {
+	if (m_searchThread.joinable()) m_searchThread.join();
+}
+
+Move Uci::parseMove(Board& b, const std::string& notation) {
+	for (const Move& m : b.moveGenerator.genLegalMoves()) {
+		if (m.UCInotation() == notation) return m;
+	}
+	return Move();
+}
+
+void Uci::uci() {
+	send(std::string("id name ") + ENGINE_NAME);
+	send(std::string("id author ") + ENGINE_AUTHOR);
+	send("option name Hash type spin default " + std::to_string(TT_SIZE_MB / (1024 * 1024)) + " min " + std::to_string(MIN_HASH_MB) + " max " +
+		 std::to_string(MAX_HASH_MB));
+	send("option name Clear Hash type button");
+	send("option name Ponder type check default false");
+	send("option name Deterministic type check default false");
+	send("option name MultiPV type spin default 1 min 1 max " + std::to_string(MAX_MULTI_PV));
+	send("option name EvalFile type string default <empty>");
+	send("option name SyzygyPath type string default <empty>");
+	send("option name BookFile type string default <empty>");
+	send("option name BookBestMove type check default false");
+	send("uciok");
+}
+
+void Uci::newGame() {
+	stop();
+	TranspositionTable::shared().reset();
+	m_searchContext.reset();
+	m_board = Board();
+}
+
+void Uci::position(std::istringstream& args) {
+	stop();
+	std::string token;
+	args >> token;
+
+	Board board;
+	if (token == "startpos") {
+		args >> token;
+	} else if (token == "fen") {
+		std::string fen;
+		while (args >> token && token != "moves") {
+			fen += token + " ";
+		}
+		board.setToFen(fen.c_str());
+	} else {
+		send("info string expected startpos or fen");
+		return;
+	}
+
+	if (token == "moves") {
+		while (args >> token) {
+			Move m = parseMove(board, token);
+			if (m.getPieceType() == NONE_PIECE) {
+				send("info string illegal move " + token);
+				break;
+			}
+			board.execute(m);
+		}
+	}
+	m_board = board;
+}
+
+void Uci::go(std::istringstream& args) {
+	stop();
+
+	TimeControl tc;
+	int maxDepth	   = SearchContext::MAX_SEARCH_DEPTH;
+	uint64_t maxNodes = 0;
+	bool ponder		   = false;
+	m_infinite		   = false;
+
+	Color us = m_board.boardState.sideToMove;
+	std::string token;
+	while (args >> token) {
+		if (token == "wtime" || token == "btime") {
+			int ms;
+			args >> ms;
+			if ((token == "wtime") == (us == WHITE)) tc.remainingMs = ms;
+		} else if (token == "winc" || token == "binc") {
+			int ms;
+			args >> ms;
+			if ((token == "winc") == (us == WHITE)) tc.incrementMs = ms;
+		} else if (token == "movestogo") {
+			args >> tc.movesToGo;
+		} else if (token == "movetime") {
+			args >> tc.moveTimeMs;
+		} else if (token == "depth") {
+			args >> maxDepth;
+		} else if (token == "nodes") {
+			args >> maxNodes;
+		} else if (token == "infinite") {
+			m_infinite = true;
+		} else if (token == "ponder") {
+			ponder = true;
+		}
+	}
+	if (m_infinite) tc = TimeControl();
+	if (m_searchContext.deterministic && (tc.remainingMs >= 0 || tc.moveTimeMs >= 0)) {
+		send("info string searching on the clock, the result is not deterministic");
+	}
+
+	// analysis and pondering want a search, anything else plays from the book while it can. a deterministic engine always plays
+	// the heaviest move
+	if (!m_infinite && !ponder) {
+		Move bookMove = Book::probe(m_board, m_bookBestMove || m_searchContext.deterministic);
+		if (bookMove.getPieceType() != NONE_PIECE) {
+			send("bestmove " + bookMove.UCInotation());
+			return;
+		}
+	}
+
+	m_searchContext.nodeLimit = maxNodes;
+	// a ponder search keeps the clock it was given, it just doesnt start using it until ponderhit
+	m_searchContext.setPondering(ponder);
+	m_searchContext.prepareSearch();
+
+	m_searchThread = std::thread([this, board = m_board, tc, maxDepth, multiPV = m_multiPV]() mutable {
+		Moves topLine;
+		if (multiPV > 1) {
+			std::vector<PVLine> lines = Eval::iterative_deepening_multipv(m_searchContext, board, multiPV, tc, maxDepth);
+			if (!lines.empty()) topLine = lines[0].pv;
+		} else {
+			Eval::iterative_deepening(m_searchContext, topLine, board, tc, maxDepth);
+		}
+		// under go infinite or while pondering the gui decides when the search is over, even if it ended early
+		while ((m_infinite || m_searchContext.pondering()) && !m_searchContext.stopped()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::string bestMove = "bestmove " + (topLine.empty() ? std::string("0000") : topLine[0].UCInotation());
+		// the reply the engine expects is what the gui should let it ponder on next
+		if (topLine.size() >= 2) bestMove += " ponder " + topLine[1].UCInotation();
+		send(bestMove);
+	});
+}
+
+void Uci::setOption(std::istringstream& args) {
+	std::string token, name, value;
+	args >> token;
+	while (args >> token && token != "value") {
+		name += (name.empty() ? "" : " ") + token;
+	}
+	// the rest of the line, since a file path may contain spaces
+	std::getline(args >> std::ws, value);
+
+	if (name == "Clear Hash") {
+		stop();
+		TranspositionTable::shared().reset();
+	} else if (name == "MultiPV") {
+		m_multiPV = std::clamp(std::atoi(value.c_str()), 1, MAX_MULTI_PV);
+	} else if (name == "Deterministic") {
+		// makes go depth, go nodes and go infinite reproducible. wtime, btime and movetime still stop the search in time, since
+		// ignoring them would lose every timed game, so those searches depend on the clock as usual and say so in an info string
+		stop();
+		m_searchContext.deterministic = value == "true";
+	} else if (name == "EvalFile") {
+		stop();
+		if (value.empty() || value == "<empty>") {
+			NNUE::unload();
+			send("info string using the handcrafted evaluation");
+		} else if (NNUE::load(value)) {
+			send("info string loaded net " + value);
+		} else {
+			send("info string could not load net " + value + (NNUE::isLoaded() ? ", keeping the current net" : ""));
+		}
+		m_board.refreshAccumulator();
+	} else if (name == "SyzygyPath") {
+		stop();
+		int tables = Syzygy::init(value);
+		if (tables) {
+			send("info string found " + std::to_string(tables) + " tablebases, up to " + std::to_string(Syzygy::largest()) + " pieces");
+			if (!Syzygy::verified()) send("info string the search wont probe them, " + Syzygy::verifyFailure());
+		} else if (!value.empty() && value != "<empty>") {
+			send("info string no tablebases found in " + value);
+		}
+	} else if (name == "BookFile") {
+		stop();
+		if (value.empty() || value == "<empty>") {
+			Book::close();
+		} else if (Book::open(value)) {
+			send("info string loaded book " + value + " with " + std::to_string(Book::size()) + " entries");
+		} else {
+			send("info string could not load book " + value);
+		}
+	} else if (name == "BookBestMove") {
+		m_bookBestMove = value == "true";
+	} else if (name == "Ponder") {
+		// the gui decides when to send go ponder, so there is nothing to change on our side
+	} else if (name == "Hash") {
+		// resizing drops the entries, like Clear Hash
+		stop();
+		int hashMb = std::clamp(std::atoi(value.c_str()), MIN_HASH_MB, MAX_HASH_MB);
+		TranspositionTable::shared().resize((size_t)hashMb * 1024 * 1024);
+		send("info string Hash set to " + std::to_string(hashMb) + " MB");
+	} else {
+		send("info string unknown option " + name);
+	}
+}
+
+void Uci::bench(std::istringstream& args) {
+	stop();
+	int depth = Bench::DEFAULT_DEPTH;
+	args >> depth;
+	std::lock_guard<std::mutex> lock(m_outMutex);
+	Bench::run(depth, m_out);
+}
+
+void Uci::stop() {
+	m_searchContext.stop();
+	waitForSearch();
+}
+
+void Uci::send(const std::string& line) {
+	std::lock_guard<std::mutex> lock(m_outMutex);
+	m_out << line << std::endl;
+}
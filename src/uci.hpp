@@ -0,0 +1,116 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "board.hpp"
+#include "consts.hpp"
+#include "search_context.hpp"
+#include "search_listener.hpp"
+
+/**
+* @brief Universal Chess Interface front end. reads commands from an input stream and writes replies to an output stream.
+* searches run on a background thread so stop, isready and quit are answered while the engine is thinking.
+*/
+class Uci {
+public:
+	static constexpr const char* ENGINE_NAME   = "Typhon";
+	static constexpr const char* ENGINE_AUTHOR = "the Typhon authors";
+	static constexpr int MAX_MULTI_PV			= 64;
+
+	/**
+	* @brief range of the Hash option in MB, the upper end keeps the entry count of the table within an int
+	*/
+	static constexpr int MIN_HASH_MB = 1;
+	static constexpr int MAX_HASH_MB = 4096;
+
+	/**
+	* @param in Stream commands are read from.
+	* @param out Stream replies are written to. only written while holding the output mutex.
+	*/
+	Uci(std::istream& in, std::ostream& out);
+
+	/**
+	* @brief stops and joins any running search
+	*/
+	~Uci();
+
+	/**
+	* @brief reads and handles commands until quit or end of input
+	*/
+	void loop();
+
+	/**
+	* @brief handles a single command line
+	* @return false if the command was quit
+	*/
+	bool handleCommand(const std::string& line);
+
+	/**
+	* @brief blocks until the running search, if any, has sent its bestmove
+	*/
+	void waitForSearch();
+
+	/**
+	* @brief finds the legal move with the given uci notation, or a null move if there is none
+	*/
+	static Move parseMove(Board& b, const std::string& notation);
+
+private:
+	std::istream& m_in;
+	std::ostream& m_out;
+	std::mutex m_outMutex;
+
+	/**
+	* @brief turns the iterations of every search into info lines on the output stream
+	*/
+	UciSearchListener m_listener;
+
+	/**
+	* @brief the position set by the last position command. searches run on a copy
+	*/
+	Board m_board;
+	SearchContext m_searchContext;
+	std::thread m_searchThread;
+
+	/**
+	* @brief set for go infinite, where bestmove may only be sent after stop. go ponder works the same way until ponderhit
+	*/
+	bool m_infinite = false;
+
+	/**
+	* @brief number of lines searched, set with the MultiPV option
+	*/
+	int m_multiPV = 1;
+
+	/**
+	* @brief play the heaviest book move instead of a weighted random one, set with the BookBestMove option
+	*/
+	bool m_bookBestMove = false;
+
+	void uci();
+	void newGame();
+	void position(std::istringstream& args);
+	void go(std::istringstream& args);
+	void setOption(std::istringstream& args);
+
+	/**
+	* @brief runs the bench on this thread, optionally to the depth given after it
+	*/
+	void bench(std::istringstream& args);
+
+	/**
+	* @brief stops the running search and waits for it to send bestmove
+	*/
+	void stop();
+
+	/**
+	* @brief writes one line to the output stream
+	*/
+	void send(const std::string& line);
+};
+#endif
@@ -0,0 +1,103 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "bench.hpp"
+#include "datagen.hpp"
+#include "endgame.hpp"
+#include "epd.hpp"
+#include "lookup_tables.hpp"
+#include "nnue.hpp"
+#include "uci.hpp"
+#include "zobrist.hpp"
+
+int main(int argc, char** argv) {
+	LookupTables::init();
+	Zobrist::init();
+	Endgame::init();
+
+	// engine-cli bench [depth], for comparing builds without a gui
+	if (argc >= 2 && std::string(argv[1]) == "bench") {
+		Bench::run(argc >= 3 ? std::atoi(argv[2]) : Bench::DEFAULT_DEPTH, std::cout);
+		return 0;
+	}
+
+	// engine-cli datagen <file> [-games N] [-threads N] [-nodes N] [-seed N] [-random N], self play training data
+	if (argc >= 3 && std::string(argv[1]) == "datagen") {
+		Datagen::Options options;
+		for (int i = 3; i + 1 < argc; i += 2) {
+			std::string option = argv[i];
+			uint64_t value	   = std::strtoull(argv[i + 1], nullptr, 10);
+			if (option == "-games") {
+				options.games = value;
+			} else if (option == "-threads") {
+				options.threads = value;
+			} else if (option == "-nodes") {
+				options.nodes = value;
+			} else if (option == "-seed") {
+				options.seed = value;
+			} else if (option == "-random") {
+				options.randomPlies = value;
+			} else {
+				std::cerr << "unknown option " << option << std::endl;
+				return 1;
+			}
+		}
+		Datagen::run(argv[2], options, std::cout);
+		return 0;
+	}
+
+	// engine-cli match <net> [-games N] [-threads N] [-nodes N] [-seed N] [-random N], the net against the handcrafted evaluation
+	if (argc >= 3 && std::string(argv[1]) == "match") {
+		Datagen::Options options;
+		options.games = 200;
+		for (int i = 3; i + 1 < argc; i += 2) {
+			std::string option = argv[i];
+			uint64_t value	   = std::strtoull(argv[i + 1], nullptr, 10);
+			if (option == "-games") {
+				options.games = value;
+			} else if (option == "-threads") {
+				options.threads = value;
+			} else if (option == "-nodes") {
+				options.nodes = value;
+			} else if (option == "-seed") {
+				options.seed = value;
+			} else if (option == "-random") {
+				options.randomPlies = value;
+			} else {
+				std::cerr << "unknown option " << option << std::endl;
+				return 1;
+			}
+		}
+		if (!NNUE::load(argv[2])) {
+			std::cerr << "could not load net " << argv[2] << std::endl;
+			return 1;
+		}
+		Datagen::match(options, std::cout);
+		return 0;
+	}
+
+	// engine-cli epd <file> [-threads N] [-time ms] [-nodes N], solved count of a test suite with bm or am operations
+	if (argc >= 3 && std::string(argv[1]) == "epd") {
+		Epd::Options options;
+		for (int i = 3; i + 1 < argc; i += 2) {
+			std::string option = argv[i];
+			uint64_t value	   = std::strtoull(argv[i + 1], nullptr, 10);
+			if (option == "-threads") {
+				options.threads = value;
+			} else if (option == "-time") {
+				options.timeMs = value;
+			} else if (option == "-nodes") {
+				options.nodes = value;
+			} else {
+				std::cerr << "unknown option " << option << std::endl;
+				return 1;
+			}
+		}
+		Epd::run(argv[2], options, std::cout);
+		return 0;
+	}
+
+	Uci uci(std::cin, std::cout);
+	uci.loop();
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../include/doctest.h"
+#include "../src/endgame.hpp"
 #include "../src/lookup_tables.hpp"
 #include "../src/zobrist.hpp"
 
@@ -8,6 +9,7 @@ struct CustomTestFixture {
 	CustomTestFixture() {
 		LookupTables::init();
 		Zobrist::init();
+		Endgame::init();
 	}
 };
 
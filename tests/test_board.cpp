@@ -5,6 +5,8 @@
 #include "../src/move.hpp"
 #include "../src/zobrist.hpp"
 
+#include <functional>
+
 CUSTOM_TEST_CASE("Test Castling Rights") {
 	Board b = Board();
 
@@ -255,6 +257,75 @@ CUSTOM_TEST_CASE("Test isInsufficientMaterial") {
 	}
 }
 
+CUSTOM_TEST_CASE("Test isRepetition") {
+	Board b;
+	auto shuffleKnights = [&]() {
+		b.execute(Move(b, g1, f3, KNIGHT));
+		b.execute(Move(b, g8, f6, KNIGHT));
+		b.execute(Move(b, f3, g1, KNIGHT));
+		b.execute(Move(b, f6, g8, KNIGHT));
+	};
+	SUBCASE("No repetition at the start") {
+		CHECK(!b.isRepetition());
+		CHECK(!b.isThreefoldRepetition());
+	}
+	SUBCASE("Knight shuffle repeats the starting position") {
+		shuffleKnights();
+		CHECK(b.isRepetition());
+		CHECK(!b.isThreefoldRepetition());
+		shuffleKnights();
+		CHECK(b.isRepetition());
+		CHECK(b.isThreefoldRepetition());
+	}
+	SUBCASE("Undo removes the repetition") {
+		shuffleKnights();
+		b.undoMove();
+		CHECK(!b.isRepetition());
+		b.execute(Move(b, f6, g8, KNIGHT));
+		CHECK(b.isRepetition());
+	}
+	SUBCASE("Same side has to be to move") {
+		b.setToFen("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+		b.execute(Move(b, a1, a2, ROOK));
+		b.execute(Move(b, e8, e7, KING));
+		b.execute(Move(b, a2, a3, ROOK));
+		b.execute(Move(b, e7, e8, KING));
+		b.execute(Move(b, a3, a1, ROOK));
+		CHECK(!b.isRepetition());
+	}
+	SUBCASE("Pawn move resets the history that can repeat") {
+		b.execute(Move(b, g1, f3, KNIGHT));
+		b.execute(Move(b, g8, f6, KNIGHT));
+		b.execute(Move(b, e2, e4, PAWN));
+		b.execute(Move(b, f6, g8, KNIGHT));
+		b.execute(Move(b, f3, g1, KNIGHT));
+		b.execute(Move(b, g8, f6, KNIGHT));
+		CHECK(!b.isRepetition());
+		b.execute(Move(b, g1, f3, KNIGHT));
+		b.execute(Move(b, f6, g8, KNIGHT));
+		b.execute(Move(b, f3, g1, KNIGHT));
+		CHECK(b.isRepetition());
+	}
+	SUBCASE("Lost castling rights make it a different position") {
+		b.setToFen("r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R w KQkq - 0 1");
+		b.execute(Move(b, e1, f1, KING));
+		b.execute(Move(b, e8, f8, KING));
+		b.execute(Move(b, f1, e1, KING));
+		b.execute(Move(b, f8, e8, KING));
+		CHECK(!b.isRepetition());
+		b.execute(Move(b, e1, f1, KING));
+		b.execute(Move(b, e8, f8, KING));
+		b.execute(Move(b, f1, e1, KING));
+		b.execute(Move(b, f8, e8, KING));
+		CHECK(b.isRepetition());
+	}
+	SUBCASE("setToFen clears the history") {
+		shuffleKnights();
+		b.setToFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 8 5");
+		CHECK(!b.isRepetition());
+	}
+}
+
 CUSTOM_TEST_CASE("Test isGameOver") {
 	Board b;
 	SUBCASE("Not game over") {
@@ -269,6 +340,16 @@ CUSTOM_TEST_CASE("Test isGameOver") {
 		b.setToFen("8/8/8/4k3/3K4/8/8/8 w - - 0 1");
 		CHECK(b.isGameOver());
 	}
+	SUBCASE("Threefold repetition") {
+		for (int i = 0; i < 2; i++) {
+			CHECK(!b.isGameOver());
+			b.execute(Move(b, b1, c3, KNIGHT));
+			b.execute(Move(b, b8, c6, KNIGHT));
+			b.execute(Move(b, c3, b1, KNIGHT));
+			b.execute(Move(b, c6, b8, KNIGHT));
+		}
+		CHECK(b.isGameOver());
+	}
 }
 
 CUSTOM_TEST_CASE("Test Zobrist Hash") {
@@ -284,6 +365,49 @@ CUSTOM_TEST_CASE("Test Zobrist Hash") {
 		b.undoMove();
 		CHECK(b.boardState.hash == beforeHash);
 	}
+	SUBCASE("Incremental hash matches full hash") {
+		std::function<bool(int)> hashesMatch = [&](int depth) {
+			if (b.boardState.hash != Zobrist::hash(b.boardState)) return false;
+			if (depth == 0) return true;
+			for (Move m : b.moveGenerator.genLegalMoves()) {
+				b.execute(m);
+				bool match = hashesMatch(depth - 1);
+				b.undoMove();
+				if (!match) return false;
+			}
+			return true;
+		};
+		// castling both ways, en passant, promotions and captures
+		b.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		CHECK(hashesMatch(3));
+		b.setToFen("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8");
+		CHECK(hashesMatch(3));
+		b.setToFen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+		CHECK(hashesMatch(3));
+	}
+	SUBCASE("Incremental eval terms match a full computation") {
+		std::function<bool(int)> scoresMatch = [&](int depth) {
+			Board::BoardState incremental = b.boardState;
+			b.computePieceScores();
+			if (incremental.mgScore != b.boardState.mgScore || incremental.egScore != b.boardState.egScore || incremental.phase != b.boardState.phase) return false;
+			if (depth == 0) return true;
+			for (Move m : b.moveGenerator.genLegalMoves()) {
+				b.execute(m);
+				bool match = scoresMatch(depth - 1);
+				b.undoMove();
+				if (!match) return false;
+			}
+			return true;
+		};
+		CHECK(scoresMatch(2));
+		CHECK(b.boardState.phase == EvalParams::MAX_PHASE);
+		b.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		CHECK(scoresMatch(3));
+		b.setToFen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+		CHECK(scoresMatch(3));
+		b.setToFen("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+		CHECK(scoresMatch(3));
+	}
 	SUBCASE("Same position has same hash") {
 		Board b1;
 		Board b2;
@@ -0,0 +1,159 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/book.hpp"
+#include "../src/uci.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct TestEntry {
+	uint64_t key;
+	uint16_t move;
+	uint16_t weight;
+};
+
+/**
+* @brief writes entries sorted by key as a polyglot book
+*/
+std::filesystem::path writeBook(std::vector<TestEntry> entries) {
+	std::stable_sort(entries.begin(), entries.end(), [](const TestEntry& a, const TestEntry& b) { return a.key < b.key; });
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "typhon_book_test.bin";
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	auto put = [&](uint64_t value, int bytes) {
+		for (int i = bytes - 1; i >= 0; i--) file.put((char)(value >> (8 * i)));
+	};
+	for (const TestEntry& e : entries) {
+		put(e.key, 8);
+		put(e.move, 2);
+		put(e.weight, 2);
+		put(0, 4);
+	}
+	return path;
+}
+
+Board afterMoves(const char* fen, std::vector<std::string> moves) {
+	Board b;
+	b.setToFen(fen);
+	for (const std::string& notation : moves) b.execute(Uci::parseMove(b, notation));
+	return b;
+}
+
+uint16_t encode(Board& b, const std::string& notation) {
+	return Book::encode(Uci::parseMove(b, notation));
+}
+} // namespace
+
+CUSTOM_TEST_CASE("Test Book") {
+	const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+	SUBCASE("Keys") {
+		Board b = afterMoves(start, {});
+		CHECK(Book::key(b) != Book::key(afterMoves(start, {"g1f3"})));
+		// transpositions share a key, and an en passant square without a pawn to take counts for nothing
+		CHECK(Book::key(afterMoves(start, {"e2e4", "e7e5", "g1f3"})) == Book::key(afterMoves(start, {"g1f3", "e7e5", "e2e4"})));
+		CHECK(Book::key(afterMoves("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", {})) ==
+			  Book::key(afterMoves("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2", {})));
+		CHECK(Book::key(afterMoves("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", {})) !=
+			  Book::key(afterMoves("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 3", {})));
+		// castling rights are part of the key
+		CHECK(Book::key(afterMoves(start, {"g1f3", "g8f6", "f3g1", "f6g8"})) == Book::key(b));
+		CHECK(Book::key(afterMoves(start, {"b1c3", "g8f6", "a1b1", "f6g8", "b1a1", "g8f6", "c3b1", "f6g8"})) != Book::key(b));
+	}
+	SUBCASE("Move encoding") {
+		Board b = afterMoves(start, {});
+		CHECK(encode(b, "e2e4") == (e4 | e2 << 6));
+		b.setToFen("r3k2r/1P6/8/8/8/8/8/R3K2R w KQkq - 0 1");
+		CHECK(encode(b, "e1g1") == (h1 | e1 << 6));
+		CHECK(encode(b, "e1c1") == (a1 | e1 << 6));
+		CHECK(encode(b, "b7a8q") == (a8 | b7 << 6 | 4 << 12));
+		CHECK(encode(b, "b7b8n") == (b8 | b7 << 6 | 1 << 12));
+	}
+	SUBCASE("Probing") {
+		Board b		= afterMoves(start, {});
+		Board e4	= afterMoves(start, {"e2e4"});
+		Board other = afterMoves("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", {});
+		std::filesystem::path path = writeBook({
+			{Book::key(b), encode(b, "e2e4"), 3},
+			{Book::key(b), encode(b, "d2d4"), 1},
+			// not legal in the start position
+			{Book::key(b), (uint16_t)(e5 | e2 << 6), 100},
+			{Book::key(e4), encode(e4, "c7c5"), 0},
+			{Book::key(other), encode(other, "e1g1"), 7},
+		});
+		REQUIRE(Book::open(path.string()));
+		CHECK(Book::size() == 5);
+
+		std::vector<BookMove> moves = Book::moves(b);
+		REQUIRE(moves.size() == 2);
+		CHECK(moves[0].move.UCInotation() == "e2e4");
+		CHECK(moves[0].weight == 3);
+		CHECK(moves[1].move.UCInotation() == "d2d4");
+
+		CHECK(Book::probe(b, true).UCInotation() == "e2e4");
+		int e4Count = 0;
+		for (int i = 0; i < 400; i++) {
+			std::string move = Book::probe(b).UCInotation();
+			CHECK((move == "e2e4" || move == "d2d4"));
+			e4Count += move == "e2e4";
+		}
+		CHECK(e4Count > 200);
+		CHECK(e4Count < 400);
+
+		CHECK(Book::probe(e4).UCInotation() == "c7c5");
+		CHECK(Book::probe(other).UCInotation() == "e1g1");
+		Board out = afterMoves(start, {"a2a3"});
+		CHECK(Book::probe(out).getPieceType() == NONE_PIECE);
+
+		Book::close();
+		CHECK(!Book::isOpen());
+		CHECK(Book::probe(b).getPieceType() == NONE_PIECE);
+		std::filesystem::remove(path);
+	}
+	SUBCASE("Broken files are not opened") {
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "typhon_book_broken.bin";
+		std::ofstream(path, std::ios::binary) << "not a book";
+		CHECK(!Book::open(path.string()));
+		CHECK(!Book::open("/nonexistent/book.bin"));
+		CHECK(!Book::isOpen());
+		std::filesystem::remove(path);
+	}
+	SUBCASE("The uci go command plays from the book") {
+		Board b						= afterMoves(start, {});
+		std::filesystem::path path = writeBook({{Book::key(b), encode(b, "d2d4"), 1}});
+		std::istringstream in("setoption name BookFile value " + path.string() + "\nposition startpos\ngo depth 20\nposition startpos moves d2d4\ngo depth 1\nquit\n");
+		std::ostringstream out;
+		Uci uci(in, out);
+		uci.loop();
+		std::string output = out.str();
+		CHECK(output.find("info string loaded book") != std::string::npos);
+		// the first go answers without an iteration, the second is out of book and searches
+		size_t firstBestMove = output.find("bestmove d2d4");
+		REQUIRE(firstBestMove != std::string::npos);
+		CHECK(output.find("info depth", 0) > firstBestMove);
+		CHECK(output.find("bestmove", firstBestMove + 1) != std::string::npos);
+
+		Book::close();
+		std::filesystem::remove(path);
+	}
+}
+
+// the key vectors from the polyglot documentation
+CUSTOM_TEST_CASE("Test Book published keys") {
+	const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+	CHECK(Book::key(afterMoves(start, {})) == 0x463b96181691fc9cULL);
+	CHECK(Book::key(afterMoves(start, {"e2e4"})) == 0x823c9b50fd114196ULL);
+	CHECK(Book::key(afterMoves(start, {"e2e4", "d7d5"})) == 0x0756b94461c50fb0ULL);
+	CHECK(Book::key(afterMoves(start, {"e2e4", "d7d5", "e4e5"})) == 0x662fafb965db29d4ULL);
+	CHECK(Book::key(afterMoves(start, {"e2e4", "d7d5", "e4e5", "f7f5"})) == 0x22a48b5a8e47ff78ULL);
+	CHECK(Book::key(afterMoves(start, {"e2e4", "d7d5", "e4e5", "f7f5", "e1e2"})) == 0x652a607ca3f242c1ULL);
+	CHECK(Book::key(afterMoves(start, {"e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7"})) == 0x00fdd303c946bdd9ULL);
+	CHECK(Book::key(afterMoves(start, {"a2a4", "b7b5", "h2h4", "b5b4", "c2c4"})) == 0x3c8123ea7b067637ULL);
+	CHECK(Book::key(afterMoves(start, {"a2a4", "b7b5", "h2h4", "b5b4", "c2c4", "b4c3", "a1a3"})) == 0x5c3f9b829b279560ULL);
+}
@@ -0,0 +1,105 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/datagen.hpp"
+#include "../src/nnue.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+CUSTOM_TEST_CASE("Test Datagen") {
+	SUBCASE("Records round trip through a fen") {
+		const char* fens[] = {
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+			"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b Kq - 3 17",
+			"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+			"rnbqkbnr/pppp1ppp/8/8/3PpP2/8/PPP1P1PP/RNBQKBNR b KQkq f3 0 3",
+			"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		};
+		for (const char* fen : fens) {
+			Board b;
+			b.setToFen(fen);
+			DatagenRecord record = DatagenRecord::pack(b, -37);
+			CHECK(record.fen() == fen);
+			CHECK(record.score == -37);
+			CHECK(record.sideToMove == b.boardState.sideToMove);
+		}
+	}
+	SUBCASE("A run writes the quiet positions of every game") {
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "typhon_datagen_test.bin";
+		Datagen::Options options;
+		options.games	= 3;
+		options.threads = 2;
+		options.nodes	= 300;
+		std::ostringstream log;
+		DatagenResult result = Datagen::run(path.string(), options, log);
+
+		CHECK(result.games == 3);
+		CHECK(result.positions > 0);
+		CHECK(std::filesystem::file_size(path) == result.positions * sizeof(DatagenRecord));
+		CHECK(!std::filesystem::exists(path.string() + ".0"));
+		CHECK(log.str().find("pos/s") != std::string::npos);
+
+		std::ifstream file(path, std::ios::binary);
+		DatagenRecord record;
+		while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+			CHECK(record.result <= 2);
+			CHECK(!isMateScore(record.score));
+			Board b;
+			b.setToFen(record.fen().c_str());
+			CHECK(!b.moveGenerator.inCheck());
+			CHECK(DatagenRecord::pack(b, record.score).fen() == record.fen());
+		}
+		file.close();
+
+		// every thread searches on its own tt, cleared for each game, so a second run writes the same bytes
+		std::ifstream first(path, std::ios::binary);
+		std::string firstRun((std::istreambuf_iterator<char>(first)), std::istreambuf_iterator<char>());
+		first.close();
+		Datagen::run(path.string(), options, log);
+		std::ifstream second(path, std::ios::binary);
+		std::string secondRun((std::istreambuf_iterator<char>(second)), std::istreambuf_iterator<char>());
+		CHECK(firstRun == secondRun);
+		second.close();
+		std::filesystem::remove(path);
+	}
+	SUBCASE("A match plays every opening with both colors") {
+		Datagen::Options options;
+		options.games	= 5;
+		options.threads = 2;
+		options.nodes	= 300;
+		std::ostringstream log;
+
+		// without a net both sides are the same engine on tts of their own, so the second game of a pair repeats the first
+		// with the colors swapped
+		MatchResult result = Datagen::match(options, log);
+		CHECK(result.wins + result.draws + result.losses == 6);
+		CHECK(result.wins == result.losses);
+		CHECK(result.draws % 2 == 0);
+		CHECK(result.score() == 0.5);
+		CHECK(result.elo() == 0);
+		CHECK(log.str().find("elo 0") != std::string::npos);
+
+		NNUE::randomize(1);
+		MatchResult first  = Datagen::match(options, log);
+		MatchResult second = Datagen::match(options, log);
+		NNUE::unload();
+		CHECK(first.wins + first.draws + first.losses == 6);
+		CHECK(first.wins == second.wins);
+		CHECK(first.draws == second.draws);
+		CHECK(first.losses == second.losses);
+	}
+	SUBCASE("Match elo follows the score") {
+		CHECK(MatchResult{10, 0, 10, 0}.elo() == 0);
+		CHECK(MatchResult{3, 0, 1, 0}.elo() == doctest::Approx(190.85).epsilon(0.001));
+		CHECK(MatchResult{1, 0, 3, 0}.elo() == doctest::Approx(-190.85).epsilon(0.001));
+		CHECK(std::isinf(MatchResult{4, 0, 0, 0}.elo()));
+		CHECK(MatchResult{100, 0, 100, 0}.eloMargin() < MatchResult{10, 0, 10, 0}.eloMargin());
+	}
+}
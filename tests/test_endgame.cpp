@@ -0,0 +1,109 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/endgame.hpp"
+#include "../src/eval.hpp"
+
+#include <random>
+
+namespace {
+MaterialKey countMaterial(const Board& b) {
+	MaterialKey key = 0;
+	for (Color color : {WHITE, BLACK}) {
+		for (Piece piece : {KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN}) {
+			key += std::popcount(b.boardState.pieces[color][piece]) * materialKeyOf(color, piece);
+		}
+	}
+	return key;
+}
+} // namespace
+
+CUSTOM_TEST_CASE("Test Endgame") {
+	SUBCASE("Material keys follow captures and promotions") {
+		CHECK(materialKeyOf("KBNvK") == materialKeyOf(WHITE, KING) + materialKeyOf(WHITE, BISHOP) + materialKeyOf(WHITE, KNIGHT) +
+											materialKeyOf(BLACK, KING));
+		CHECK(swapMaterialColors(materialKeyOf("KBNvK")) == materialKeyOf("KvKBN"));
+
+		Board b;
+		CHECK(b.boardState.materialKey == materialKeyOf("KQRRBBNNPPPPPPPPvKQRRBBNNPPPPPPPP"));
+		std::mt19937 rng(7);
+		for (int game = 0; game < 20; game++) {
+			b.setToFen("r3k2r/1P1pqpb1/bn2pnp1/2pPN3/1p2P3/2N2Q1p/PPPBBPpP/R3K2R w KQkq c6 0 1");
+			for (int ply = 0; ply < 60; ply++) {
+				Moves moves = b.moveGenerator.genLegalMoves();
+				if (moves.empty()) break;
+				b.execute(moves[rng() % moves.size()]);
+				REQUIRE(b.boardState.materialKey == countMaterial(b));
+			}
+			while (true) {
+				b.undoMove();
+				REQUIRE(b.boardState.materialKey == countMaterial(b));
+				if (b.boardState.fmClock == 1 && b.boardState.sideToMove == WHITE) break;
+			}
+		}
+	}
+	SUBCASE("KPK bitbase") {
+		Board b;
+		b.setToFen("3k4/8/3K4/3P4/8/8/8/8 w - - 0 1");
+		CHECK(Eval::evaluate(b) > Endgame::KNOWN_WIN_SCORE);
+		b.setToFen("3k4/8/3K4/3P4/8/8/8/8 b - - 0 1");
+		CHECK(Eval::evaluate(b) < -Endgame::KNOWN_WIN_SCORE);
+
+		// the defender has the opposition
+		b.setToFen("8/4k3/8/4K3/4P3/8/8/8 w - - 0 1");
+		CHECK(Eval::evaluate(b) == DRAW_SCORE);
+		b.setToFen("8/4k3/8/4K3/4P3/8/8/8 b - - 0 1");
+		CHECK(Eval::evaluate(b) < -Endgame::KNOWN_WIN_SCORE);
+
+		// a rook pawn with the king in front of it, for both colors and on both wings
+		b.setToFen("k7/8/8/8/8/8/P7/K7 w - - 0 1");
+		CHECK(Eval::evaluate(b) == DRAW_SCORE);
+		b.setToFen("7k/7p/8/8/8/8/8/7K b - - 0 1");
+		CHECK(Eval::evaluate(b) == DRAW_SCORE);
+		CHECK(!Endgame::probeKPK(h1, h2, h8, WHITE));
+
+		// the pawn runs, the king is outside its square
+		b.setToFen("8/8/8/8/8/1k6/6p1/K7 b - - 0 1");
+		CHECK(Eval::evaluate(b) > Endgame::KNOWN_WIN_SCORE);
+	}
+	SUBCASE("The search resolves KPK at once") {
+		Board b;
+		b.setToFen("3k4/8/3K4/3P4/8/8/8/8 w - - 0 1");
+		Moves topLine;
+		Centipawns score = Eval::iterative_deepening_ply(topLine, b, 3);
+		CHECK(score > Endgame::KNOWN_WIN_SCORE);
+	}
+	SUBCASE("Mating material is pushed to the edge") {
+		Board b;
+		b.setToFen("8/8/8/4k3/8/8/8/R3K3 w - - 0 1");
+		Centipawns center = Eval::evaluate(b);
+		CHECK(center > Endgame::KNOWN_WIN_SCORE);
+		b.setToFen("4k3/8/8/8/8/8/8/R3K3 w - - 0 1");
+		CHECK(Eval::evaluate(b) > center);
+		b.setToFen("4k3/8/8/8/8/8/8/R3K3 b - - 0 1");
+		CHECK(Eval::evaluate(b) < -Endgame::KNOWN_WIN_SCORE);
+
+		// a dark squared bishop mates in a1 or h8
+		b.setToFen("8/8/8/8/8/8/8/k1B1NK2 w - - 0 1");
+		Centipawns rightCorner = Eval::evaluate(b);
+		b.setToFen("k7/8/8/8/8/8/8/2B1NK2 w - - 0 1");
+		CHECK(rightCorner > Eval::evaluate(b));
+		CHECK(Eval::evaluate(b) > Endgame::KNOWN_WIN_SCORE);
+	}
+	SUBCASE("Opposite colored bishops are drawish") {
+		Board b;
+		b.setToFen("8/4k3/8/3b4/8/3B4/4K1PP/8 w - - 0 1");
+		const Endgame::Entry* entry = Endgame::probe(b);
+		REQUIRE(entry);
+		CHECK(!entry->evaluate);
+		CHECK(entry->scale(b, WHITE) == Endgame::SCALE_NORMAL);
+
+		b.setToFen("8/4k3/8/4b3/8/3B4/4K1PP/8 w - - 0 1");
+		Centipawns opposite = Eval::evaluate(b);
+		CHECK(entry->scale(b, WHITE) < Endgame::SCALE_NORMAL);
+		b.setToFen("8/4k3/8/4n3/8/3B4/4K1PP/8 w - - 0 1");
+		CHECK(!Endgame::probe(b));
+		CHECK(Eval::evaluate(b) > opposite);
+	}
+}
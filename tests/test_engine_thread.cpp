@@ -0,0 +1,75 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/engine_thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+CUSTOM_TEST_CASE("Test EngineThread") {
+	SUBCASE("Search returns without blocking and resolves to a legal move") {
+		EngineThread engine;
+		Board b;
+		std::future<Move> bestMove = engine.search(b, TimeControl(), 5);
+		// the board passed in is copied, so it can change while the engine thinks
+		b.execute(Move(b, e2, e4, PAWN));
+		Move m = bestMove.get();
+		CHECK(!engine.searching());
+		b.undoMove();
+		Moves legalMoves = b.moveGenerator.genLegalMoves();
+		CHECK(std::find(legalMoves.begin(), legalMoves.end(), m) != legalMoves.end());
+
+		SearchInfo info;
+		REQUIRE(engine.latestIteration(info));
+		CHECK(info.depth == 5);
+		CHECK(info.pv[0] == m);
+	}
+	SUBCASE("Stop cuts a long search short") {
+		EngineThread engine;
+		Board b;
+		std::future<Move> bestMove = engine.search(b, TimeControl());
+		CHECK(engine.searching());
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		auto start = std::chrono::steady_clock::now();
+		engine.stop();
+		REQUIRE(bestMove.wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+		CHECK(bestMove.get().getPieceType() != NONE_PIECE);
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+	}
+	SUBCASE("Stop right after search doesnt wait for the first iteration") {
+		EngineThread engine;
+		Board b;
+		std::future<Move> bestMove = engine.search(b, TimeControl());
+		engine.stop();
+		REQUIRE(bestMove.wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+		CHECK(bestMove.get().getPieceType() != NONE_PIECE);
+	}
+	SUBCASE("Ponder search only keeps to its clock after ponderhit") {
+		EngineThread engine;
+		Board b;
+		TimeControl tc;
+		tc.moveTimeMs				= 50;
+		std::future<Move> bestMove = engine.search(b, tc, SearchContext::MAX_SEARCH_DEPTH, true);
+		CHECK(bestMove.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout);
+		engine.ponderhit();
+		REQUIRE(bestMove.wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+		CHECK(bestMove.get().getPieceType() != NONE_PIECE);
+		// the next search is a normal one again
+		CHECK(engine.search(b, tc).wait_for(std::chrono::milliseconds(500)) == std::future_status::ready);
+	}
+	SUBCASE("Listener hears every depth and the end of the search") {
+		struct CountingListener : SearchListener {
+			std::atomic<int> iterations = 0;
+			std::atomic<int> ends		= 0;
+			void onIteration(const SearchInfo&) override { iterations++; }
+			void onSearchEnd(const SearchInfo&) override { ends++; }
+		} counter;
+		EngineThread engine;
+		engine.listener = &counter;
+		Board b;
+		engine.search(b, TimeControl(), 4).get();
+		CHECK(counter.iterations == 4);
+		CHECK(counter.ends == 1);
+	}
+}
@@ -0,0 +1,131 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/epd.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+std::string san(const char* fen, const std::string& move) {
+	Board b;
+	b.setToFen(fen);
+	Move m = Epd::parseSan(b, move);
+	return m.getPieceType() == NONE_PIECE ? "none" : m.UCInotation();
+}
+} // namespace
+
+CUSTOM_TEST_CASE("Test Epd") {
+	SUBCASE("San moves") {
+		const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+		CHECK(san(start, "Nf3") == "g1f3");
+		CHECK(san(start, "e4") == "e2e4");
+		CHECK(san(start, "e5") == "none");
+		CHECK(san(start, "Ne2") == "none");
+
+		const char* castling = "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1";
+		CHECK(san(castling, "O-O") == "e1g1");
+		CHECK(san(castling, "0-0-0") == "e1c1");
+		CHECK(san(castling, "Kg1") == "none");
+
+		// both knights reach d2, both rooks a3
+		const char* knights = "4k3/8/8/R7/8/8/8/RN2KN2 w - - 0 1";
+		CHECK(san(knights, "Nd2") == "none");
+		CHECK(san(knights, "Nbd2") == "b1d2");
+		CHECK(san(knights, "Nfd2") == "f1d2");
+		CHECK(san(knights, "Ra3") == "none");
+		CHECK(san(knights, "R1a3") == "a1a3");
+		// capture marks and dashes are ignored, suites write them sloppily
+		CHECK(san(knights, "R5xa3") == "a5a3");
+		CHECK(san(knights, "Ra5-a3") == "a5a3");
+
+		const char* promotion = "r3k3/1P6/8/8/8/8/8/4K3 w - - 0 1";
+		CHECK(san(promotion, "b8=Q+") == "b7b8q");
+		CHECK(san(promotion, "b8N") == "b7b8n");
+		CHECK(san(promotion, "bxa8=R!") == "b7a8r");
+		CHECK(san(promotion, "b8") == "none");
+
+		CHECK(san("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", "exd5") == "e4d5");
+		CHECK(san("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1", "Rd8#") == "d1d8");
+	}
+	SUBCASE("Epd lines") {
+		EpdPosition position;
+		REQUIRE(Epd::parse("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - bm Rd8#; am h3 Kf1; id \"mate; in one\"; hmvc 7;", position));
+		CHECK(position.fen == "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 7 1");
+		CHECK(position.id == "mate; in one");
+		REQUIRE(position.bestMoves.size() == 1);
+		CHECK(position.bestMoves[0].UCInotation() == "d1d8");
+		CHECK(position.avoidMoves.size() == 2);
+		CHECK(position.solvedBy(position.bestMoves[0]));
+		CHECK(!position.solvedBy(position.avoidMoves[0]));
+
+		REQUIRE(Epd::parse("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - am Rd7", position));
+		CHECK(position.fen == "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+		CHECK(!position.solvedBy(position.avoidMoves[0]));
+
+		CHECK(!Epd::parse("", position));
+		CHECK(!Epd::parse("# a comment", position));
+		CHECK(!Epd::parse("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - bm Rd9;", position));
+		// malformed positions never reach setToFen
+		CHECK(!Epd::parse("6k1/5ppp/9/8/8/8/5PPP/3R2K1 w - - bm Rd8#;", position));
+		CHECK(!Epd::parse("6k1/5ppp/8/8/8/5PPP/3R2K1 w - - bm Rd8#;", position));
+		CHECK(!Epd::parse("8/5ppp/8/8/8/8/5PPP/3R2K1 w - - bm Rd8#;", position));
+		CHECK(!Epd::parse("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w X - bm Rd8#;", position));
+		CHECK(!Epd::parse("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - e5 bm Rd8#;", position));
+		// checkmated, nothing to search
+		CHECK(!Epd::parse("3R2k1/5ppp/8/8/8/8/5PPP/6K1 b - -", position));
+	}
+	SUBCASE("A run counts the solved positions") {
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "typhon_epd_test.epd";
+		std::ofstream(path) << "# back rank mates\n"
+							<< "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - bm Rd8#; id \"mate\";\n"
+							<< "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - am Rd7; id \"avoid\";\n"
+							<< "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - bm h3; id \"wrong\";\n"
+							<< "\n"
+							<< "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - bm Rd9; id \"typo\";\n";
+		Epd::Options options;
+		options.threads = 2;
+		options.nodes	= 20000;
+		std::ostringstream out;
+		EpdResult result = Epd::run(path.string(), options, out);
+
+		CHECK(result.positions == 3);
+		CHECK(result.solved == 2);
+		CHECK(result.skipped == 1);
+		CHECK(result.nodes > 0);
+		CHECK(out.str().find("line 6 skipped") != std::string::npos);
+		CHECK(out.str().find("mate: solved in") != std::string::npos);
+		CHECK(out.str().find("wrong: failed, bestmove d1d8") != std::string::npos);
+		CHECK(out.str().find("solved 2 of 3, skipped 1 lines") != std::string::npos);
+		std::filesystem::remove(path);
+
+		CHECK(Epd::run("/nonexistent/suite.epd", options, out).positions == 0);
+	}
+	SUBCASE("A position doesnt depend on the ones searched before it") {
+		const char* lines[] = {
+			"r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - bm Qxh7+; id \"a\";\n",
+			"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - am Bxf6; id \"b\";\n",
+		};
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "typhon_epd_order.epd";
+		Epd::Options options;
+		options.nodes = 5000;
+		std::string outputs[2];
+		for (int order = 0; order < 2; order++) {
+			std::ofstream(path) << lines[order] << lines[1 - order];
+			std::ostringstream out;
+			Epd::run(path.string(), options, out);
+			std::istringstream report(out.str());
+			std::string first, second;
+			std::getline(report, first);
+			std::getline(report, second);
+			// time to solution varies, the moves dont
+			auto move = [](const std::string& line) { return line.substr(0, 1) + line.substr(line.find("bestmove")); };
+			outputs[order] = order ? move(second) + move(first) : move(first) + move(second);
+		}
+		CHECK(outputs[0] == outputs[1]);
+		std::filesystem::remove(path);
+	}
+}
@@ -4,6 +4,8 @@
 #include "../src/board.hpp"
 #include "../src/eval.hpp"
 
+#include <algorithm>
+
 CUSTOM_TEST_CASE("Test Material") {
 	SUBCASE("Test captures and promotion for white") {
 		Board b;
@@ -68,4 +70,183 @@ CUSTOM_TEST_CASE("Test evaluate") {
 		Centipawns score = Eval::evaluate(b);
 		CHECK(score < -800);
 	}
+	SUBCASE("Kings belong in the center once the pieces are off") {
+		Board centralized, cornered;
+		centralized.setToFen("8/5k2/8/8/3K4/8/4P3/8 w - - 0 1");
+		cornered.setToFen("8/5k2/8/8/8/8/4P3/K7 w - - 0 1");
+		CHECK(centralized.boardState.phase == 0);
+		CHECK(Eval::evaluate(centralized) > Eval::evaluate(cornered) + 50);
+	}
+	SUBCASE("Pieces aimed at the king count for more than the same pieces elsewhere") {
+		Board attacking, elsewhere;
+		attacking.setToFen("rnb2rk1/ppp2ppp/8/6NQ/8/3B4/PPP2PPP/RN3RK1 w - - 0 1");
+		elsewhere.setToFen("rnb2rk1/ppp2ppp/8/QN6/8/B7/PPP2PPP/RN3RK1 w - - 0 1");
+		CHECK(Eval::evaluate(attacking) > Eval::evaluate(elsewhere) + 40);
+	}
+	SUBCASE("Pushing the pawns in front of the castled king weakens it") {
+		Board sheltered, pushed;
+		sheltered.setToFen("r1bq1rk1/pppp1ppp/2n2n2/2b1p3/2B1P3/2N2N2/PPPP1PPP/R1BQ1RK1 w - - 0 1");
+		pushed.setToFen("r1bq1rk1/pppp1ppp/2n2n2/2b1p3/2B1P1PP/2N2N2/PPPP1P2/R1BQ1RK1 w - - 0 1");
+		CHECK(Eval::evaluate(sheltered) > Eval::evaluate(pushed) + 30);
+	}
+	SUBCASE("Mirrored positions evaluate the same") {
+		Board b, mirrored;
+		b.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		mirrored.setToFen("r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq - 0 1");
+		CHECK(Eval::evaluate(b) == Eval::evaluate(mirrored));
+	}
+	SUBCASE("Lazy evaluation only exits far outside the window") {
+		SearchContext ctx;
+		Board b;
+		b.setToFen("r1bk1bnr/p1p2ppp/1pnp4/1B2p3/4P2q/P1N2N1P/1PPP1PP1/R1BQK2R w KQ - 0 7");
+		CHECK(Eval::evaluate(ctx, b, -50, 50) == Eval::evaluate(b));
+		CHECK(ctx.lazyEvals == 0);
+		b.setToFen("r2k1bnr/p1p2ppp/1pbp4/4p3/4P2N/P1N4P/1PPP1PP1/R1BQK2R w KQ - 0 9");
+		Centipawns lazy = Eval::evaluate(ctx, b, -50, 50);
+		CHECK(ctx.lazyEvals == 1);
+		CHECK(lazy > 50);
+		CHECK(abs(lazy - Eval::evaluate(b)) < 320);
+	}
+	SUBCASE("Taper blends by phase") {
+		CHECK(Eval::taper(100, 20, EvalParams::MAX_PHASE) == 100);
+		CHECK(Eval::taper(100, 20, 0) == 20);
+		CHECK(Eval::taper(100, 20, EvalParams::MAX_PHASE / 2) == 60);
+		// promotions can push the phase past MAX_PHASE
+		CHECK(Eval::taper(100, 20, EvalParams::MAX_PHASE + 4) == 100);
+	}
+}
+
+CUSTOM_TEST_CASE("Test staticExchangeEvaluation") {
+	SUBCASE("Undefended pawn") {
+		Board b;
+		b.setToFen("4k3/8/8/p7/8/8/8/R3K3 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, a1, a5, ROOK)) == 100);
+	}
+	SUBCASE("Queen takes pawn defended by pawn") {
+		Board b;
+		b.setToFen("4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, e2, e5, QUEEN)) == -800);
+	}
+	SUBCASE("Pawn takes defended knight") {
+		Board b;
+		b.setToFen("4k3/8/3p4/4n3/3P4/8/8/4K3 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, d4, e5, PAWN)) == 200);
+	}
+	SUBCASE("Rook takes pawn defended by rook") {
+		Board b;
+		b.setToFen("4r1k1/8/8/4p3/8/8/4R3/6K1 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, e2, e5, ROOK)) == -400);
+	}
+	SUBCASE("X-ray rook behind the capturing rook") {
+		Board b;
+		b.setToFen("4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, e2, e5, ROOK)) == 100);
+	}
+	SUBCASE("X-ray queen behind the capturing bishop") {
+		Board b;
+		b.setToFen("6k1/5b2/4p3/8/8/1B6/Q7/6K1 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, b3, e6, BISHOP)) == 100);
+	}
+	SUBCASE("King recaptures an undefended piece") {
+		Board b;
+		b.setToFen("8/8/8/3k4/4p3/8/6B1/4K3 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, g2, e4, BISHOP)) == -210);
+	}
+	SUBCASE("King cant recapture a defended piece") {
+		Board b;
+		b.setToFen("8/8/8/3k4/4p3/8/6B1/1Q2K3 w - - 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, g2, e4, BISHOP)) == 100);
+	}
+	SUBCASE("En passant") {
+		Board b;
+		b.setToFen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+		CHECK(Eval::staticExchangeEvaluation(b, Move(b, e5, d6, PAWN)) == 100);
+	}
+}
+
+CUSTOM_TEST_CASE("Test quiescence_search") {
+	SUBCASE("Wins a hanging queen") {
+		Board b;
+		b.setToFen("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1");
+		CHECK(Eval::quiescence_search(b, -INF_SCORE, INF_SCORE) > 400);
+	}
+	SUBCASE("Doesnt win a defended pawn with the queen") {
+		Board b;
+		b.setToFen("4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1");
+		CHECK(Eval::quiescence_search(b, -INF_SCORE, INF_SCORE) == Eval::evaluate(b));
+	}
+	SUBCASE("Hopeless positions fail low on stand pat") {
+		Board b;
+		b.setToFen("4k3/8/8/2qq4/8/8/8/4K2p w - - 0 1");
+		Centipawns standPat = Eval::evaluate(b);
+		SearchContext ctx;
+		CHECK(Eval::quiescence_search(ctx, b, standPat + 1500, standPat + 1600) <= standPat + 1500);
+		CHECK(ctx.qnodes == 1);
+	}
+}
+
+CUSTOM_TEST_CASE("Test search") {
+	SUBCASE("Finds back rank mate") {
+		Board b;
+		b.setToFen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+		Moves topLine;
+		Centipawns score = Eval::iterative_deepening_ply(topLine, b, 4);
+		REQUIRE(!topLine.empty());
+		CHECK(topLine[0] == Move(b, d1, d8, ROOK));
+		CHECK(isMateScore(score));
+	}
+	SUBCASE("Doesnt grab a poisoned pawn") {
+		Board b;
+		b.setToFen("4k3/8/3p4/4p3/8/8/4Q3/4K3 w - - 0 1");
+		Moves topLine;
+		Eval::iterative_deepening_ply(topLine, b, 5);
+		REQUIRE(!topLine.empty());
+		CHECK(topLine[0] != Move(b, e2, e5, QUEEN));
+	}
+	SUBCASE("Scores a repeated position as a draw") {
+		Board b;
+		b.setToFen("4k3/8/8/8/8/8/8/QN2K3 w - - 0 1");
+		b.execute(Move(b, b1, c3, KNIGHT));
+		b.execute(Move(b, e8, d8, KING));
+		b.execute(Move(b, c3, b1, KNIGHT));
+		b.execute(Move(b, d8, e8, KING));
+		Moves topLine, previousPV;
+		CHECK(Eval::search(topLine, b, 3, previousPV, -INF_SCORE, INF_SCORE, 1).score == DRAW_SCORE);
+		CHECK(Eval::search(topLine, b, 3, previousPV).score > 0);
+	}
+}
+CUSTOM_TEST_CASE("Test iterative_deepening_multipv") {
+	SUBCASE("Lines are legal, distinct and sorted") {
+		Board b;
+		SearchContext ctx;
+		std::vector<PVLine> lines = Eval::iterative_deepening_multipv(ctx, b, 3, TimeControl(), 5);
+		REQUIRE(lines.size() == 3);
+		Moves legalMoves = b.moveGenerator.genLegalMoves();
+		for (size_t i = 0; i < lines.size(); i++) {
+			CHECK(lines[i].depth == 5);
+			CHECK(lines[i].pv[0] == lines[i].move);
+			CHECK(std::find(legalMoves.begin(), legalMoves.end(), lines[i].move) != legalMoves.end());
+			for (size_t j = 0; j < i; j++) {
+				CHECK(lines[j].move != lines[i].move);
+				CHECK(lines[j].score >= lines[i].score);
+			}
+		}
+		CHECK(ctx.excludedRootMoves.empty());
+	}
+	SUBCASE("Best line matches the mate and the rest dont") {
+		Board b;
+		b.setToFen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+		SearchContext ctx;
+		std::vector<PVLine> lines = Eval::iterative_deepening_multipv(ctx, b, 2, TimeControl(), 4);
+		REQUIRE(lines.size() == 2);
+		CHECK(lines[0].move == Move(b, d1, d8, ROOK));
+		CHECK(isMateScore(lines[0].score));
+		CHECK(!isMateScore(lines[1].score));
+	}
+	SUBCASE("Never returns more lines than there are legal moves") {
+		Board b;
+		b.setToFen("k7/8/8/8/8/8/7P/7K w - - 0 1");
+		SearchContext ctx;
+		CHECK(Eval::iterative_deepening_multipv(ctx, b, 6, TimeControl(), 3).size() == 4);
+	}
 }
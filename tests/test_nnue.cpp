@@ -0,0 +1,140 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/nnue.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+/**
+* @brief walks every line to the given depth, checking at each node that the incrementally updated accumulator
+* matches one computed from scratch, both after execute and after undoMove
+*/
+static void checkAccumulators(Board& b, int depth, int& checked) {
+	NNUE::Accumulator fresh;
+	NNUE::refresh(b.boardState.pieces, fresh);
+	REQUIRE(b.accumulator());
+	CHECK(b.accumulator()->values == fresh.values);
+	checked++;
+	if (depth == 0) return;
+	for (const Move& m : b.moveGenerator.genLegalMoves()) {
+		b.execute(m);
+		checkAccumulators(b, depth - 1, checked);
+		b.undoMove();
+		CHECK(b.accumulator()->values == fresh.values);
+	}
+}
+
+CUSTOM_TEST_CASE("Test NNUE") {
+	Board afterE4;
+	afterE4.execute(Move(afterE4, e2, e4, PAWN));
+	Centipawns handcrafted = Eval::evaluate(afterE4);
+	NNUE::randomize(1);
+
+	SUBCASE("Incremental updates match a full refresh") {
+		// castling both ways, en passant, promotions with and without capture, and king moves
+		const char* fens[] = {
+			"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+			"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+			"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+			"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+		};
+		for (const char* fen : fens) {
+			Board b;
+			b.setToFen(fen);
+			int checked = 0;
+			checkAccumulators(b, 3, checked);
+			CHECK(checked > 100);
+		}
+	}
+	SUBCASE("Pending updates of several moves are applied together") {
+		Board b;
+		b.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		b.execute(Move(b, e1, g1, KING));
+		b.execute(Move(b, h3, g2, PAWN));
+		b.execute(Move(b, e5, f7, KNIGHT));
+		b.execute(Move(b, g2, f1, PAWN, QUEEN));
+		NNUE::Accumulator fresh;
+		NNUE::refresh(b.boardState.pieces, fresh);
+		CHECK(b.accumulator()->values == fresh.values);
+		b.undoMove();
+		b.undoMove();
+		NNUE::refresh(b.boardState.pieces, fresh);
+		CHECK(b.accumulator()->values == fresh.values);
+	}
+	SUBCASE("A net loaded mid game still undoes past where it was loaded") {
+		NNUE::unload();
+		Board b;
+		b.execute(Move(b, e2, e4, PAWN));
+		b.execute(Move(b, d7, d5, PAWN));
+		NNUE::randomize(1);
+		b.refreshAccumulator();
+		b.undoMove();
+		b.undoMove();
+		NNUE::Accumulator fresh;
+		NNUE::refresh(b.boardState.pieces, fresh);
+		REQUIRE(b.accumulator());
+		CHECK(b.accumulator()->values == fresh.values);
+	}
+	SUBCASE("Mirrored positions evaluate the same") {
+		Board b, mirrored;
+		b.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		mirrored.setToFen("r3k2r/pppbbppp/2n2q1P/1P2p3/3pn3/BN2PNP1/P1PPQPB1/R3K2R b KQkq - 0 1");
+		CHECK(Eval::evaluate(b) == Eval::evaluate(mirrored));
+		b.setToFen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+		mirrored.setToFen("rnbqkbnr/pppp1ppp/8/8/3PpP2/8/PPP1P1PP/RNBQKBNR b KQkq f3 0 3");
+		CHECK(Eval::evaluate(b) == Eval::evaluate(mirrored));
+	}
+	SUBCASE("Copies carry the current accumulator") {
+		Board b;
+		b.execute(Move(b, e2, e4, PAWN));
+		Board copy = b;
+		REQUIRE(copy.accumulator());
+		CHECK(copy.accumulator()->values == b.accumulator()->values);
+		copy.execute(Move(copy, e7, e5, PAWN));
+		NNUE::Accumulator fresh;
+		NNUE::refresh(copy.boardState.pieces, fresh);
+		CHECK(copy.accumulator()->values == fresh.values);
+	}
+	SUBCASE("Loading a net file") {
+		std::filesystem::path path = std::filesystem::temp_directory_path() / "typhon_test.nnue";
+		// all zero weights and an output bias worth exactly one EVAL_SCALE, so every position evaluates to EVAL_SCALE
+		{
+			std::ofstream file(path, std::ios::binary);
+			uint32_t version = NNUE::NET_VERSION, hidden = NNUE::HIDDEN_SIZE;
+			int32_t outputBias = NNUE::QA * NNUE::QB;
+			std::vector<char> zeros(sizeof(int16_t) * (NNUE::INPUT_SIZE + 3) * NNUE::HIDDEN_SIZE);
+			file.write("TYPHNNUE", 8);
+			file.write(reinterpret_cast<char*>(&version), sizeof(version));
+			file.write(reinterpret_cast<char*>(&hidden), sizeof(hidden));
+			file.write(zeros.data(), zeros.size());
+			file.write(reinterpret_cast<char*>(&outputBias), sizeof(outputBias));
+		}
+		REQUIRE(NNUE::load(path.string()));
+		Board b;
+		CHECK(Eval::evaluate(b) == NNUE::EVAL_SCALE);
+
+		// a truncated file is rejected and the loaded net stays
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+		CHECK(!NNUE::load(path.string()));
+		CHECK(NNUE::isLoaded());
+		CHECK(Eval::evaluate(b) == NNUE::EVAL_SCALE);
+		std::filesystem::remove(path);
+
+		CHECK(!NNUE::load("does/not/exist.nnue"));
+	}
+	SUBCASE("Without a net the handcrafted evaluation is used") {
+		NNUE::unload();
+		Board b;
+		CHECK(!b.accumulator());
+		b.execute(Move(b, e2, e4, PAWN));
+		CHECK(!b.accumulator());
+		CHECK(Eval::evaluate(b) == handcrafted);
+	}
+
+	NNUE::unload();
+}
@@ -0,0 +1,153 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/search_context.hpp"
+#include "../src/transposition_table.hpp"
+
+#include <algorithm>
+#include <thread>
+
+CUSTOM_TEST_CASE("Test SearchContext") {
+	SUBCASE("Killers shift down and arent duplicated") {
+		SearchContext ctx;
+		Move m1(e2, e4, PAWN, NONE_PIECE, NORMAL_MOVE);
+		Move m2(d2, d4, PAWN, NONE_PIECE, NORMAL_MOVE);
+		ctx.storeKiller(3, m1);
+		ctx.storeKiller(3, m1);
+		CHECK(ctx.killerMoves[3][0] == m1);
+		CHECK(ctx.killerMoves[3][1] == Move());
+		ctx.storeKiller(3, m2);
+		CHECK(ctx.killerMoves[3][0] == m2);
+		CHECK(ctx.killerMoves[3][1] == m1);
+	}
+	SUBCASE("History scores stay below bad captures") {
+		SearchContext ctx;
+		Move good(g1, f3, KNIGHT, NONE_PIECE, NORMAL_MOVE);
+		Move bad(g1, h3, KNIGHT, NONE_PIECE, NORMAL_MOVE);
+		for (int i = 0; i < 1000; i++) {
+			ctx.updateHistory(WHITE, good, &bad, 1, 20);
+		}
+		CHECK(ctx.historyScore(WHITE, good) > ctx.historyScore(WHITE, bad));
+		CHECK(ctx.historyScore(WHITE, good) <= 0);
+		CHECK(ctx.historyScore(WHITE, good) < BAD_CAPTURE_SCORE);
+		CHECK(ctx.historyScore(WHITE, bad) >= -2 * SearchContext::MAX_HISTORY);
+		CHECK(ctx.historyScore(BLACK, good) == ctx.historyScore(BLACK, bad));
+		ctx.reset();
+		CHECK(ctx.historyScore(WHITE, good) == ctx.historyScore(WHITE, bad));
+	}
+	SUBCASE("Stopped context aborts the search") {
+		SearchContext ctx;
+		Board b;
+		ctx.startSearch();
+		ctx.stop();
+		CHECK(Eval::search(ctx, b, 4).state == SEARCH_ABORTED);
+		ctx.startSearch();
+		CHECK(Eval::search(ctx, b, 2).state == SEARCH_COMPLETE);
+	}
+	SUBCASE("Prepared search keeps a stop that came before startSearch") {
+		SearchContext ctx;
+		ctx.stop();
+		ctx.startSearch();
+		CHECK(!ctx.stopped());
+		ctx.prepareSearch();
+		CHECK(!ctx.stopped());
+		ctx.stop();
+		ctx.startSearch();
+		CHECK(ctx.stopped());
+		// only the one search that was prepared keeps it
+		ctx.startSearch();
+		CHECK(!ctx.stopped());
+	}
+	SUBCASE("Time limited search stops close to the limit") {
+		SearchContext ctx;
+		Board b;
+		Moves topLine;
+		auto start = SearchContext::Clock::now();
+		Eval::iterative_deepening_time(ctx, topLine, b, 100);
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(SearchContext::Clock::now() - start).count();
+		CHECK(elapsedMs < 300);
+		CHECK(!topLine.empty());
+	}
+	SUBCASE("Node limited search stops on exactly the node limit") {
+		SearchContext ctx;
+		Board b;
+		b.setToFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		Moves topLine;
+		Eval::iterative_deepening_nodes(ctx, topLine, b, 5000);
+		CHECK(ctx.nodes + ctx.qnodes == 5000);
+		CHECK(ctx.nodeLimit == 0);
+		CHECK(!topLine.empty());
+	}
+	SUBCASE("Deterministic searches repeat exactly") {
+		Board b;
+		b.setToFen("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+		Moves lines[2];
+		Centipawns scores[2];
+		uint64_t nodes[2];
+		for (int i = 0; i < 2; i++) {
+			TranspositionTable::shared().reset();
+			SearchContext ctx;
+			ctx.deterministic = true;
+			ctx.nodeLimit	  = 20000;
+			scores[i]		  = Eval::iterative_deepening(ctx, lines[i], b, TimeControl(), SearchContext::MAX_SEARCH_DEPTH);
+			nodes[i]		  = ctx.nodes + ctx.qnodes;
+		}
+		CHECK(nodes[0] == 20000);
+		CHECK(nodes[1] == nodes[0]);
+		CHECK(scores[1] == scores[0]);
+		CHECK(lines[1] == lines[0]);
+	}
+	SUBCASE("Deterministic searches still keep to a clock") {
+		Board b;
+		b.setToFen("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10");
+		SearchContext ctx;
+		ctx.deterministic = true;
+		TimeControl tc;
+		tc.moveTimeMs = 50;
+		Moves topLine;
+		auto start = std::chrono::steady_clock::now();
+		Eval::iterative_deepening(ctx, topLine, b, tc, SearchContext::MAX_SEARCH_DEPTH);
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+		CHECK(!topLine.empty());
+	}
+	SUBCASE("Clock only starts running on ponderhit") {
+		SearchContext ctx;
+		ctx.setPondering(true);
+		ctx.startSearch(10);
+		std::this_thread::sleep_for(std::chrono::milliseconds(30));
+		CHECK(!ctx.checkTime());
+		CHECK(ctx.clockElapsedMs() == 0);
+		ctx.ponderhit();
+		CHECK(!ctx.checkTime());
+		std::this_thread::sleep_for(std::chrono::milliseconds(30));
+		CHECK(ctx.checkTime());
+	}
+	SUBCASE("Separate contexts dont share counters") {
+		SearchContext a, c;
+		Board b;
+		Moves topLine;
+		Eval::iterative_deepening_ply(a, topLine, b, 3);
+		CHECK(a.nodes > 0);
+		CHECK(c.nodes == 0);
+		CHECK(c.killerMoves[0][0] == Move());
+	}
+	SUBCASE("PV reaches the full search depth and is legal") {
+		for (const char* fen : {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+								"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+								"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"}) {
+			SearchContext ctx;
+			Board b;
+			b.setToFen(fen);
+			Moves topLine;
+			Eval::iterative_deepening_ply(ctx, topLine, b, 6);
+			CHECK(topLine.size() >= 6);
+			for (const Move& m : topLine) {
+				Moves legalMoves = b.moveGenerator.genLegalMoves();
+				REQUIRE(std::find(legalMoves.begin(), legalMoves.end(), m) != legalMoves.end());
+				b.execute(m);
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/search_listener.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+CUSTOM_TEST_CASE("Test SearchListener") {
+	SUBCASE("Uci listener writes one info line per iteration") {
+		std::ostringstream out;
+		UciSearchListener listener(out);
+		SearchContext ctx;
+		ctx.listener = &listener;
+		Board b;
+		Moves topLine;
+		Eval::iterative_deepening_ply(ctx, topLine, b, 3);
+		std::string output = out.str();
+		CHECK(output.find("info depth 1 seldepth ") == 0);
+		CHECK(output.find("info depth 3 seldepth ") != std::string::npos);
+		CHECK(output.find(" hashfull ") != std::string::npos);
+		CHECK(output.find(" pv " + topLine[0].UCInotation()) != std::string::npos);
+		CHECK(std::count(output.begin(), output.end(), '\n') == 3);
+	}
+	SUBCASE("Json listener writes iterations and the end of the search") {
+		std::ostringstream out;
+		JsonSearchListener listener(out);
+		SearchContext ctx;
+		ctx.listener = &listener;
+		Board b;
+		b.setToFen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+		Moves topLine;
+		Eval::iterative_deepening_ply(ctx, topLine, b, 4);
+		std::string output = out.str();
+		CHECK(output.find("{\"type\":\"iteration\",\"depth\":1,") == 0);
+		CHECK(output.find("{\"type\":\"end\",") != std::string::npos);
+		CHECK(output.find("\"mate\":1") != std::string::npos);
+		CHECK(output.find("\"pv\":[\"d1d8\"") != std::string::npos);
+	}
+	SUBCASE("Formats a known info exactly") {
+		SearchInfo info = {4, 9, 35, 1000, 5000, 12, 200, {}, false};
+		std::string line = UciSearchListener::formatInfo(info);
+		CHECK(line == "info depth 4 seldepth 9 multipv 1 score cp 35 nodes 1000 nps 5000 hashfull 12 tbhits 0 time 200 pv");
+		CHECK(JsonSearchListener::formatJson("iteration", info) ==
+			  "{\"type\":\"iteration\",\"depth\":4,\"seldepth\":9,\"multipv\":1,\"cp\":35,\"nodes\":1000,\"nps\":5000,\"hashfull\":12,\"tbhits\":0,\"time\":200,\"partial\":false,\"pv\":[]}");
+	}
+}
@@ -0,0 +1,166 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/syzygy.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+/**
+* @brief writes a KRvK table holding a single value per side to move, padded to a valid table size. the piece bytes are in file
+* order, K R k, white in the low nibble and black in the high one
+*/
+void writeTable(const std::filesystem::path& path, std::vector<uint8_t> magic, std::vector<uint8_t> subTables, size_t size = 80) {
+	std::vector<uint8_t> data = magic;
+	data.insert(data.end(), {0x01, 0x00, 0x66, 0x44, 0xEE, 0x00});
+	data.insert(data.end(), subTables.begin(), subTables.end());
+	data.resize(size);
+	std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+/**
+* @brief a KRvK set where white to move always wins and black to move always loses, the win 15 plies from its zeroing move
+*/
+std::filesystem::path writeKRvK() {
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "typhon_syzygy_test";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	// values are stored as wdl + 2, dtz wins in moves as (plies - 1) / 2
+	writeTable(dir / "KRvK.rtbw", {0x71, 0xE8, 0x23, 0x5D}, {0x80, 4, 0x80, 0});
+	writeTable(dir / "KRvK.rtbz", {0xD7, 0x66, 0x0C, 0xA5}, {0x80, 7});
+	return dir;
+}
+} // namespace
+
+CUSTOM_TEST_CASE("Test Syzygy") {
+	std::filesystem::path dir = writeKRvK();
+	REQUIRE(Syzygy::init(dir.string()) == 1);
+	CHECK(Syzygy::largest() == 3);
+
+	SUBCASE("Tables are found by material and probed for both sides") {
+		Board b;
+		b.setToFen("8/8/8/4k3/8/8/8/R3K3 w - - 0 1");
+		CHECK(Syzygy::canProbe(b));
+		CHECK(Syzygy::materialKey(b) != Syzygy::materialKey(b, true));
+
+		Syzygy::ProbeState state;
+		CHECK(Syzygy::probeWDL(b, state) == Syzygy::WDL_WIN);
+		CHECK(state == Syzygy::PROBE_OK);
+		CHECK(Syzygy::probeDTZ(b, state) == 15);
+
+		// the dtz table only stores white to move, so black gets it through a 1 ply search
+		b.setToFen("8/8/8/4k3/8/8/8/R3K3 b - - 0 1");
+		CHECK(Syzygy::probeWDL(b, state) == Syzygy::WDL_LOSS);
+		CHECK(Syzygy::probeDTZ(b, state) == -16);
+
+		// the colors swapped find the same table
+		b.setToFen("r3k3/8/8/8/4K3/8/8/8 b - - 0 1");
+		CHECK(Syzygy::probeWDL(b, state) == Syzygy::WDL_WIN);
+		CHECK(state == Syzygy::PROBE_OK);
+	}
+	SUBCASE("A capture in reach overrides the stored value") {
+		Board b;
+		b.setToFen("8/8/8/8/8/2k5/1R6/4K3 b - - 0 1");
+		Syzygy::ProbeState state;
+		CHECK(Syzygy::probeWDL(b, state) == Syzygy::WDL_DRAW);
+		CHECK(state == Syzygy::PROBE_OK);
+	}
+	SUBCASE("Positions without a table fail") {
+		Board b;
+		b.setToFen("8/8/8/4k3/8/8/8/Q3K3 w - - 0 1");
+		Syzygy::ProbeState state;
+		Syzygy::probeWDL(b, state);
+		CHECK(state == Syzygy::PROBE_FAIL);
+
+		b.setToFen("r3k3/8/8/8/8/8/8/R3K3 w Q - 0 1");
+		CHECK(!Syzygy::canProbe(b));
+	}
+	SUBCASE("Root moves keep the win") {
+		Board b;
+		b.setToFen("8/8/8/8/8/2k5/8/1R2K3 w - - 0 1");
+		Moves moves;
+		REQUIRE(Syzygy::rootMoves(b, moves));
+		CHECK(!moves.empty());
+		CHECK(moves.size() < b.moveGenerator.genLegalMoves().size());
+		for (const Move& m : moves) {
+			CHECK(m.UCInotation() != "b1b2");
+			CHECK(m.UCInotation() != "b1b3");
+			CHECK(m.UCInotation() != "b1b4");
+		}
+	}
+	SUBCASE("The search leaves a set that fails its self check alone") {
+		// the single value KRvK table puts every win 15 plies from its zeroing move, mates in one included
+		CHECK(!Syzygy::verified());
+		CHECK(Syzygy::verifyFailure().rfind("KRvK misses the mate in one", 0) == 0);
+
+		Board b;
+		b.setToFen("8/8/8/8/8/2k5/8/1R2K3 w - - 0 1");
+		SearchContext ctx;
+		Moves topLine;
+		Eval::iterative_deepening_ply(ctx, topLine, b, 4);
+		CHECK(!topLine.empty());
+		CHECK(ctx.tbHits == 0);
+	}
+	SUBCASE("Real tables agree with known results") {
+		// the published KQvK, KRvK and KPvK files are too large to keep in the repository, point TYPHON_SYZYGY_PATH at them
+		const char* path = std::getenv("TYPHON_SYZYGY_PATH");
+		if (!path) {
+			MESSAGE("TYPHON_SYZYGY_PATH isnt set, real tables not checked");
+			return;
+		}
+		REQUIRE(Syzygy::init(path) > 0);
+		CHECK(Syzygy::verifyFailure() == "");
+		CHECK(Syzygy::verified());
+
+		Board b;
+		b.setToFen("8/8/8/8/8/2k5/8/1R2K3 w - - 0 1");
+		Moves rootMoves;
+		REQUIRE(Syzygy::rootMoves(b, rootMoves));
+		SearchContext ctx;
+		Moves topLine;
+		Eval::iterative_deepening_ply(ctx, topLine, b, 4);
+		REQUIRE(!topLine.empty());
+		CHECK(ctx.tbHits > 0);
+		CHECK(std::find(rootMoves.begin(), rootMoves.end(), topLine[0]) != rootMoves.end());
+	}
+	SUBCASE("A set without any of the checked tables isnt trusted") {
+		std::filesystem::path other = dir / "other";
+		std::filesystem::create_directories(other);
+		std::filesystem::copy_file(dir / "KRvK.rtbw", other / "KNvK.rtbw");
+		REQUIRE(Syzygy::init(other.string()) == 1);
+		CHECK(!Syzygy::verified());
+		CHECK(Syzygy::verifyFailure() == "no KQvK, KRvK or KPvK table to check the set against");
+	}
+	SUBCASE("Broken files are skipped") {
+		writeTable(dir / "KQvK.rtbw", {0x00, 0x00, 0x00, 0x00}, {0x80, 4, 0x80, 0});
+		writeTable(dir / "KBvK.rtbw", {0x71, 0xE8, 0x23, 0x5D}, {0x80, 4, 0x80, 0}, 81);
+		CHECK(Syzygy::init(dir.string()) == 3);
+
+		Board b;
+		Syzygy::ProbeState state;
+		b.setToFen("8/8/8/4k3/8/8/8/Q3K3 w - - 0 1");
+		Syzygy::probeWDL(b, state);
+		CHECK(state == Syzygy::PROBE_FAIL);
+		b.setToFen("8/8/8/4k3/8/8/8/B3K3 w - - 0 1");
+		Syzygy::probeWDL(b, state);
+		CHECK(state == Syzygy::PROBE_FAIL);
+	}
+	SUBCASE("An empty path drops every table") {
+		CHECK(Syzygy::init("") == 0);
+		CHECK(Syzygy::largest() == 0);
+		Board b;
+		b.setToFen("8/8/8/4k3/8/8/8/R3K3 w - - 0 1");
+		CHECK(!Syzygy::canProbe(b));
+	}
+
+	Syzygy::clear();
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,94 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/time_manager.hpp"
+
+CUSTOM_TEST_CASE("Test TimeManager") {
+	Move kingPawn(e2, e4, PAWN, NONE_PIECE, NORMAL_MOVE);
+	Move queenPawn(d2, d4, PAWN, NONE_PIECE, NORMAL_MOVE);
+
+	SUBCASE("Fixed move time is used up and never scaled") {
+		TimeManager tm;
+		TimeControl tc;
+		tc.moveTimeMs = 1000;
+		tm.start(tc);
+		CHECK(tm.hardLimitMs() == 1000 - TimeManager::MOVE_OVERHEAD_MS);
+		CHECK(tm.softLimitMs() == tm.hardLimitMs());
+		for (int i = 0; i < 6; i++) tm.onIterationComplete(kingPawn, 20);
+		CHECK(tm.softLimitMs() == tm.hardLimitMs());
+	}
+	SUBCASE("No clock means no limits") {
+		TimeManager tm;
+		tm.start(TimeControl());
+		CHECK(tm.hardLimitMs() < 0);
+		CHECK(tm.shouldStartIteration(1000000));
+	}
+	SUBCASE("Clock is split over the remaining moves") {
+		TimeManager tm;
+		TimeControl tc;
+		tc.remainingMs = 60000;
+		tm.start(tc);
+		CHECK(tm.softLimitMs() == (60000 - TimeManager::MOVE_OVERHEAD_MS) / TimeManager::DEFAULT_MOVES_TO_GO);
+		CHECK(tm.hardLimitMs() == tm.softLimitMs() * TimeManager::HARD_LIMIT_SCALE);
+
+		tc.movesToGo = 10;
+		tm.start(tc);
+		CHECK(tm.softLimitMs() == (60000 - TimeManager::MOVE_OVERHEAD_MS) / 10);
+
+		tc.movesToGo   = 0;
+		tc.incrementMs = 2000;
+		tm.start(tc);
+		CHECK(tm.softLimitMs() == (60000 - TimeManager::MOVE_OVERHEAD_MS) / TimeManager::DEFAULT_MOVES_TO_GO + 1500);
+	}
+	SUBCASE("Never plans past the clock") {
+		TimeManager tm;
+		TimeControl tc;
+		tc.remainingMs = 200;
+		tc.incrementMs = 5000;
+		tc.movesToGo   = 1;
+		tm.start(tc);
+		CHECK(tm.hardLimitMs() <= 200 - TimeManager::MOVE_OVERHEAD_MS);
+		CHECK(tm.softLimitMs() <= tm.hardLimitMs());
+		CHECK(tm.softLimitMs() >= 1);
+	}
+	SUBCASE("Stable best move shrinks the soft limit, changing best move grows it") {
+		TimeManager tm;
+		TimeControl tc;
+		tc.remainingMs = 60000;
+		tm.start(tc);
+		int base = tm.softLimitMs();
+		tm.onIterationComplete(kingPawn, 20);
+		tm.onIterationComplete(queenPawn, 20);
+		CHECK(tm.softLimitMs() > base);
+		for (int i = 0; i < 5; i++) tm.onIterationComplete(queenPawn, 20);
+		CHECK(tm.softLimitMs() < base);
+		CHECK(!tm.shouldStartIteration(base));
+	}
+	SUBCASE("Score drop grows the soft limit") {
+		TimeManager stable, dropping;
+		TimeControl tc;
+		tc.remainingMs = 60000;
+		stable.start(tc);
+		dropping.start(tc);
+		for (int i = 0; i < 3; i++) stable.onIterationComplete(kingPawn, 50);
+		dropping.onIterationComplete(kingPawn, 50);
+		dropping.onIterationComplete(kingPawn, 50);
+		dropping.onIterationComplete(kingPawn, -30);
+		CHECK(dropping.softLimitMs() > stable.softLimitMs());
+		CHECK(dropping.softLimitMs() <= dropping.hardLimitMs());
+	}
+	SUBCASE("Search under a clock stays inside the hard limit") {
+		Board b;
+		SearchContext ctx;
+		Moves topLine;
+		TimeControl tc;
+		tc.remainingMs = 2000;
+		auto start	   = SearchContext::Clock::now();
+		Eval::iterative_deepening_time(ctx, topLine, b, tc);
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(SearchContext::Clock::now() - start).count();
+		REQUIRE(!topLine.empty());
+		CHECK(elapsedMs < 2000);
+	}
+}
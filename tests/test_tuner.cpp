@@ -0,0 +1,77 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/eval.hpp"
+#include "../src/tuner.hpp"
+
+#include <cmath>
+#include <string>
+
+CUSTOM_TEST_CASE("Test Tuner") {
+	const char* fens[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"rnb2rk1/ppp2ppp/8/6NQ/8/3B4/PPP2PPP/RN3RK1 b - - 0 1",
+		"r1bq1rk1/pppp1ppp/2n2n2/2b1p3/2B1P1PP/2N2N2/PPPP1P2/R1BQ1RK1 b - - 0 1",
+		"8/5k2/8/8/3K4/8/4PP2/8 w - - 0 1",
+	};
+
+	SUBCASE("The trace adds up to the evaluation") {
+		Tuner tuner(2);
+		for (const char* fen : fens) {
+			Board b;
+			b.setToFen(fen);
+			EvalTrace trace;
+			Centipawns traced = Eval::trace(b, trace);
+			CHECK(traced == Eval::evaluate(b) * (b.boardState.sideToMove == WHITE ? 1 : -1));
+
+			REQUIRE(tuner.addPosition(std::string(fen) + " [0.5]"));
+			// the tuner tapers without rounding
+			CHECK(std::abs(tuner.evaluate(tuner.size() - 1) - traced) <= 1);
+		}
+	}
+	SUBCASE("Dataset lines") {
+		Tuner tuner(1);
+		CHECK(tuner.addPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [1.0]"));
+		CHECK(tuner.addPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -; 1/2-1/2"));
+		CHECK(tuner.addPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - c9 \"0-1\";"));
+		// no result, a board that doesnt add up, no kings, in check
+		CHECK(!tuner.addPosition("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+		CHECK(!tuner.addPosition("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - [1.0]"));
+		CHECK(!tuner.addPosition("8/8/8/8/8/8/8/8 w - - [0.0]"));
+		CHECK(!tuner.addPosition("4k3/8/8/8/8/8/8/r3K3 w - - [0.0]"));
+		CHECK(tuner.size() == 3);
+	}
+	SUBCASE("Tuning lowers the error") {
+		Tuner tuner(2);
+		// every game drawn, so the weights should move towards scoring everything equal
+		for (const char* fen : fens) REQUIRE(tuner.addPosition(std::string(fen) + " 1/2-1/2"));
+		double before = tuner.error(tuner.k());
+		std::ostringstream log;
+		tuner.tune(20, 2.0, log);
+		CHECK(tuner.error(tuner.k()) < before);
+		CHECK(log.str().find("epoch 20") != std::string::npos);
+	}
+	SUBCASE("Rewriting a header only touches the tuned tables") {
+		std::string header = "// pawnStorm = {} is in here too\ninline constexpr std::array<Centipawns, 5> pawnStorm  = {1, 2, 3, 4, 5};\n";
+		header += "inline constexpr std::array<PieceSquareTable, NONE_PIECE> mgPsqt = {{\n";
+		for (const char* piece : {"KING", "QUEEN", "ROOK", "BISHOP", "KNIGHT", "PAWN"}) {
+			header += "\t// " + std::string(piece) + "\n\t{0},\n";
+		}
+		header += "}};\ninline constexpr int MAX_PHASE = 24;\n";
+
+		Tuner tuner(1);
+		std::string rewritten = tuner.rewriteHeader(header);
+		CHECK(rewritten.find("// pawnStorm = {} is in here too\n") == 0);
+		CHECK(rewritten.find("pawnStorm  = {0, 5, 25, 15, 5};") != std::string::npos);
+		CHECK(rewritten.find("\t// KING\n\t{   8,   13,   -1,   -5,   -1,   -5,   13,   13,\n\t    0,   -3,") != std::string::npos);
+		CHECK(rewritten.find("\t// PAWN\n\t{   0,    0,") != std::string::npos);
+		CHECK(rewritten.find("MAX_PHASE = 24;") != std::string::npos);
+		// rewriting with the same weights changes nothing
+		CHECK(tuner.rewriteHeader(rewritten) == rewritten);
+	}
+}
@@ -0,0 +1,130 @@
+#include "../include/doctest.h"
+#include "custom_text_fixture.hpp"
+
+#include "../src/board.hpp"
+#include "../src/nnue.hpp"
+#include "../src/transposition_table.hpp"
+#include "../src/uci.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+CUSTOM_TEST_CASE("Test Uci") {
+	std::istringstream in;
+	std::ostringstream out;
+	Uci uci(in, out);
+
+	SUBCASE("Handshake") {
+		uci.handleCommand("uci");
+		uci.handleCommand("isready");
+		CHECK(out.str().find("id name Typhon") != std::string::npos);
+		CHECK(out.str().find("uciok") != std::string::npos);
+		CHECK(out.str().find("readyok") != std::string::npos);
+		CHECK(!uci.handleCommand("quit"));
+	}
+	SUBCASE("Searches the position after the given moves") {
+		uci.handleCommand("position startpos moves e2e4 e7e5 g1f3");
+		uci.handleCommand("go depth 3");
+		uci.waitForSearch();
+		std::string output = out.str();
+		size_t bestMovePos = output.find("bestmove ");
+		REQUIRE(bestMovePos != std::string::npos);
+		CHECK(output.find("info depth 3") != std::string::npos);
+
+		Board b;
+		for (const char* m : {"e2e4", "e7e5", "g1f3"}) {
+			b.execute(Uci::parseMove(b, m));
+		}
+		std::string bestMove;
+		std::istringstream(output.substr(bestMovePos + 9)) >> bestMove;
+		CHECK(Uci::parseMove(b, bestMove).getPieceType() != NONE_PIECE);
+	}
+	SUBCASE("Finds a mate from a fen") {
+		uci.handleCommand("position fen 6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+		uci.handleCommand("go depth 3");
+		uci.waitForSearch();
+		CHECK(out.str().find("score mate 1") != std::string::npos);
+		CHECK(out.str().find("bestmove d1d8") != std::string::npos);
+	}
+	SUBCASE("Infinite search waits for stop") {
+		uci.handleCommand("position fen 6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+		uci.handleCommand("go infinite");
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		uci.handleCommand("isready");
+		CHECK(out.str().find("readyok") != std::string::npos);
+		CHECK(out.str().find("bestmove") == std::string::npos);
+		uci.handleCommand("stop");
+		CHECK(out.str().find("bestmove d1d8") != std::string::npos);
+	}
+	SUBCASE("Ponder search ignores the clock until ponderhit") {
+		uci.handleCommand("position startpos moves e2e4 e7e5");
+		// a 3 second clock gives a hard limit of a few hundred milliseconds, which the ponder search has to outlive
+		uci.handleCommand("go ponder wtime 3000 btime 3000");
+		std::this_thread::sleep_for(std::chrono::milliseconds(600));
+		CHECK(out.str().find("bestmove") == std::string::npos);
+		auto ponderhit = std::chrono::steady_clock::now();
+		uci.handleCommand("ponderhit");
+		uci.waitForSearch();
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - ponderhit).count();
+		CHECK(elapsedMs < 1000);
+		CHECK(out.str().find("bestmove ") != std::string::npos);
+	}
+	SUBCASE("Deterministic mode still keeps to movetime") {
+		uci.handleCommand("setoption name Deterministic value true");
+		uci.handleCommand("position startpos moves e2e4 e7e5");
+		auto start = std::chrono::steady_clock::now();
+		uci.handleCommand("go movetime 100");
+		uci.waitForSearch();
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		CHECK(elapsedMs < 1000);
+		CHECK(out.str().find("info string searching on the clock") != std::string::npos);
+		CHECK(out.str().find("bestmove ") != std::string::npos);
+	}
+	SUBCASE("Bestmove suggests a move to ponder on") {
+		uci.handleCommand("position startpos");
+		uci.handleCommand("go depth 4");
+		uci.waitForSearch();
+		CHECK(out.str().find(" ponder ") != std::string::npos);
+	}
+	SUBCASE("MultiPV reports every line") {
+		uci.handleCommand("setoption name MultiPV value 3");
+		uci.handleCommand("position startpos");
+		uci.handleCommand("go depth 4");
+		uci.waitForSearch();
+		CHECK(out.str().find(" multipv 3 ") != std::string::npos);
+		CHECK(out.str().find("bestmove ") != std::string::npos);
+	}
+	SUBCASE("Hash resizes the shared table") {
+		uci.handleCommand("uci");
+		CHECK(out.str().find("option name Hash type spin default 8 min 1 max 4096") != std::string::npos);
+		uci.handleCommand("setoption name Hash value 16");
+		CHECK(out.str().find("info string Hash set to 16 MB") != std::string::npos);
+		CHECK(TranspositionTable::shared().sizeBytes() == 16 * 1024 * 1024 / sizeof(TTEntry) * sizeof(TTEntry));
+		uci.handleCommand("setoption name Hash value 0");
+		CHECK(out.str().find("info string Hash set to 1 MB") != std::string::npos);
+		uci.handleCommand("position startpos");
+		uci.handleCommand("go depth 4");
+		uci.waitForSearch();
+		CHECK(out.str().find("bestmove ") != std::string::npos);
+		uci.handleCommand("setoption name Hash value 8");
+		CHECK(TranspositionTable::shared().sizeBytes() == TT_SIZE_MB / sizeof(TTEntry) * sizeof(TTEntry));
+	}
+	SUBCASE("EvalFile keeps the handcrafted evaluation when the net cant be read") {
+		uci.handleCommand("setoption name EvalFile value does/not/exist.nnue");
+		CHECK(out.str().find("info string could not load net does/not/exist.nnue") != std::string::npos);
+		CHECK(!NNUE::isLoaded());
+	}
+	SUBCASE("Bench reports its node count") {
+		uci.handleCommand("bench 2");
+		CHECK(out.str().find("bench depth 2: ") != std::string::npos);
+	}
+	SUBCASE("Parses moves and scores") {
+		Board b;
+		CHECK(Uci::parseMove(b, "e2e4") == Move(b, e2, e4, PAWN));
+		CHECK(Uci::parseMove(b, "e2e5").getPieceType() == NONE_PIECE);
+		CHECK(UciSearchListener::formatScore(35, {}) == "cp 35");
+		CHECK(UciSearchListener::formatScore(INF_SCORE - 3, Moves(3)) == "mate 2");
+		CHECK(UciSearchListener::formatScore(-INF_SCORE + 4, Moves(4)) == "mate -2");
+	}
+}